@@ -9,6 +9,7 @@
 #include "web_functions/web_functions.hpp"
 #include "motor_control/motor.hpp"
 #include "motor_control/gantrymotor.hpp"
+#include "motor_control/axis_registry.hpp"
 
 class ApiRestServer {
     private:
@@ -16,18 +17,20 @@ class ApiRestServer {
         LoggingMiddleware _loggingMid;
         Settings* _settings;
         WebFunctions* _webFunctions;
-        Motor* _X1Motor;
-        Motor* _X2Motor;
-        GantryMotor* _XMotor;
+        AxisRegistry* _axes;
 
         String uriParam(const String& uri, uint8_t position);
         void setupSettingController();
         void setupWebFunctionController();
         void setupAxisLogController();
         void setupAxisInfoController();
+        void setupAxisSpectrumController();
+        void setupAxisPreviewController();
+        void setupBootProfileController();
+        void setupAxesMoveController();
 
         PBIOLogger* getMotorLoggerByName(const char* name);
 
     public:
-        void begin(Settings* settings, WebFunctions* webFunctions, Motor* x1Motor, Motor* x2Motor, GantryMotor* xMotor);
+        void begin(Settings* settings, WebFunctions* webFunctions, AxisRegistry* axes);
 };
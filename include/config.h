@@ -16,16 +16,47 @@
     #define IP_SUBNET     255, 255, 255, 0
     #define IP_DNS        192, 168, 0, 1
 #endif
+#define WIFI_CONNECT_POLL_MS    (100)   // Poll period of the WiFi connection status at startup
 
 // Motor configuration
 #define PBIO_CONFIG_SERVO_PERIOD_MS (3)
+#define PBIO_CONFIG_TRAJECTORY_FLOAT (false)   // Evaluate the reference position with int32/float math instead of int64
+#define PBIO_CONFIG_SERVO_IRAM (true)          // Place the pbio servo path of the update in IRAM, see PBIO_IRAM
 
+#define MOTOR_MCPWM_CLOCK_HZ (160000000)
 #define MOTOR_PWM_FREQUENCY (9000)
-#define MOTOR_PWM_RESOLUTION (12)
-#define MOTOR_PWM_MAX_VALUE ((1 << MOTOR_PWM_RESOLUTION) - 2)
+#define MOTOR_PWM_RESOLUTION (12)   // Minimum bits of duty in a PWM period
+
+// PWM of each axis
+#define X_AXIS_PWM_FREQUENCY    MOTOR_PWM_FREQUENCY
+#define X_AXIS_PWM_RESOLUTION   MOTOR_PWM_RESOLUTION
+#define L_AXIS_PWM_FREQUENCY    MOTOR_PWM_FREQUENCY
+#define L_AXIS_PWM_RESOLUTION   MOTOR_PWM_RESOLUTION
+#define R_AXIS_PWM_FREQUENCY    MOTOR_PWM_FREQUENCY
+#define R_AXIS_PWM_RESOLUTION   MOTOR_PWM_RESOLUTION
 
 #define ENCODER_COUNTS_PER_DEGREE (2)
 
+// Supply voltage compensation
+#define SUPPLY_VOLTAGE_COMPENSATION     (false) // Enable once the supply divider is fitted and checked
+#define SUPPLY_VOLTAGE_NOMINAL_MV       (9000)  // Supply voltage of the tuned controls and the identified models
+#define SUPPLY_VOLTAGE_MIN_MV           (5000)  // Below this the measure isn't trusted and the duty is not scaled
+#define SUPPLY_VOLTAGE_MAX_SCALE        (2)     // Maximum duty scale
+#define SUPPLY_VOLTAGE_DIVIDER          (11.0f) // Input divider ratio
+#define SUPPLY_VOLTAGE_ADC_SAMPLES      (4)
+#define SUPPLY_VOLTAGE_ADC_MAX_MV       (3100)  // Full scale of the ADC at 11 dB, a read at or beyond it is a failed conversion
+#define SUPPLY_VOLTAGE_ADC_SPREAD_MV    (100)   // Largest spread of the conversions of a sample, at the pin
+#define SUPPLY_VOLTAGE_SAMPLE_PERIOD_MS (20)
+#define SUPPLY_VOLTAGE_FILTER_DIV       (8)     // Low pass filter time constant, in samples
+
+// Warm boot position restore
+#define WARM_BOOT_RESTORE               (true)
+#define WARM_BOOT_STILL_MS              (300)   // Encoder observation at boot, the axis must not move meanwhile
+#define WARM_BOOT_MOTION_TOLERANCE      (2)     // Largest encoder change at boot still taken as no motion (count)
+#define WARM_BOOT_MAX_HOLD_DUTY         (15.0f) // Highest duty to hold the saved position, above it the axis could move while the motors coast (%)
+#define WARM_BOOT_LIMIT_MARGIN          (5.0f)  // Largest distance of the restored position beyond the software limits (deg)
+#define WARM_BOOT_MAX_RESTORES          (3)     // Consecutive restores before a homing is required again
+
 // Log
 #define MAX_LOG_MEM_KB 8*1024 // 8 MB on ESP32-S3-WROOM-1-N16R8
 
@@ -34,6 +65,7 @@
 #define OTHER_TASK_CORE             (1)
 #define MOTION_TASK_PRIORITY        (configMAX_PRIORITIES - 1)
 #define OTHER_TASK_PRIORITY         (0)
+#define AXIS_EVENT_REPORT_MS        (450)   // Period of the axis events report, off the motor core
 #define OTHER_TASK_HIGH_PRIORITY    (10)
 
 // Scrolling text animation speed
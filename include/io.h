@@ -33,6 +33,10 @@
 #define I2C_BUS_2_SDA           41
 #define I2C_BUS_2_SCL           42
 
+// Supply voltage divider, on an ADC1 pin: ADC2 can't be read while WiFi runs.
+// The board has no divider yet, define the pin to enable the supply voltage measure
+//#define SUPPLY_VOLTAGE_ADC_PIN
+
 #define BOARD_LED_OUTPUT        38
 #define START_BUTTON_PIN        43
 #define START_BUTTON_LED_PIN    44
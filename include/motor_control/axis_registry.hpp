@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/motor.hpp"
+#include "motor_control/gantrymotor.hpp"
+#include "motor_control/logger.hpp"
+
+#define AXIS_REGISTRY_MAX_AXES (4)
+
+// Events of the coordinated move group
+#define AXIS_GROUP_EVENT_DONE       (1 << 0)    // All the axes of the group completed their move
+#define AXIS_GROUP_EVENT_ERROR      (1 << 1)    // One of the axes reported an error
+#define AXIS_GROUP_EVENT_CANCEL     (1 << 2)    // The cancel token of a waiting task was cancelled
+
+/**
+ * Axis driven by the servo loop: either a single motor or a gantry of two motors
+ */
+typedef struct _axis_registry_entry_t {
+    const char* name;           /**< Axis name used by the API */
+    Motor* motor;               /**< Motor of a single motor axis, nullptr for a gantry */
+    GantryMotor* gantry;        /**< Gantry axis, nullptr for a single motor axis */
+    uint32_t update_us;         /**< Duration of the last update (us) */
+    uint32_t update_max_us;     /**< Longest update since the last reset (us) */
+} axis_registry_entry_t;
+
+class AxisRegistry {
+    private:
+        axis_registry_entry_t _axes[AXIS_REGISTRY_MAX_AXES];
+        uint8_t _count = 0;
+        uint32_t _cycle_us = 0;
+        uint32_t _cycle_max_us = 0;
+
+        // Coordinated move group, shared with the servo loop under _groupMux
+        mutable portMUX_TYPE _groupMux = portMUX_INITIALIZER_UNLOCKED;
+        EventGroupHandle_t _groupEvents = xEventGroupCreate();
+        bool _groupActive = false;
+        uint8_t _groupCount = 0;
+        uint8_t _groupAxes[AXIS_REGISTRY_MAX_AXES];
+        pbio_error_t _groupStatus = PBIO_SUCCESS;
+
+        bool add(const char* name, Motor* motor, GantryMotor* gantry);
+        void updateGroup();
+        void stopGroup(bool hold);
+
+    public:
+        bool add(const char* name, Motor& motor);
+        bool add(const char* name, GantryMotor& gantry);
+
+        void update();
+        void resetTimings();
+
+        uint8_t count() const {
+            return _count;
+        }
+
+        const axis_registry_entry_t& get(uint8_t index) const {
+            return _axes[index];
+        }
+
+        /**
+        Duration of the last update of all the axes (us)
+        */
+        uint32_t cycleTime() const {
+            return _cycle_us;
+        }
+
+        /**
+        Longest update of all the axes since the last reset (us)
+        */
+        uint32_t cycleMaxTime() const {
+            return _cycle_max_us;
+        }
+
+        const axis_registry_entry_t* find(const char* name) const;
+        PBIOLogger* findLogger(const char* name) const;
+        uint32_t collisionCount(uint8_t index) const;
+        uint32_t envelopeViolations(uint8_t index) const;
+
+        pbio_error_t run_targets(uint8_t count, const char* const names[], const float targets[], float speed, pbio_actuation_t then = PBIO_ACTUATION_HOLD, bool wait = true, CancelToken* cancel_token = nullptr);
+        pbio_error_t wait_for_group(CancelToken* cancel_token, uint32_t timeout_ms = MOTOR_WAIT_FOREVER);
+        bool is_group_completion() const;
+};
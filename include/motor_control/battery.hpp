@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Duty scale that leaves the duty unchanged (16.16 fixed point)
+#define PBIO_BATTERY_SCALE_ONE (1 << 16)
+
+/**
+ * Supply voltage compensation
+ *
+ * The controllers and the plant model work in duty at the nominal supply voltage, so a
+ * duty step is a fixed fraction of the nominal voltage. The measured supply is sampled and
+ * filtered by a task on the application core, and the duty applied to the motors is scaled by the ratio
+ * between the nominal and the measured voltage. A drained battery then gives the same
+ * motor voltage, and the same motion, as a charged one.
+ */
+
+void pbio_battery_begin(uint8_t adc_pin);
+int32_t pbio_battery_get_voltage_now();
+uint32_t pbio_battery_get_duty_scale();
+bool pbio_battery_get_compensation();
+void pbio_battery_set_compensation(bool enabled);
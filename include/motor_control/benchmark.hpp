@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/trajectory.hpp"
+
+#define PBIO_BENCHMARK_SAMPLES (2000)           // Evaluations of each trajectory over its full range
+#define PBIO_BENCHMARK_REBASE_MS (10000)        // Time evaluated on each side of the rebase of a trajectory
+
+/**
+ * Comparison of the trajectory evaluators against the int64 reference
+ */
+typedef struct _pbio_benchmark_result_t {
+    int32_t position_error;         /**< Largest position difference of the float evaluator (millicount) */
+    int32_t rate_error;             /**< Largest speed difference of the float evaluator (count/s) */
+    int32_t rebase_error;           /**< Largest position difference across the rebase of the reference in use (millicount) */
+    uint32_t cycles_int64;          /**< Mean CPU cycles of an int64 evaluation */
+    uint32_t cycles_float;          /**< Mean CPU cycles of a float evaluation */
+} pbio_benchmark_result_t;
+
+void pbio_benchmark_trajectory(pbio_benchmark_result_t *result);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/enums.h"
+#include "motor_control/error.hpp"
+#include "motor_control/controlsettings.h"
+
+// Defaults applied at setup. The detector is off until the plant model is identified
+#define PBIO_COLLISION_DEFAULT_THRESHOLD (40.0f)    // Speed residual (deg/s)
+#define PBIO_COLLISION_DEFAULT_TICKS (3)
+#define PBIO_COLLISION_MAX_TICKS (50)
+
+/**
+ * Collision detector settings
+ */
+typedef struct _pbio_collision_settings_t {
+    bool enabled;                   /**< Run the detector. It also needs an identified plant model */
+    int32_t threshold;              /**< Speed residual that flags an obstruction (counts/s) */
+    uint8_t ticks;                  /**< Consecutive control periods over the threshold before the obstruction is flagged */
+    pbio_actuation_t reaction;      /**< How to stop the motor on an obstruction: coast, brake or hold */
+} pbio_collision_settings_t;
+
+/**
+ * Model based collision detector
+ *
+ * The plant model runs alongside the motor, driven by the applied duty. While the measured
+ * speed agrees with the model, the model is realigned to the measure at every period. When
+ * the motor is slower than the model by more than the threshold for a few periods in a row
+ * something is blocking it.
+ */
+typedef struct _pbio_collision_t {
+    pbio_collision_settings_t settings;
+    bool primed;                    /**< The model state is valid */
+    int32_t time_prev;              /**< Time of the previous update (us) */
+    int32_t control_prev;           /**< Duty applied at the previous update (duty steps) */
+    float rate_model;               /**< Speed predicted by the model (counts/s) */
+    uint8_t count;                  /**< Consecutive periods over the threshold */
+    bool detected;                  /**< Latched on an obstruction, until the next maneuver */
+    int32_t residual;               /**< Residual at the last detection (counts/s) */
+    uint32_t detections;            /**< Number of obstructions detected since power-up */
+} pbio_collision_t;
+
+void pbio_collision_setup(pbio_collision_t *col, const pbio_control_settings_t *s);
+void pbio_collision_reset(pbio_collision_t *col);
+void pbio_collision_flag(pbio_collision_t *col, int32_t residual);
+bool pbio_collision_update(pbio_collision_t *col, const pbio_control_settings_t *s, int32_t time_now, int32_t rate_now, pbio_actuation_t actuation, int32_t control);
+
+void pbio_collision_get_settings(const pbio_collision_t *col, const pbio_control_settings_t *s, bool *enabled, float *threshold, uint8_t *ticks, pbio_actuation_t *reaction);
+pbio_error_t pbio_collision_set_settings(pbio_collision_t *col, const pbio_control_settings_t *s, bool enabled, float threshold, uint8_t ticks, pbio_actuation_t reaction);
@@ -7,4 +7,4 @@
 #define MOTOR_MAX_CONTROL (10000)
 
 // Log
-#define SERVO_LOG_NUM_VALUES 11
+#define SERVO_LOG_NUM_VALUES 13
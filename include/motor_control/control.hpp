@@ -11,21 +11,19 @@
 #include "motor_control/controlsettings.h"
 #include "motor_control/trajectory.hpp"
 #include "motor_control/integrator.hpp"
+#include "motor_control/observer.hpp"
+#include "motor_control/lqr.hpp"
+#include "motor_control/shaper.hpp"
+#include "motor_control/tracker.hpp"
 
-// Maneuver-specific function that returns true if maneuver is done, based on current state
-typedef bool (*pbio_control_on_target_t)(pbio_trajectory_t *trajectory,
-                                         pbio_control_settings_t *settings,
-                                         int32_t time,
-                                         int32_t count,
-                                         int32_t rate,
-                                         bool stalled);
-
-// Functions to check whether motion is done
-extern pbio_control_on_target_t pbio_control_on_target_always;
-extern pbio_control_on_target_t pbio_control_on_target_never;
-extern pbio_control_on_target_t pbio_control_on_target_angle;
-extern pbio_control_on_target_t pbio_control_on_target_time;
-extern pbio_control_on_target_t pbio_control_on_target_stalled;
+// Maneuver-specific condition that makes the maneuver done, based on current state
+typedef enum {
+    PBIO_CONTROL_ON_TARGET_ALWAYS,   /**< Done right away */
+    PBIO_CONTROL_ON_TARGET_NEVER,    /**< Never done, runs until stopped */
+    PBIO_CONTROL_ON_TARGET_ANGLE,    /**< Done on the trajectory angle (th3), standing still */
+    PBIO_CONTROL_ON_TARGET_TIME,     /**< Done when the trajectory time (t3) is elapsed */
+    PBIO_CONTROL_ON_TARGET_STALLED,  /**< Done when the motor is stalled */
+} pbio_control_on_target_t;
 
 typedef enum {
     PBIO_CONTROL_NONE,   /**< No control */
@@ -40,7 +38,15 @@ typedef struct _pbio_control_t {
     pbio_trajectory_t trajectory;
     pbio_rate_integrator_t rate_integrator;
     pbio_count_integrator_t count_integrator;
-    pbio_control_on_target_t on_target_func;
+    pbio_control_on_target_t on_target_type;
+    pbio_control_gains_t gains;     // Gains in use, selected on the direction of motion
+    int8_t gains_direction;         // Direction of the gains in use, zero when not selected yet
+    int8_t lead_direction;          // Direction of motion of the axis this one follows while holding a moving target, zero if none
+    int8_t ref_direction;           // Direction of motion used at the last update, from the reference speed or the lead direction
+    pbio_observer_t observer;       // Disturbance observer, its estimate is added to the control
+    pbio_lqr_t lqr;                 // State feedback, replaces the PID terms when enabled
+    pbio_shaper_t shaper;           // Input shaper of the angle control reference
+    pbio_tracker_t tracker;         // Setpoint filter of a tracked target
     bool stalled;
     bool on_target;
 } pbio_control_t;
@@ -61,14 +67,30 @@ pbio_error_t pbio_control_settings_set_target_tolerances(pbio_control_settings_t
 void pbio_control_settings_get_stall_tolerances(const pbio_control_settings_t *s,  float *speed, int32_t *time);
 pbio_error_t pbio_control_settings_set_stall_tolerances(pbio_control_settings_t *s, float speed, int32_t time);
 
+void pbio_control_settings_get_model(const pbio_control_settings_t *s, float *gain_pos, float *gain_neg, float *time_constant_pos, float *time_constant_neg, float *coulomb, float *viscous, float *gravity);
+pbio_error_t pbio_control_settings_set_model(pbio_control_settings_t *s, float gain_pos, float gain_neg, float time_constant_pos, float time_constant_neg, float coulomb, float viscous, float gravity);
+bool pbio_control_settings_has_model(const pbio_control_settings_t *s);
+
+void pbio_control_settings_get_ff_table(const pbio_control_settings_t *s, pbio_control_ff_table_t *table);
+pbio_error_t pbio_control_settings_set_ff_table(pbio_control_settings_t *s, const pbio_control_ff_table_t *table);
+int32_t pbio_control_settings_get_feedforward(const pbio_control_settings_t *s, int32_t count, int32_t rate);
+
+void pbio_control_settings_get_gains_neg(const pbio_control_settings_t *s, int16_t *pid_kp, int16_t *pid_ki, int16_t *pid_kd, float *acceleration, float *max_windup_factor);
+pbio_error_t pbio_control_settings_set_gains_neg(pbio_control_settings_t *s, int16_t pid_kp, int16_t pid_ki, int16_t pid_kd, float acceleration, float max_windup_factor);
+void pbio_control_settings_set_gain_scheduling(pbio_control_settings_t *s, bool enable);
+void pbio_control_settings_get_gains(const pbio_control_settings_t *s, int32_t direction, pbio_control_gains_t *gains);
+int32_t pbio_control_settings_get_abs_acceleration(const pbio_control_settings_t *s, int32_t direction);
+
 int32_t pbio_control_settings_get_max_integrator(const pbio_control_settings_t *s);
 int32_t pbio_control_get_ref_time(const pbio_control_t *ctl, int32_t time_now);
+void pbio_control_get_reference(pbio_control_t *ctl, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref);
 
 void pbio_control_stop(pbio_control_t *ctl);
 pbio_error_t pbio_control_start_angle_control(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t target_count, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_actuation_t after_stop);
 pbio_error_t pbio_control_start_relative_angle_control(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t relative_target_count, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_actuation_t after_stop);
-pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, int32_t time_now, int32_t duration, int32_t count_now, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_control_on_target_t stop_func, pbio_actuation_t after_stop);
+pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, int32_t time_now, int32_t duration, int32_t count_now, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_control_on_target_t stop_type, pbio_actuation_t after_stop);
 void pbio_control_start_hold_control(pbio_control_t *ctl, int32_t time_now, int32_t target_count);
+void pbio_control_start_track_control(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t rate_now, int32_t target_count);
 
 bool pbio_control_is_stalled(pbio_control_t *ctl);
 bool pbio_control_is_done(pbio_control_t *ctl);
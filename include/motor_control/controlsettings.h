@@ -3,6 +3,40 @@
 #include <Arduino.h>
 #include "const.h"
 
+/**
+ * Identified plant model from duty to speed, per direction of motion (index 0 positive, 1 negative)
+ */
+typedef struct _pbio_control_model_t {
+    float gain[2];                  /**< Steady state speed per duty step above the friction offset (counts/s per duty step). Zero if the model is not identified */
+    float time_constant[2];         /**< Time constant of the speed response (s) */
+    float coulomb;                  /**< Duty needed to overcome the Coulomb friction (duty steps) */
+    float viscous;                  /**< Duty needed to overcome the viscous friction per unit of speed (duty steps per count/s) */
+    float gravity;                  /**< Duty needed to hold the axis against gravity (duty steps) */
+} pbio_control_model_t;
+
+/**
+ * Control gains that can be scheduled on the direction of motion
+ */
+typedef struct _pbio_control_gains_t {
+    int16_t pid_kp;                 /**< Proportional position control constant */
+    int16_t pid_ki;                 /**< Integral position control constant */
+    int16_t pid_kd;                 /**< Derivative position control constant */
+    int32_t abs_acceleration;       /**< Encoder acceleration/deceleration rate (counts/s^2) */
+    float max_windup_factor;        /**< Factor to limit/increase the integrator max windup */
+} pbio_control_gains_t;
+
+// Number of points of the position indexed feedforward table
+#define PBIO_CONTROL_FF_TABLE_POINTS (32)
+
+/**
+ * Position indexed feedforward table, per direction of motion (index 0 positive, 1 negative)
+ */
+typedef struct _pbio_control_ff_table_t {
+    int32_t count_start;            /**< Position of the first point (count) */
+    int32_t count_step;             /**< Distance between two points (count). Zero if the table is not calibrated */
+    int16_t duty[2][PBIO_CONTROL_FF_TABLE_POINTS]; /**< Duty needed to move through each point (duty steps) */
+} pbio_control_ff_table_t;
+
 /**
  * Control settings
  */
@@ -23,6 +57,10 @@ typedef struct _pbio_control_settings_t {
     int32_t integral_range;         /**< Region around the target count in which integral errors are accumulated */
     int32_t integral_rate;          /**< Maximum rate at which the integrator is allowed to increase */
     float max_windup_factor;        /**< Factor to limit/increase the integrator max windup. 1 means default windup. A value < 1 reduces windup, while a value > 1 increases it. */
+    pbio_control_model_t model;     /**< Identified plant model */
+    pbio_control_ff_table_t ff_table; /**< Position indexed feedforward. When calibrated it replaces the control offset */
+    bool gain_scheduling;           /**< Use gains_neg, instead of the gains above, while moving in negative direction */
+    pbio_control_gains_t gains_neg; /**< Gains used while moving in negative direction */
 } pbio_control_settings_t;
 
 static pbio_control_settings_t settings_servo_ev3_medium = {
@@ -1,10 +1,11 @@
 #pragma once
 
 #include <Arduino.h>
-#include <driver/ledc.h>
+#include <driver/mcpwm_prelude.h>
 #include "const.h"
 #include "config.h"
 #include "enums.h"
+#include "battery.hpp"
 
 typedef enum {
     PBIO_DCMOTOR_COAST,               /**< dcmotor set to coast */
@@ -12,20 +13,57 @@ typedef enum {
     PBIO_DCMOTOR_DUTY_PASSIVE,        /**< dcmotor set to constant duty. */
 } pbio_passivity_t;
 
+/**
+ * Output stage of the H-bridge, as driven on the two pins
+ */
+typedef enum {
+    DCMOTOR_OUTPUT_NONE,              /**< Not configured yet */
+    DCMOTOR_OUTPUT_COAST,             /**< Both pins low */
+    DCMOTOR_OUTPUT_BRAKE,             /**< Both pins high */
+    DCMOTOR_OUTPUT_FORWARD,           /**< PWM on pin 1, pin 2 low */
+    DCMOTOR_OUTPUT_BACKWARD,          /**< Pin 1 low, PWM on pin 2 */
+} dcmotor_output_t;
+
+/**
+ * H-bridge driver on one MCPWM operator
+ *
+ * Both pins are generators of the same operator, sharing one timer and one comparator. The
+ * PWM pin goes high at the start of the period and low on the compare value, the other pin
+ * is forced low. The compare value is buffered and latched when the timer restarts from zero,
+ * so a new duty never cuts a period short. Registers are written only when the output stage
+ * or the compare value change.
+ */
 class DCMotor {
     public:
-        void begin(uint8_t pwmPin1, uint8_t pwmPin2, pbio_direction_t direction, uint16_t userPwmMax);
+        void begin(uint8_t pwmPin1, uint8_t pwmPin2, pbio_direction_t direction, uint16_t userPwmMax,
+            uint32_t frequency = MOTOR_PWM_FREQUENCY, uint8_t resolution = MOTOR_PWM_RESOLUTION);
         void getState(pbio_passivity_t *state, int32_t *duty_now) const;
         uint16_t getUserPwmMax();
+        uint32_t getPeriodTicks() const {
+            return _periodTicks;
+        }
         void coast();
         void brake();
-        void set_duty_cycle(int32_t duty_steps);
-        
+        void set_duty_cycle(int32_t duty_steps, uint32_t scale = PBIO_BATTERY_SCALE_ONE);
+
     private:
-        uint8_t _pwmPin1;
-        uint8_t _pwmPin2;
+        static uint8_t _instances;
+
+        mcpwm_timer_handle_t _timer = nullptr;
+        mcpwm_oper_handle_t _operator = nullptr;
+        mcpwm_cmpr_handle_t _comparator = nullptr;
+        mcpwm_gen_handle_t _gen1 = nullptr;
+        mcpwm_gen_handle_t _gen2 = nullptr;
+
         uint16_t _userPwmMax;
+        uint32_t _periodTicks;
+        uint32_t _dutyScale;          // Timer ticks per duty step (16.16 fixed point)
+        uint32_t _cmpTicks;
+        dcmotor_output_t _output;
         int32_t _duty_now;
         pbio_direction_t _direction;
         pbio_passivity_t _state;
+
+        void setOutput(dcmotor_output_t output);
+        void setCompare(uint32_t ticks);
 };
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/error.hpp"
+#include "motor_control/control.hpp"
+
+// Control periods of reaction added to the braking distance: the brake starts on the next update
+#define PBIO_ENVELOPE_MARGIN_TICKS (2)
+
+/**
+ * Software limits enforced by the servo loop
+ *
+ * While the motor moves towards a limit, the distance it needs to stop at the acceleration limit
+ * is compared with the distance left to the limit. When it doesn't fit anymore the maneuver is
+ * replaced by a braking trajectory that stops on the limit:
+ *
+ *   v^2 / (2 * a) + |v| * margin >= |limit - x|
+ *
+ * Angle maneuvers that end within the limits are left alone, they stay within by construction.
+ * Running until stalled is left alone too, the obstacle is the expected end of the maneuver.
+ */
+typedef struct _pbio_envelope_t {
+    bool enabled;                   /**< Enforce the limits */
+    bool armed;                     /**< The position frame is referenced, so the limits are meaningful */
+    int32_t count_min;              /**< Lower limit (count) */
+    int32_t count_max;              /**< Upper limit (count) */
+    uint32_t violations;            /**< Number of maneuvers braked on a limit since power-up */
+    int32_t violation_count;        /**< Position at the last violation (count) */
+    int32_t violation_rate;         /**< Speed at the last violation (count/s) */
+} pbio_envelope_t;
+
+void pbio_envelope_setup(pbio_envelope_t *env);
+void pbio_envelope_set_limits(pbio_envelope_t *env, int32_t count_min, int32_t count_max);
+void pbio_envelope_arm(pbio_envelope_t *env, bool armed);
+bool pbio_envelope_is_active(const pbio_envelope_t *env);
+int32_t pbio_envelope_clamp(const pbio_envelope_t *env, int32_t count);
+bool pbio_envelope_update(pbio_envelope_t *env, const pbio_control_t *ctl, int32_t count_now, int32_t rate_now, int32_t *count_limit);
@@ -23,7 +23,8 @@ typedef enum {
     PBIO_ERROR_TIMEDOUT,        /**< The operation has timed out */
     PBIO_ERROR_CANCELED,        /**< The operation was canceled */
     PBIO_ERROR_TACHO_SEQUENCE,  /**< Encoder sequence counting error */
-    PBIO_ERROR_HOME_SWITCH_ERR  /**< Home switch sequence error */
+    PBIO_ERROR_HOME_SWITCH_ERR, /**< Home switch sequence error */
+    PBIO_ERROR_COLLISION        /**< The motion was stopped by an obstruction */
 } pbio_error_t;
 
 const char *pbio_error_str(pbio_error_t err);
@@ -2,7 +2,17 @@
 
 #include <Arduino.h>
 #include "motor.hpp"
+#include "motorwithstallreference.hpp"
 #include "motor_control/logger.hpp"
+#include "utils/cancel_token.hpp"
+
+#define GANTRY_SKEW_LEARN_MAX_SPEED     (50.0f)     // Maximum axis speed at which the skew is learned (deg/s)
+#define GANTRY_SKEW_HOLD_SPEED          (2.0f)      // Axis speed below which the axis holds, for the effort balance (deg/s)
+#define GANTRY_SKEW_BALANCE_TICKS       (300)       // Control periods averaged after homing into the effort balance of each direction
+#define GANTRY_SKEW_EFFORT_DEADBAND     (2.0f)      // Change of the effort balance below which the frame is taken as square (%)
+#define GANTRY_SKEW_COMPLIANCE          (0.1f)      // Skew change per duty difference between the motors, sets the learning step (deg/%)
+#define GANTRY_SKEW_STORE_THRESHOLD     (0.5f)      // Minimum learned skew change before it is worth storing in NVS (deg)
+#define GANTRY_STALL_HOMING_TIMEOUT_MS  (15000)     // Longest run of the two motors toward the reference obstacle
 
 class GantryMotor {
     private:
@@ -10,7 +20,26 @@ class GantryMotor {
         Motor& _motor1;
         Motor& _motor2;
         float _skew_pos_compensation; // Position correction to apply at the second motor to compensate the gantry skew (motor units)
+        float _skew_homed = 0.0f; // Skew compensation referred to the homed reference, applied when the axis is homed
+        float _skew_stored = 0.0f; // Last homed skew stored in NVS
+        bool _skew_learning = true;
+        float _skew_learn_time = 5.0f; // Skew estimator time constant (s)
+        float _skew_alarm_threshold = 5.0f; // Maximum allowed deviation between the measured and the compensated skew (deg)
+        bool _skew_alarm = false;
         bool _referenced = false;
+        bool _open_loop = false; // Motor 1 is driven with a constant duty cycle that motor 2 mirrors
+        bool _homing = false; // The two motors run their own maneuvers, motor 2 doesn't follow motor 1
+        uint32_t _motor2_collisions = 0; // Obstructions detected by motor 2 and already propagated to motor 1
+        bool _motor2_collision_latched = false; // Motor 2 keeps an obstruction latched until motor 1 starts a new maneuver
+
+        // Duty difference between the motors with the frame square, while holding, moving forward and backward (%).
+        // Averaged right after the homing, it takes in the load and friction differences between the two sides
+        float _skew_balance[3] = {};
+        uint16_t _skew_balance_ticks[3] = {};
+
+        void learn_skew();
+        pbio_error_t run_until_both_stalled(float speed, CancelToken& cancel_token);
+        pbio_error_t retract_both(float speed, float angle, CancelToken& cancel_token);
 
     public:
         GantryMotor(Motor& motor1, Motor& motor2)
@@ -39,17 +68,121 @@ class GantryMotor {
             _skew_pos_compensation = compensation;
         }
 
+        /**
+        Gets the skew compensation referred to the homed reference.
+
+        The encoders are incremental and the motors coast while powered off, so a skew referred to
+        the encoder positions at power-up means nothing at the next power-up. The homed skew is
+        stored instead, and applied only once the axis is homed again
+        */
+        float getHomedSkew() const {
+            return _referenced ? _skew_pos_compensation : _skew_homed;
+        }
+
+        void setHomedSkew(float skew) {
+            _skew_homed = skew;
+            _skew_stored = skew;
+            if (_referenced) {
+                _skew_pos_compensation = skew;
+            }
+        }
+
+        bool getSkewLearning() const {
+            return _skew_learning;
+        }
+
+        void setSkewLearning(bool enable) {
+            _skew_learning = enable;
+        }
+
+        float getSkewLearnTime() const {
+            return _skew_learn_time;
+        }
+
+        void setSkewLearnTime(float time) {
+            _skew_learn_time = time;
+        }
+
+        float getSkewAlarmThreshold() const {
+            return _skew_alarm_threshold;
+        }
+
+        void setSkewAlarmThreshold(float threshold) {
+            _skew_alarm_threshold = threshold;
+        }
+
+        /**
+        Gets the gantry skew measured from the two motor positions (deg)
+        */
+        float getMeasuredSkew() const {
+            return _motor2.angle() - _motor1.angle();
+        }
+
+        /**
+        True when the measured skew differs from the compensated one more than the alarm threshold
+        */
+        bool skewAlarm() const {
+            return _skew_alarm;
+        }
+
+        /**
+        True when the learned skew drifted enough from the value stored in NVS
+        */
+        bool skewNeedsStore() const {
+            return _referenced && fabsf(_skew_pos_compensation - _skew_stored) >= GANTRY_SKEW_STORE_THRESHOLD;
+        }
+
+        void markSkewStored() {
+            _skew_homed = _skew_pos_compensation;
+            _skew_stored = _skew_pos_compensation;
+        }
+
+        /**
+        Number of obstructions that stopped the axis since power-up
+        */
+        uint32_t collisionCount() const {
+            return _motor1.collision_count();
+        }
+
+        /**
+        Speed residual of the last obstruction that stopped the axis (deg/s)
+        */
+        float collisionResidual() const {
+            return _motor1.collision_residual();
+        }
+
         virtual bool referenced() const {
             return _referenced;
         }
 
+        /**
+        Arms the software limits of the axis. They are enforced on motor 1, motor 2 follows it
+        */
+        void armEnvelope(bool armed) {
+            _motor1.arm_envelope(armed);
+        }
+
+        bool envelopeArmed() const {
+            return _motor1.envelope_armed();
+        }
+
+        uint32_t envelopeViolations() const {
+            return _motor1.envelope_violations();
+        }
+
+        void getEnvelopeViolation(float *angle, float *speed) const {
+            _motor1.get_envelope_violation(angle, speed);
+        }
+
         float angle() const;
         float speed() const;
         void reset_angle(float angle);
+        void restore_angles(float angle1, float angle2, float skew_compensation);
 
         void stop();
         void brake();
         void hold();
+        void dc(float duty);
 
         /**
         Runs the motor at a constant speed.
@@ -59,6 +192,7 @@ class GantryMotor {
         :param speed: Speed of the motor in deg/s
         */        
         pbio_error_t run(float speed) {
+            _open_loop = false;
             return _motor1.run(speed);
         }
 
@@ -73,20 +207,47 @@ class GantryMotor {
         :param wait: Wait for the maneuver to complete before continuing with the rest of the program
         */
         pbio_error_t run_target(float speed, float target_angle, pbio_actuation_t then = PBIO_ACTUATION_HOLD, bool wait = true, CancelToken* cancel_token = nullptr) {
+            _open_loop = false;
             return _motor1.run_target(speed, target_angle, then, wait, cancel_token);
         }
 
+        /**
+        Runs the motor towards a given target angle with the given speed and acceleration profile.
+
+        :param speed: Speed of the motor in deg/s
+        :param acceleration: Acceleration/deceleration in deg/s^2, capped by the acceleration limit. Zero to use the limit
+        :param target_angle: Angle that the motor should rotate to in deg
+        :param then: What to do after coming to a standstill
+        :param wait: Wait for the maneuver to complete before continuing with the rest of the program
+        */
+        pbio_error_t run_target_profile(float speed, float acceleration, float target_angle, pbio_actuation_t then = PBIO_ACTUATION_HOLD, bool wait = true, CancelToken* cancel_token = nullptr) {
+            _open_loop = false;
+            return _motor1.run_target_profile(speed, acceleration, target_angle, then, wait, cancel_token);
+        }
+
+        /**
+        Motor that runs the maneuvers of the axis, motor 2 follows it. Used to start coordinated
+        moves, so motor 2 stops mirroring an open loop command
+        */
+        Motor& leadMotor() {
+            _open_loop = false;
+            return _motor1;
+        }
+
         /** 
         Tracks a target angle. 
 
-        This is similar to run_target(), but the usual smooth acceleration is skipped: it will move 
-        to the target angle as fast as possible. This method is useful if you want to continuously 
-        change the target angle.
+        This is similar to run_target(), but without a planned trajectory. With smoothing, the motor
+        follows the target within the speed and acceleration limits, without stepping when the target
+        changes. Without it, the motor moves to the target angle as fast as possible. This method is
+        useful if you want to continuously change the target angle.
 
         :param target_angle: Target angle that the motor should rotate to in deg
+        :param smooth: Follow the target within the speed and acceleration limits
         */
-        void track_target(float target_angle) {
-            _motor1.track_target(target_angle);
+        void track_target(float target_angle, bool smooth = false) {
+            _open_loop = false;
+            _motor1.track_target(target_angle, smooth);
         }
 
         /**
@@ -128,6 +289,8 @@ class GantryMotor {
             return _motor1.get_actuation_limit();
         }
 
+        pbio_error_t run_stall_homing(const stall_homing_config_t& config, CancelToken& cancel_token);
+
         void update();
         
         PBIOLogger* get_logger() {
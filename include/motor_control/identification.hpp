@@ -0,0 +1,22 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/controlsettings.h"
+#include "motor_control/error.hpp"
+
+// Minimum number of samples needed to fit the model of one direction
+#define PBIO_IDENTIFICATION_MIN_SAMPLES (100)
+
+/**
+ * Least squares accumulator for the discrete speed model: rate[k+1] = a*rate[k] + b*duty[k] + c
+ */
+typedef struct _pbio_identification_t {
+    double xx[3][3];    /**< Sum of the regressor outer products */
+    double xy[3];       /**< Sum of the regressors times the next rate */
+    uint32_t samples;   /**< Number of accumulated samples */
+} pbio_identification_t;
+
+void pbio_identification_reset(pbio_identification_t *id);
+void pbio_identification_add_sample(pbio_identification_t *id, int32_t rate_now, int32_t duty_now, int32_t rate_next);
+pbio_error_t pbio_identification_solve(const pbio_identification_t *id, int32_t period_us, float *gain, float *time_constant, float *offset);
+pbio_error_t pbio_identification_make_model(const pbio_identification_t *id_pos, const pbio_identification_t *id_neg, int32_t period_us, pbio_control_model_t *model);
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/error.hpp"
+#include "motor_control/controlsettings.h"
+#include "motor_control/shaper.hpp"
+
+// Length of the correction table, in control periods. It covers the maneuver and the settling tail
+#define PBIO_ILC_MAX_TICKS (1024)
+#define PBIO_ILC_TAIL_MS (300)                  // Settling time learned after the end of the trajectory
+
+// Defaults applied at setup
+#define PBIO_ILC_DEFAULT_GAIN (0.3f)
+#define PBIO_ILC_DEFAULT_LEAD_MS (15)
+#define PBIO_ILC_MAX_LEAD_MS (200)
+
+#define PBIO_ILC_MIN_ITERATIONS (3)             // Iterations before the table may be considered converged
+#define PBIO_ILC_CONVERGED_IMPROVEMENT (0.05f)  // Relative error improvement below which the learning has converged
+#define PBIO_ILC_STORE_IMPROVEMENT (0.1f)       // Relative error improvement over the stored table to store it again
+#define PBIO_ILC_DIVERGENCE_FACTOR (2.0f)       // Error growth over the best iteration that resets the table
+
+/**
+ * Iterative learning control settings
+ */
+typedef struct _pbio_ilc_settings_t {
+    bool enabled;                   /**< Apply and learn the correction */
+    float gain;                     /**< Fraction of the PD control action on the error learned at each iteration */
+    int32_t lead;                   /**< Time advance of the error used to learn a tick, for the plant delay (ticks) */
+} pbio_ilc_settings_t;
+
+/**
+ * Maneuver the table was learned on. A different maneuver discards the table
+ */
+typedef struct _pbio_ilc_key_t {
+    int32_t count_start;            /**< Start position (count) */
+    int32_t count_target;           /**< Target position (count) */
+    int32_t rate;                   /**< Cruise speed (count/s) */
+    int32_t acceleration;           /**< Acceleration (count/s^2) */
+    pbio_shaper_settings_t shaper;  /**< Input shaper of the reference */
+    bool gain_scheduling;           /**< Gains of the negative direction in use */
+} pbio_ilc_key_t;
+
+/**
+ * Correction table as persisted in NVS
+ */
+typedef struct _pbio_ilc_table_t {
+    pbio_ilc_key_t key;
+    uint16_t length;                /**< Ticks in use. Zero if there is no table */
+    uint16_t iterations;            /**< Iterations learned into the table */
+    float rms;                      /**< Tracking error RMS of the last iteration (count) */
+    int16_t correction[PBIO_ILC_MAX_TICKS]; /**< Duty added at each tick of the maneuver (duty steps) */
+} pbio_ilc_table_t;
+
+/**
+ * Copy of the table and of the last iteration, learned off the control loop without the motor lock
+ */
+typedef struct _pbio_ilc_work_t {
+    uint32_t generation;            /**< Generation of the table the copy was taken from */
+    uint16_t length;                /**< Ticks of the table */
+    uint16_t iterations;            /**< Iterations learned into the table */
+    float rms_best;                 /**< Lowest tracking error RMS since the table was reset (count) */
+    float gain;                     /**< Learning gain */
+    int32_t lead;                   /**< Phase lead (ticks) */
+    float kp;                       /**< Proportional gain of the direction of the maneuver */
+    float kd;                       /**< Derivative gain of the direction of the maneuver */
+    int32_t max_control;            /**< Limit of the correction (duty steps) */
+    int16_t *correction;            /**< Table, replaced by the learned one */
+    int32_t *count_err;             /**< Position error of the iteration (count) */
+    int32_t *rate_err;              /**< Speed error of the iteration (count/s) */
+    float rms_iteration;            /**< Return the tracking error RMS of the iteration (count) */
+} pbio_ilc_work_t;
+
+/**
+ * Iterative learning control for a repeated run_target maneuver
+ *
+ * When armed, the next run_target is an iteration. During the iteration the correction of the
+ * current tick is added to the control and the tracking errors are recorded. Once the maneuver
+ * and its tail are over the table is updated off the control loop with a PD type law with phase
+ * lead, and smoothed by a zero phase filter that keeps the learning robust at high frequency:
+ *
+ *   u[t] = Q(u[t] + gain * (kp * e[t + lead] + kd * de[t + lead]))
+ *
+ * The update runs on a copy: the errors and the table are swapped out under the motor lock, learned
+ * without it, and the result is swapped back in, unless the table changed or an iteration started.
+ * The buffers live in PSRAM and are allocated when the learning is enabled or a table is loaded.
+ */
+typedef struct _pbio_ilc_t {
+    pbio_ilc_settings_t settings;
+    pbio_ilc_key_t key;
+    bool armed;                     /**< Learn the next run_target */
+    bool recording;                 /**< An iteration is running */
+    bool ready;                     /**< An iteration was recorded, waiting to be learned */
+    int32_t t0;                     /**< Start of the trajectory of the iteration (us) */
+    uint16_t length;                /**< Ticks of the table */
+    int16_t *correction;            /**< Duty added at each tick (duty steps) */
+    int32_t *count_err;             /**< Position error recorded at each tick (count) */
+    int32_t *rate_err;              /**< Speed error recorded at each tick (count/s) */
+    uint16_t iterations;            /**< Iterations learned into the table */
+    float rms;                      /**< Tracking error RMS of the last iteration (count) */
+    float rms_best;                 /**< Lowest tracking error RMS since the table was reset (count) */
+    float rms_stored;               /**< Tracking error RMS when the table was last stored (count) */
+    bool converged;                 /**< The last iteration didn't improve much over the previous one */
+    bool needs_store;               /**< Converged and better than the stored table */
+    uint32_t generation;            /**< Bumped when the table is reset or loaded, or an iteration starts */
+    bool learning;                  /**< The work copy is being learned */
+    pbio_ilc_work_t work;
+} pbio_ilc_t;
+
+void pbio_ilc_setup(pbio_ilc_t *ilc);
+void pbio_ilc_arm(pbio_ilc_t *ilc);
+void pbio_ilc_start(pbio_ilc_t *ilc, const pbio_control_settings_t *s, int32_t t0, int32_t duration, const pbio_ilc_key_t *key);
+int32_t pbio_ilc_update(pbio_ilc_t *ilc, bool active, int32_t t0, int32_t time_ref, int32_t count_err, int32_t rate_err);
+pbio_error_t pbio_ilc_learn_begin(pbio_ilc_t *ilc, const pbio_control_settings_t *s);
+pbio_error_t pbio_ilc_learn(pbio_ilc_work_t *work);
+pbio_error_t pbio_ilc_learn_end(pbio_ilc_t *ilc, pbio_error_t err);
+void pbio_ilc_mark_stored(pbio_ilc_t *ilc);
+
+void pbio_ilc_get_settings(const pbio_ilc_t *ilc, bool *enabled, float *gain, uint16_t *lead_ms);
+pbio_error_t pbio_ilc_set_settings(pbio_ilc_t *ilc, bool enabled, float gain, uint16_t lead_ms);
+void pbio_ilc_get_table(const pbio_ilc_t *ilc, pbio_ilc_table_t *table);
+pbio_error_t pbio_ilc_set_table(pbio_ilc_t *ilc, const pbio_ilc_table_t *table);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/error.hpp"
+#include "motor_control/controlsettings.h"
+
+// Fixed point scale of the gains (16.16)
+#define PBIO_LQR_GAIN_SHIFT (16)
+
+// Defaults applied at setup, in user units
+#define PBIO_LQR_DEFAULT_POSITION_ERROR (1.0f)      // deg
+#define PBIO_LQR_DEFAULT_SPEED_ERROR (20.0f)        // deg/s
+#define PBIO_LQR_DEFAULT_INTEGRAL_ERROR (0.5f)      // deg*s
+
+#define PBIO_LQR_MAX_ITERATIONS (5000)              // Riccati iterations before giving up
+#define PBIO_LQR_CONVERGENCE (1e-9)                 // Relative gain change that stops the iterations
+
+/**
+ * State feedback settings. The weights follow Bryson's rule: each state is weighted by the inverse
+ * square of its largest acceptable value, and the duty by the inverse square of the full duty
+ */
+typedef struct _pbio_lqr_settings_t {
+    bool enabled;                   /**< Use the state feedback instead of the PID. It also needs an identified plant model */
+    float position_error;           /**< Acceptable position error (user units) */
+    float speed_error;              /**< Acceptable speed error (user units/s) */
+    float integral_error;           /**< Acceptable integral of the position error (user units*s) */
+} pbio_lqr_settings_t;
+
+/**
+ * Linear quadratic regulator on the position error, its derivative and its integral
+ *
+ * The gains are computed off the control loop from the identified model, discretized at the
+ * control period, by iterating the discrete Riccati equation:
+ *
+ *   x = [int(e), e, de],  x[k+1] = A x[k] + B u[k],  u = k_i int(e) + k_p e + k_d de
+ *
+ * The control loop only evaluates the three products in fixed point.
+ */
+typedef struct _pbio_lqr_t {
+    pbio_lqr_settings_t settings;
+    bool valid;                     /**< The gains were computed from the current model */
+    int32_t k_count[2];             /**< Position error gain per direction (duty steps per count, 16.16) */
+    int32_t k_rate[2];              /**< Speed error gain per direction (duty steps per count/s, 16.16) */
+    int32_t k_integral[2];          /**< Integral error gain per direction (duty steps per count*ms, 16.16) */
+} pbio_lqr_t;
+
+void pbio_lqr_setup(pbio_lqr_t *lqr);
+pbio_error_t pbio_lqr_update_gains(pbio_lqr_t *lqr, const pbio_control_settings_t *s);
+void pbio_lqr_get_feedback(const pbio_lqr_t *lqr, int8_t direction, int32_t count_err, int32_t rate_err, int32_t count_err_integral,
+                           int32_t *duty_count, int32_t *duty_rate, int32_t *duty_integral);
+int32_t pbio_lqr_get_max_integrator(const pbio_lqr_t *lqr, const pbio_control_settings_t *s, int8_t direction);
+int32_t pbio_lqr_get_travel_duty(const pbio_lqr_t *lqr, int8_t direction, int32_t rate, int32_t time);
+
+/**
+Return true if the state feedback replaces the PID
+ */
+static inline bool pbio_lqr_is_active(const pbio_lqr_t *lqr) {
+    return lqr->settings.enabled && lqr->valid;
+}
+
+void pbio_lqr_get_settings(const pbio_lqr_t *lqr, bool *enabled, float *position_error, float *speed_error, float *integral_error);
+pbio_error_t pbio_lqr_set_settings(pbio_lqr_t *lqr, const pbio_control_settings_t *s, bool enabled, float position_error, float speed_error, float integral_error);
+void pbio_lqr_get_gains(const pbio_lqr_t *lqr, const pbio_control_settings_t *s, int8_t direction, float *k_position, float *k_speed, float *k_integral);
@@ -1,4 +1,19 @@
 #pragma once
 
+#include "esp_attr.h"
+#include "config.h"
+
 #define PIO_MIN(a, b) ((a) < (b) ? (a) : (b))
 #define PIO_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+// Placement of Motor::update and the pbio servo path below it. In IRAM they don't miss the flash
+// cache when the other core evicts it reading the flash or the PSRAM, and without jump tables their
+// switches don't read a table in the flash rodata either.
+// This doesn't keep the update running during flash writes: the flash driver parks the tasks of the
+// other core until the write is done. The tick also runs code left in flash, the gantry and axis
+// registry updates, the MCPWM driver calls and libm among them, so it isn't IRAM-safe
+#if PBIO_CONFIG_SERVO_IRAM
+#define PBIO_IRAM IRAM_ATTR __attribute__((optimize("no-jump-tables")))
+#else
+#define PBIO_IRAM
+#endif
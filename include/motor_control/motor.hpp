@@ -5,10 +5,19 @@
 #include "motor_control/enums.h"
 #include "motor_control/error.hpp"
 #include "motor_control/servo.hpp"
+#include "motor_control/simulation.hpp"
 #include "motor_control/tacho.hpp"
 #include "motor_control/dcmotor.hpp"
 #include "utils/cancel_token.hpp"
 
+// Motion events signaled by the servo loop
+#define MOTOR_EVENT_DONE        (1 << 0)    // The maneuver is complete
+#define MOTOR_EVENT_STALLED     (1 << 1)    // The motor is stalled
+#define MOTOR_EVENT_ERROR       (1 << 2)    // The servo reported an error
+#define MOTOR_EVENT_CANCEL      (1 << 3)    // The cancel token of a waiting task was cancelled
+
+#define MOTOR_WAIT_FOREVER      (UINT32_MAX)
+
 typedef void (*motor_error_output_func_t)(pbio_error_t err, const char* err_string, const char* message);
 
 class Motor {
@@ -21,11 +30,21 @@ class Motor {
         pbio_error_t _servo_status = PBIO_SUCCESS;
 
         SemaphoreHandle_t _xMutex = xSemaphoreCreateMutex();
+        EventGroupHandle_t _events = xEventGroupCreate();
+        EventBits_t _events_state = 0;
+
+        // Cost of the servo updates, since the last reset
+        uint64_t _update_cycles_sum = 0;
+        uint32_t _update_cycles_max = 0;
+        uint32_t _update_count = 0;
 
         float _swLimitM, _swLimitP;
         motor_error_output_func_t _current_error_output_func = nullptr;
 
         void output_motor_error(pbio_error_t err, const char* format, ...);
+        void update_envelope_limits();
+        void start_events();
+        void update_events();
 
     public:
         void begin(
@@ -37,7 +56,9 @@ class Motor {
             pbio_direction_t direction, 
             float gear_ratio, 
             pbio_control_settings_t *settings,
-            motor_error_output_func_t error_output_func = nullptr);
+            motor_error_output_func_t error_output_func = nullptr,
+            uint32_t pwm_frequency = MOTOR_PWM_FREQUENCY,
+            uint8_t pwm_resolution = MOTOR_PWM_RESOLUTION);
 
         const char* name() const {
             return _name;
@@ -49,6 +70,7 @@ class Motor {
         float speed() const;
         float motor_speed() const;
         void getState(pbio_passivity_t *state, int32_t *duty_now) const;
+        float duty() const;
         pbio_control_type_t getActuationStatus() const {
             return _servo.control.type;
         }
@@ -61,13 +83,26 @@ class Motor {
         pbio_error_t run(float speed);
         pbio_error_t run_time(float speed, uint32_t time_ms, pbio_actuation_t then = PBIO_ACTUATION_HOLD, bool wait = true, CancelToken* cancel_token = nullptr);
         pbio_error_t run_until_stalled(float speed, float duty_limit = 100.0, pbio_actuation_t then = PBIO_ACTUATION_COAST, CancelToken* cancel_token = nullptr);
+        pbio_error_t start_until_stalled(float speed, pbio_actuation_t then = PBIO_ACTUATION_COAST);
         pbio_error_t run_angle(float speed, float angle, pbio_actuation_t then = PBIO_ACTUATION_HOLD, bool wait = true, CancelToken* cancel_token = nullptr);
         pbio_error_t run_target(float speed, float target_angle, pbio_actuation_t then = PBIO_ACTUATION_HOLD, bool wait = true, CancelToken* cancel_token = nullptr);
-        void track_target(float target_angle);
-        pbio_error_t wait_for_completion(CancelToken* cancel_token);
+        pbio_error_t run_target_profile(float speed, float acceleration, float target_angle, pbio_actuation_t then = PBIO_ACTUATION_HOLD, bool wait = true, CancelToken* cancel_token = nullptr);
+        void track_target(float target_angle, bool smooth = false, int8_t direction = 0);
+        int8_t reference_direction() const;
+        pbio_error_t wait_for_completion(CancelToken* cancel_token, uint32_t timeout_ms = MOTOR_WAIT_FOREVER);
         bool is_completion();
+        bool is_stalled() const;
+        bool is_failed() const;
+        pbio_error_t status() const;
+
+        // Start maneuvers on several motors in the same servo period
+        pbio_error_t get_target_duration(float speed, float target_angle, int32_t *duration_us);
+        void begin_sync();
+        pbio_error_t run_target_synced(int32_t time_start, float speed, float target_angle, float time_scale, pbio_actuation_t then);
+        void end_sync();
 
         void update();
+        void get_update_cycles(uint32_t *mean, uint32_t *max, bool reset);
 
         float get_counts_per_unit() const;
         float get_speed_limit() const;
@@ -82,6 +117,45 @@ class Motor {
         pbio_error_t set_target_tolerances(float speed, float position);
         void get_stall_tolerances(float *speed, uint32_t *time_ms) const;
         pbio_error_t set_stall_tolerances(float speed, uint32_t time_ms);
+        void get_model(float *gain_pos, float *gain_neg, float *time_constant_pos, float *time_constant_neg, float *coulomb, float *viscous, float *gravity) const;
+        pbio_error_t set_model(float gain_pos, float gain_neg, float time_constant_pos, float time_constant_neg, float coulomb, float viscous, float gravity);
+        void get_ff_table(pbio_control_ff_table_t *table) const;
+        bool get_gain_scheduling() const;
+        void set_gain_scheduling(bool enable);
+        void get_gains_neg(uint16_t *kp, uint16_t *ki, uint16_t *kd, float *acceleration, float *max_windup_factor) const;
+        pbio_error_t set_gains_neg(uint16_t kp, uint16_t ki, uint16_t kd, float acceleration, float max_windup_factor);
+        pbio_error_t set_ff_table(const pbio_control_ff_table_t *table);
+        void get_collision_detection(bool *enabled, float *threshold, uint8_t *ticks, pbio_actuation_t *reaction) const;
+        pbio_error_t set_collision_detection(bool enabled, float threshold, uint8_t ticks, pbio_actuation_t reaction);
+        bool collision_detected() const;
+        uint32_t collision_count() const;
+        float collision_residual() const;
+        void collision_stop(float residual);
+        void collision_reset();
+        bool get_envelope() const;
+        void set_envelope(bool enabled);
+        void arm_envelope(bool armed);
+        bool envelope_armed() const;
+        uint32_t envelope_violations() const;
+        void get_envelope_violation(float *angle, float *speed) const;
+        void get_disturbance_observer(bool *enabled, float *bandwidth) const;
+        pbio_error_t set_disturbance_observer(bool enabled, float bandwidth);
+        float disturbance() const;
+        void get_state_feedback(bool *enabled, float *position_error, float *speed_error, float *integral_error) const;
+        pbio_error_t set_state_feedback(bool enabled, float position_error, float speed_error, float integral_error);
+        bool get_state_feedback_gains(int8_t direction, float *k_position, float *k_speed, float *k_integral) const;
+        void get_input_shaper(pbio_shaper_type_t *type, float *frequency, float *damping) const;
+        pbio_error_t set_input_shaper(pbio_shaper_type_t type, float frequency, float damping);
+        pbio_error_t simulate_run_target(bool state_feedback, float speed, float start, float target, pbio_simulation_result_t *result);
+        pbio_error_t preview_target(float start, float target, float speed, float acceleration, float speed_limit, float acceleration_limit, uint16_t max_samples, pbio_simulation_sample_t *samples, uint16_t *num_samples);
+        void get_learning(bool *enabled, float *gain, uint16_t *lead_ms) const;
+        pbio_error_t set_learning(bool enabled, float gain, uint16_t lead_ms);
+        void arm_learning();
+        pbio_error_t learn(float *rms, uint16_t *iterations);
+        bool learning_needs_store() const;
+        void mark_learning_stored();
+        void get_learning_table(pbio_ilc_table_t *table) const;
+        pbio_error_t set_learning_table(const pbio_ilc_table_t *table);
 
         float getSwLimitMinus() const {
             float value;
@@ -96,6 +170,7 @@ class Motor {
         void setSwLimitMinus(float value) {
             if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
                 _swLimitM = value;
+                update_envelope_limits();
                 xSemaphoreGive(_xMutex);
             }
         }
@@ -113,6 +188,7 @@ class Motor {
         void setSwLimitPlus(float value) {
             if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
                 _swLimitP = value;
+                update_envelope_limits();
                 xSemaphoreGive(_xMutex);
             }
         }
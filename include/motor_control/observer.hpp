@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/enums.h"
+#include "motor_control/error.hpp"
+#include "motor_control/controlsettings.h"
+
+// Defaults applied at setup
+#define PBIO_OBSERVER_DEFAULT_BANDWIDTH (10.0f)     // Cutoff of the estimate (Hz)
+#define PBIO_OBSERVER_MIN_BANDWIDTH (1.0f)
+#define PBIO_OBSERVER_MAX_BANDWIDTH (50.0f)
+
+/**
+ * Disturbance observer settings
+ */
+typedef struct _pbio_observer_settings_t {
+    bool enabled;                   /**< Estimate and cancel the disturbance. It also needs an identified plant model */
+    float bandwidth;                /**< Cutoff frequency of the estimate (Hz) */
+} pbio_observer_settings_t;
+
+/**
+ * Disturbance observer
+ *
+ * The load not covered by the model, like the arm weight and friction the model offsets miss,
+ * is estimated as the duty that explains the difference between the applied duty and the duty
+ * the inverted plant model needs for the measured speed. Both are low pass filtered at the
+ * bandwidth, which keeps the inverted model proper and rejects the speed noise:
+ *
+ *   d = Q * (u - offset) - Q * (tau * s + 1) / K * w,    Q = wc / (s + wc)
+ *
+ * Adding the estimate to the control cancels the disturbance within a few periods, instead of
+ * waiting for the integrator to wind up against it.
+ */
+typedef struct _pbio_observer_t {
+    pbio_observer_settings_t settings;
+    bool primed;                    /**< The filter state is valid */
+    int32_t time_prev;              /**< Time of the previous update (us) */
+    float control_prev;             /**< Duty applied in the previous period (duty steps) */
+    float control_filtered;         /**< Low pass filtered duty, net of the modeled friction and gravity (duty steps) */
+    float rate_filtered;            /**< Low pass filtered speed (counts/s) */
+    float disturbance;              /**< Estimated disturbance (duty steps) */
+} pbio_observer_t;
+
+void pbio_observer_setup(pbio_observer_t *obs);
+void pbio_observer_reset(pbio_observer_t *obs);
+int32_t pbio_observer_update(pbio_observer_t *obs, const pbio_control_model_t *model, int32_t time_now, int32_t rate_now);
+void pbio_observer_set_control(pbio_observer_t *obs, pbio_actuation_t actuation, int32_t control);
+
+void pbio_observer_get_settings(const pbio_observer_t *obs, bool *enabled, float *bandwidth);
+pbio_error_t pbio_observer_set_settings(pbio_observer_t *obs, bool enabled, float bandwidth);
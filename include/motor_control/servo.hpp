@@ -13,12 +13,19 @@
 #include "motor_control/dcmotor.hpp"
 #include "motor_control/control.hpp"
 #include "motor_control/logger.hpp"
+#include "motor_control/collision.hpp"
+#include "motor_control/envelope.hpp"
+#include "motor_control/battery.hpp"
+#include "motor_control/ilc.hpp"
 
 typedef struct _pbio_servo_t {
     DCMotor *dcmotor;
     Tacho *tacho;
     pbio_control_t control;
     PBIOLogger* log;
+    pbio_collision_t collision;
+    pbio_envelope_t envelope;
+    pbio_ilc_t ilc;
 } pbio_servo_t;
 
 void pbio_servo_setup(pbio_servo_t *srv, DCMotor *dcmotor, Tacho *tacho, PBIOLogger *logger, float counts_per_unit, pbio_control_settings_t *settings);
@@ -27,6 +34,7 @@ void pbio_servo_reset_angle(pbio_servo_t *srv, float reset_angle);
 pbio_error_t pbio_servo_is_stalled(pbio_servo_t *srv, bool *stalled);
 
 void pbio_servo_stop(pbio_servo_t *srv, pbio_actuation_t after_stop);
+void pbio_servo_collision_stop(pbio_servo_t *srv, int32_t residual);
 
 void pbio_servo_set_duty_cycle(pbio_servo_t *srv, float duty_steps);
 
@@ -34,7 +42,9 @@ pbio_error_t pbio_servo_run(pbio_servo_t *srv, float speed);
 pbio_error_t pbio_servo_run_time(pbio_servo_t *srv, float speed, int32_t duration, pbio_actuation_t after_stop);
 pbio_error_t pbio_servo_run_until_stalled(pbio_servo_t *srv, float speed, pbio_actuation_t after_stop);
 pbio_error_t pbio_servo_run_angle(pbio_servo_t *srv, float speed, float angle, pbio_actuation_t after_stop);
-pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, float speed, float target, pbio_actuation_t after_stop);
-void pbio_servo_track_target(pbio_servo_t *srv, float target);
+pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, float speed, float target, float acceleration, pbio_actuation_t after_stop);
+pbio_error_t pbio_servo_get_target_duration(pbio_servo_t *srv, float speed, float target, int32_t *duration);
+pbio_error_t pbio_servo_run_target_scaled(pbio_servo_t *srv, int32_t time_start, float speed, float target, float time_scale, pbio_actuation_t after_stop);
+void pbio_servo_track_target(pbio_servo_t *srv, float target, bool smooth, int8_t direction);
 
 pbio_error_t pbio_servo_control_update(pbio_servo_t *srv);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/error.hpp"
+#include "motor_control/trajectory.hpp"
+
+#define PBIO_SHAPER_MAX_IMPULSES (3)
+#define PBIO_SHAPER_AMPLITUDE_SHIFT (16)        // Fixed point scale of the impulse amplitudes (16.16)
+
+// Defaults applied at setup
+#define PBIO_SHAPER_DEFAULT_FREQUENCY (2.0f)    // Hz
+#define PBIO_SHAPER_DEFAULT_DAMPING (0.05f)
+#define PBIO_SHAPER_MIN_FREQUENCY (0.2f)
+#define PBIO_SHAPER_MAX_FREQUENCY (20.0f)
+#define PBIO_SHAPER_MAX_DAMPING (0.9f)
+
+/**
+ * Impulse sequence of the shaper
+ */
+typedef enum {
+    PBIO_SHAPER_NONE,               /**< Reference not shaped */
+    PBIO_SHAPER_ZV,                 /**< Zero vibration, two impulses over half a period */
+    PBIO_SHAPER_ZVD,                /**< Zero vibration and derivative, three impulses over a period. Robust to a wrong frequency */
+} pbio_shaper_type_t;
+
+/**
+ * Input shaper settings
+ */
+typedef struct _pbio_shaper_settings_t {
+    pbio_shaper_type_t type;        /**< Impulse sequence */
+    float frequency;                /**< Natural frequency of the vibration to suppress (Hz) */
+    float damping;                  /**< Damping ratio of the vibration to suppress */
+} pbio_shaper_settings_t;
+
+/**
+ * Input shaper of the angle control reference
+ *
+ * The reference is convolved with an impulse sequence that cancels the vibration of a mode at the
+ * given frequency and damping. The impulses add up to one, so the shaped move ends at the same
+ * target, delayed by the duration of the sequence:
+ *
+ *   r_s(t) = sum A_i * r(t - t_i),   K = exp(-damping * pi / sqrt(1 - damping^2)),   t_i = i * Td / 2
+ *
+ *   ZV:  A = [1, K] / (1 + K),   ZVD: A = [1, 2K, K^2] / (1 + K)^2
+ *
+ * The delayed impulses may still need the trajectory replaced by a new command, so the previous
+ * trajectory is kept until it's no longer reached.
+ */
+typedef struct _pbio_shaper_t {
+    pbio_shaper_settings_t settings;
+    uint8_t impulses;               /**< Impulses in use, zero when not shaping */
+    int32_t delay[PBIO_SHAPER_MAX_IMPULSES]; /**< Time of each impulse (us) */
+    int32_t amplitude[PBIO_SHAPER_MAX_IMPULSES]; /**< Amplitude of each impulse (16.16) */
+    bool has_previous;              /**< The previous trajectory is still reached by the delayed impulses */
+    int32_t time_switch;            /**< Reference time at which the previous trajectory was replaced (us) */
+    pbio_trajectory_t previous;     /**< Trajectory replaced by the last command */
+} pbio_shaper_t;
+
+void pbio_shaper_setup(pbio_shaper_t *shaper);
+void pbio_shaper_reset(pbio_shaper_t *shaper);
+void pbio_shaper_replace(pbio_shaper_t *shaper, const pbio_trajectory_t *previous, int32_t time_ref);
+void pbio_shaper_get_reference(pbio_shaper_t *shaper, pbio_trajectory_t *trajectory, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref);
+
+/**
+Return the time the shaper delays the end of a move (us)
+ */
+static inline int32_t pbio_shaper_get_duration(const pbio_shaper_t *shaper) {
+    return shaper->impulses > 0 ? shaper->delay[shaper->impulses - 1] : 0;
+}
+
+void pbio_shaper_get_settings(const pbio_shaper_t *shaper, pbio_shaper_type_t *type, float *frequency, float *damping);
+pbio_error_t pbio_shaper_set_settings(pbio_shaper_t *shaper, pbio_shaper_type_t type, float frequency, float damping);
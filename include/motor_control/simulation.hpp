@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/error.hpp"
+#include "motor_control/control.hpp"
+
+#define PBIO_SIMULATION_TAIL_MS (1000)          // Time simulated after the end of the trajectory
+#define PBIO_SIMULATION_MAX_MS (10000)          // Longest maneuver that can be simulated
+#define PBIO_SIMULATION_MAX_PREVIEW_SAMPLES (1000)  // Most samples of a previewed reference
+
+/**
+ * Outcome of a simulated maneuver
+ */
+typedef struct _pbio_simulation_result_t {
+    int32_t settle_time;            /**< Time from the start of the trajectory until the position stays within tolerance, -1 if never (us) */
+    int32_t overshoot;              /**< Largest position past the target (count) */
+    float rms;                      /**< Tracking error RMS over the maneuver and the tail (count) */
+    uint32_t cycles;                /**< Mean CPU cycles of a control update */
+} pbio_simulation_result_t;
+
+/**
+ * Sample of a previewed reference
+ */
+typedef struct _pbio_simulation_sample_t {
+    int32_t time;                   /**< Time from the start of the maneuver (us) */
+    int32_t count;                  /**< Reference position (count) */
+    int32_t count_ext;              /**< Reference position decimals (millicount) */
+    int32_t rate;                   /**< Reference speed (count/s) */
+    int32_t acceleration;           /**< Reference acceleration (count/s^2) */
+} pbio_simulation_sample_t;
+
+pbio_error_t pbio_simulation_run_target(pbio_control_t *ctl, int32_t count_start, int32_t count_target, int32_t target_rate, pbio_simulation_result_t *result);
+pbio_error_t pbio_simulation_preview_target(pbio_control_t *ctl, int32_t count_start, int32_t count_target, int32_t target_rate, int32_t acceleration, uint16_t max_samples, pbio_simulation_sample_t *samples, uint16_t *num_samples);
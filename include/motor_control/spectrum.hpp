@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/logger.hpp"
+#include "motor_control/error.hpp"
+
+// Logger columns that can be analyzed
+#define PBIO_SPECTRUM_COL_DUTY (5)      // Actuation value (duty steps)
+#define PBIO_SPECTRUM_COL_ERROR (8)     // Position error (count)
+
+// FFT length limits. The maximum must not exceed the esp-dsp CONFIG_DSP_MAX_FFT_SIZE
+#define PBIO_SPECTRUM_MIN_LEN (64)
+#define PBIO_SPECTRUM_MAX_LEN (2048)
+
+// Maximum number of reported peaks
+#define PBIO_SPECTRUM_MAX_PEAKS (8)
+
+/**
+ * Spectrum peak
+ */
+typedef struct _pbio_spectrum_peak_t {
+    float frequency;    /**< Peak frequency (Hz) */
+    float amplitude;    /**< Peak amplitude in the units of the analyzed column */
+} pbio_spectrum_peak_t;
+
+/**
+ * Spectrum analysis result
+ */
+typedef struct _pbio_spectrum_t {
+    uint32_t samples;       /**< Number of samples used for the FFT */
+    float sample_rate;      /**< Sample rate of the log (Hz) */
+    float resolution;       /**< Frequency resolution (Hz) */
+    uint8_t num_peaks;      /**< Number of valid peaks */
+    pbio_spectrum_peak_t peaks[PBIO_SPECTRUM_MAX_PEAKS]; /**< Peaks sorted by decreasing amplitude */
+} pbio_spectrum_t;
+
+pbio_error_t pbio_spectrum_analyze(PBIOLogger *log, uint8_t col, uint32_t start_row, uint8_t max_peaks, pbio_spectrum_t *spectrum);
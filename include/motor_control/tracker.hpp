@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Arduino.h>
+#include "motor_control/controlsettings.h"
+
+/**
+ * Setpoint filter of a tracked target
+ *
+ * The reference moves to the target as fast as the speed and acceleration limits allow, and stops
+ * on it without overshoot. Each period the speed steps, within the acceleration limit, towards the
+ * highest speed from which the reference can still stop on the target after the step:
+ *
+ *   v^2 / (2 * a) + v * dt / 2 <= |e| - v_prev * dt / 2
+ *
+ * A new target only changes where the reference is heading, so it never steps.
+ */
+typedef struct _pbio_tracker_t {
+    bool active;                    /**< The reference follows the filter */
+    int32_t target;                 /**< Tracked target (count) */
+    int32_t time_prev;              /**< Time of the previous update (us) */
+    float count;                    /**< Filtered position (count) */
+    float rate;                     /**< Filtered speed (count/s) */
+    float acceleration;             /**< Filtered acceleration (count/s^2) */
+} pbio_tracker_t;
+
+void pbio_tracker_start(pbio_tracker_t *tracker, int32_t time_now, int32_t count, int32_t rate, int32_t target);
+void pbio_tracker_stop(pbio_tracker_t *tracker);
+void pbio_tracker_update(pbio_tracker_t *tracker, const pbio_control_settings_t *s, int32_t time_now);
+void pbio_tracker_get_reference(const pbio_tracker_t *tracker, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisEnvelopeSetting : public SettingBool {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisEnvelopeSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        bool getValue() const override {
+            return _motor1.get_envelope();
+        }
+
+        void setValue(const bool value) override {
+            // On a gantry motor 2 follows motor 1, so only motor 1 brakes on the limits
+            _motor1.set_envelope(value);
+        }
+
+        const char* getName() const override {
+            return "envelope";
+        }
+
+        const char* getTitle() const override {
+            return "Enforce software limits";
+        }
+
+        const char* getDescription() const override {
+            return "Once the axis is homed, brake any motion that would overrun the software limits, open loop and jog included, so that it stops on the limit";
+        }
+    };
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisGainSchedulingSetting : public SettingBool {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisGainSchedulingSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        bool getValue() const override {
+            return _motor1.get_gain_scheduling();
+        }
+
+        void setValue(const bool value) override {
+            _motor1.set_gain_scheduling(value);
+            _motor2.set_gain_scheduling(value);
+        }
+
+        const char* getName() const override {
+            return "gain_sched";
+        }
+
+        const char* getTitle() const override {
+            return "Gain scheduling";
+        }
+
+        const char* getDescription() const override {
+            return "Use a separate set of PID gains, acceleration and windup factor while moving in negative direction. The switch between the two sets is bumpless";
+        }
+    };
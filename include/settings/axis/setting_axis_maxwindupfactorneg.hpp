@@ -0,0 +1,80 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisMaxWindupFactorNegSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisMaxWindupFactorNegSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            uint16_t kp;
+            uint16_t ki;
+            uint16_t kd;
+            float acceleration;
+            float max_windup_factor;
+
+            _motor1.get_gains_neg(&kp, &ki, &kd, &acceleration, &max_windup_factor);
+            return max_windup_factor;
+        }
+
+        void setValue(const float value) override {
+            uint16_t kp;
+            uint16_t ki;
+            uint16_t kd;
+            float acceleration;
+            float max_windup_factor;
+
+            _motor1.get_gains_neg(&kp, &ki, &kd, &acceleration, &max_windup_factor);
+            max_windup_factor = value;
+            _motor1.set_gains_neg(kp, ki, kd, acceleration, max_windup_factor);
+
+            _motor2.get_gains_neg(&kp, &ki, &kd, &acceleration, &max_windup_factor);
+            max_windup_factor = value;
+            _motor2.set_gains_neg(kp, ki, kd, acceleration, max_windup_factor);
+        }
+
+        const char* getName() const override {
+            return "max_windup_neg";
+        }
+
+        const char* getTitle() const override {
+            return "Max Windup Factor (negative)";
+        }
+
+        const char* getDescription() const override {
+            return "Integrator max windup factor used while moving in negative direction, when gain scheduling is enabled";
+        }
+
+        const char* getUnit() const override {
+            return "";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 0.1;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 10.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.1;
+        }
+    };
\ No newline at end of file
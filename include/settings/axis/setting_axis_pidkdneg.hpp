@@ -0,0 +1,64 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisPidKdNegSetting : public SettingUInt16 {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisPidKdNegSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        uint16_t getValue() const override {
+            uint16_t kp;
+            uint16_t ki;
+            uint16_t kd;
+            float acceleration;
+            float max_windup_factor;
+
+            _motor1.get_gains_neg(&kp, &ki, &kd, &acceleration, &max_windup_factor);
+            return kd;
+        }
+
+        void setValue(const uint16_t value) override {
+            uint16_t kp;
+            uint16_t ki;
+            uint16_t kd;
+            float acceleration;
+            float max_windup_factor;
+
+            _motor1.get_gains_neg(&kp, &ki, &kd, &acceleration, &max_windup_factor);
+            kd = value;
+            _motor1.set_gains_neg(kp, ki, kd, acceleration, max_windup_factor);
+
+            _motor2.get_gains_neg(&kp, &ki, &kd, &acceleration, &max_windup_factor);
+            kd = value;
+            _motor2.set_gains_neg(kp, ki, kd, acceleration, max_windup_factor);
+        }
+
+        const char* getName() const override {
+            return "pid_kd_neg";
+        }
+
+        const char* getTitle() const override {
+            return "PID Kd (negative)";
+        }
+
+        const char* getDescription() const override {
+            return "Derivative gain for the PID controller while moving in negative direction, when gain scheduling is enabled";
+        }
+
+        const char* getUnit() const override {
+            return "";
+        }
+
+        const uint16_t getMinValue() const override {
+            return 0;
+        }
+
+        const uint16_t getMaxValue() const override {
+            return 1000;
+        }
+    };
\ No newline at end of file
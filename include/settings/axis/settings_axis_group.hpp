@@ -2,6 +2,7 @@
 #include "settings/settings_group.hpp"
 #include "setting_axis_swlimitm.hpp"
 #include "setting_axis_swlimitp.hpp"
+#include "settings/axis/setting_axis_envelope.hpp"
 #include "setting_axis_maxspeed.hpp"
 #include "setting_axis_maxacc.hpp"
 #include "setting_axis_postolerance.hpp"
@@ -11,6 +12,12 @@
 #include "settings/axis/setting_axis_integralrange.hpp"
 #include "settings/axis/setting_axis_integralrate.hpp"
 #include "settings/axis/setting_axis_maxwindupfactor.hpp"
+#include "settings/axis/setting_axis_gainscheduling.hpp"
+#include "settings/axis/setting_axis_pidkpneg.hpp"
+#include "settings/axis/setting_axis_pidkineg.hpp"
+#include "settings/axis/setting_axis_pidkdneg.hpp"
+#include "settings/axis/setting_axis_maxaccneg.hpp"
+#include "settings/axis/setting_axis_maxwindupfactorneg.hpp"
 #include "motor_control\motor.hpp"
 
 class SettingsAxisGroup : public SettingsGroup {
@@ -22,6 +29,7 @@ class SettingsAxisGroup : public SettingsGroup {
         Motor& _motor2;
         AxisSwLimitMSetting _swLimitM = AxisSwLimitMSetting(_motor1, _motor2);
         AxisSwLimitPSetting _swLimitP = AxisSwLimitPSetting(_motor1, _motor2);
+        AxisEnvelopeSetting _envelope = AxisEnvelopeSetting(_motor1, _motor2);
         AxisMaxSpeedSetting _maxSpeed = AxisMaxSpeedSetting(_motor1, _motor2);
         AxisMaxAccelerationSetting _maxAcc = AxisMaxAccelerationSetting(_motor1, _motor2);
         AxisPosToleranceSetting _posTolerance = AxisPosToleranceSetting(_motor1, _motor2);
@@ -31,13 +39,22 @@ class SettingsAxisGroup : public SettingsGroup {
         AxisIntegralRangeSetting _integralRange = AxisIntegralRangeSetting(_motor1, _motor2);
         AxisIntegralRateSetting _integralRate = AxisIntegralRateSetting(_motor1, _motor2);
         AxisMaxWindupFactorSetting _maxWindupFactor = AxisMaxWindupFactorSetting(_motor1, _motor2);
+        AxisGainSchedulingSetting _gainScheduling = AxisGainSchedulingSetting(_motor1, _motor2);
+        AxisPidKpNegSetting _pidKpNeg = AxisPidKpNegSetting(_motor1, _motor2);
+        AxisPidKiNegSetting _pidKiNeg = AxisPidKiNegSetting(_motor1, _motor2);
+        AxisPidKdNegSetting _pidKdNeg = AxisPidKdNegSetting(_motor1, _motor2);
+        AxisMaxAccelerationNegSetting _maxAccNeg = AxisMaxAccelerationNegSetting(_motor1, _motor2);
+        AxisMaxWindupFactorNegSetting _maxWindupFactorNeg = AxisMaxWindupFactorNegSetting(_motor1, _motor2);
 
-        ISetting* _settings[11] = {
-            &_swLimitM, &_swLimitP, 
+        ISetting* _settings[18] = {
+            &_swLimitM, &_swLimitP, &_envelope,
             &_maxSpeed, &_maxAcc, &_posTolerance, 
             &_pidKp, &_pidKi, &_pidKd,
             &_integralRange, &_integralRate, 
-            &_maxWindupFactor
+            &_maxWindupFactor,
+            &_gainScheduling,
+            &_pidKpNeg, &_pidKiNeg, &_pidKdNeg,
+            &_maxAccNeg, &_maxWindupFactorNeg
         };
 
     public:
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelCollisionSetting : public SettingBool {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelCollisionSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        bool getValue() const override {
+            bool enabled;
+            float threshold;
+            uint8_t ticks;
+            pbio_actuation_t reaction;
+
+            _motor1.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            return enabled;
+        }
+
+        void setValue(const bool value) override {
+            bool enabled;
+            float threshold;
+            uint8_t ticks;
+            pbio_actuation_t reaction;
+
+            _motor1.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            enabled = value;
+            _motor1.set_collision_detection(enabled, threshold, ticks, reaction);
+
+            _motor2.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            enabled = value;
+            _motor2.set_collision_detection(enabled, threshold, ticks, reaction);
+        }
+
+        const char* getName() const override {
+            return "collision";
+        }
+
+        const char* getTitle() const override {
+            return "Collision detection";
+        }
+
+        const char* getDescription() const override {
+            return "Stop the axis when its speed falls below the speed predicted by the model, because something is blocking it. Needs the identified model";
+        }
+    };
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelCollisionThresholdSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelCollisionThresholdSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            bool enabled;
+            float threshold;
+            uint8_t ticks;
+            pbio_actuation_t reaction;
+
+            _motor1.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            return threshold;
+        }
+
+        void setValue(const float value) override {
+            bool enabled;
+            float threshold;
+            uint8_t ticks;
+            pbio_actuation_t reaction;
+
+            _motor1.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            threshold = value;
+            _motor1.set_collision_detection(enabled, threshold, ticks, reaction);
+
+            _motor2.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            threshold = value;
+            _motor2.set_collision_detection(enabled, threshold, ticks, reaction);
+        }
+
+        const char* getName() const override {
+            return "coll_threshold";
+        }
+
+        const char* getTitle() const override {
+            return "Collision threshold";
+        }
+
+        const char* getDescription() const override {
+            return "Difference between the predicted and the measured speed that flags an obstruction. Lower values react to lighter obstructions but may trip on model errors";
+        }
+
+        const char* getUnit() const override {
+            return "deg/s";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 5.0;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 500.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 5.0;
+        }
+    };
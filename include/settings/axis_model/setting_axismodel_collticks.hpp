@@ -0,0 +1,70 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelCollisionTicksSetting : public SettingUInt8 {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelCollisionTicksSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        uint8_t getValue() const override {
+            bool enabled;
+            float threshold;
+            uint8_t ticks;
+            pbio_actuation_t reaction;
+
+            _motor1.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            return ticks;
+        }
+
+        void setValue(const uint8_t value) override {
+            bool enabled;
+            float threshold;
+            uint8_t ticks;
+            pbio_actuation_t reaction;
+
+            _motor1.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            ticks = value;
+            _motor1.set_collision_detection(enabled, threshold, ticks, reaction);
+
+            _motor2.get_collision_detection(&enabled, &threshold, &ticks, &reaction);
+            ticks = value;
+            _motor2.set_collision_detection(enabled, threshold, ticks, reaction);
+        }
+
+        const char* getName() const override {
+            return "coll_ticks";
+        }
+
+        const char* getTitle() const override {
+            return "Collision confirmation periods";
+        }
+
+        const char* getDescription() const override {
+            return "Consecutive control periods over the threshold before the obstruction is flagged. Each period lasts 3 ms";
+        }
+
+        const char* getUnit() const override {
+            return "";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const uint8_t getMinValue() const override {
+            return 1;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const uint8_t getMaxValue() const override {
+            return PBIO_COLLISION_MAX_TICKS;
+        }
+    };
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelLearningSetting : public SettingBool {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelLearningSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        bool getValue() const override {
+            bool enabled;
+            float gain;
+            uint16_t lead_ms;
+
+            _motor1.get_learning(&enabled, &gain, &lead_ms);
+            return enabled;
+        }
+
+        void setValue(const bool value) override {
+            bool enabled;
+            float gain;
+            uint16_t lead_ms;
+
+            _motor1.get_learning(&enabled, &gain, &lead_ms);
+            enabled = value;
+            _motor1.set_learning(enabled, gain, lead_ms);
+
+            _motor2.get_learning(&enabled, &gain, &lead_ms);
+            enabled = value;
+            _motor2.set_learning(enabled, gain, lead_ms);
+        }
+
+        const char* getName() const override {
+            return "learning";
+        }
+
+        const char* getTitle() const override {
+            return "Drop learning";
+        }
+
+        const char* getDescription() const override {
+            return "Learn, race after race, a correction of the duty along the barrier drop that cancels its repeatable tracking error";
+        }
+    };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelLearningGainSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelLearningGainSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            bool enabled;
+            float gain;
+            uint16_t lead_ms;
+
+            _motor1.get_learning(&enabled, &gain, &lead_ms);
+            return gain;
+        }
+
+        void setValue(const float value) override {
+            bool enabled;
+            float gain;
+            uint16_t lead_ms;
+
+            _motor1.get_learning(&enabled, &gain, &lead_ms);
+            gain = value;
+            _motor1.set_learning(enabled, gain, lead_ms);
+
+            _motor2.get_learning(&enabled, &gain, &lead_ms);
+            gain = value;
+            _motor2.set_learning(enabled, gain, lead_ms);
+        }
+
+        const char* getName() const override {
+            return "learning_gain";
+        }
+
+        const char* getTitle() const override {
+            return "Drop learning gain";
+        }
+
+        const char* getDescription() const override {
+            return "Fraction of the PID action on the tracking error added to the correction at each drop. Higher values learn faster but may not converge";
+        }
+
+        const char* getUnit() const override {
+            return "";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 0.05;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 1.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.05;
+        }
+    };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelLearningLeadSetting : public SettingUInt16 {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelLearningLeadSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        uint16_t getValue() const override {
+            bool enabled;
+            float gain;
+            uint16_t lead_ms;
+
+            _motor1.get_learning(&enabled, &gain, &lead_ms);
+            return lead_ms;
+        }
+
+        void setValue(const uint16_t value) override {
+            bool enabled;
+            float gain;
+            uint16_t lead_ms;
+
+            _motor1.get_learning(&enabled, &gain, &lead_ms);
+            lead_ms = value;
+            _motor1.set_learning(enabled, gain, lead_ms);
+
+            _motor2.get_learning(&enabled, &gain, &lead_ms);
+            lead_ms = value;
+            _motor2.set_learning(enabled, gain, lead_ms);
+        }
+
+        const char* getName() const override {
+            return "learning_lead";
+        }
+
+        const char* getTitle() const override {
+            return "Drop learning lead";
+        }
+
+        const char* getDescription() const override {
+            return "Time advance of the tracking error used to correct each instant of the drop. It compensates the delay of the axis response";
+        }
+
+        const char* getUnit() const override {
+            return "ms";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const uint16_t getMinValue() const override {
+            return 0;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const uint16_t getMaxValue() const override {
+            return PBIO_ILC_MAX_LEAD_MS;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const uint16_t getChangeStep() const override {
+            return 3;
+        }
+    };
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelLqrSetting : public SettingBool {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelLqrSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        bool getValue() const override {
+            bool enabled;
+            float position_error;
+            float speed_error;
+            float integral_error;
+
+            _motor1.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            return enabled;
+        }
+
+        void setValue(const bool value) override {
+            bool enabled;
+            float position_error;
+            float speed_error;
+            float integral_error;
+
+            _motor1.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            enabled = value;
+            _motor1.set_state_feedback(enabled, position_error, speed_error, integral_error);
+
+            _motor2.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            enabled = value;
+            _motor2.set_state_feedback(enabled, position_error, speed_error, integral_error);
+        }
+
+        const char* getName() const override {
+            return "lqr";
+        }
+
+        const char* getTitle() const override {
+            return "State feedback control";
+        }
+
+        const char* getDescription() const override {
+            return "Replace the PID with a state feedback on the position error, its derivative and its integral, with gains computed from the identified model. Needs the identified model";
+        }
+    };
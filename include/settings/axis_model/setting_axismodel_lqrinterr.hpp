@@ -0,0 +1,78 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelLqrIntErrSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelLqrIntErrSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            bool enabled;
+            float position_error;
+            float speed_error;
+            float integral_error;
+
+            _motor1.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            return integral_error;
+        }
+
+        void setValue(const float value) override {
+            bool enabled;
+            float position_error;
+            float speed_error;
+            float integral_error;
+
+            _motor1.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            integral_error = value;
+            _motor1.set_state_feedback(enabled, position_error, speed_error, integral_error);
+
+            _motor2.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            integral_error = value;
+            _motor2.set_state_feedback(enabled, position_error, speed_error, integral_error);
+        }
+
+        const char* getName() const override {
+            return "lqr_int_err";
+        }
+
+        const char* getTitle() const override {
+            return "State feedback integral error";
+        }
+
+        const char* getDescription() const override {
+            return "Acceptable integral of the position error of the state feedback. Lower values remove the steady state error faster";
+        }
+
+        const char* getUnit() const override {
+            return "deg*s";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 0.01;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 100.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.01;
+        }
+    };
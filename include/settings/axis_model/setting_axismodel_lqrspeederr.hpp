@@ -0,0 +1,78 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelLqrSpeedErrSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelLqrSpeedErrSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            bool enabled;
+            float position_error;
+            float speed_error;
+            float integral_error;
+
+            _motor1.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            return speed_error;
+        }
+
+        void setValue(const float value) override {
+            bool enabled;
+            float position_error;
+            float speed_error;
+            float integral_error;
+
+            _motor1.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            speed_error = value;
+            _motor1.set_state_feedback(enabled, position_error, speed_error, integral_error);
+
+            _motor2.get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+            speed_error = value;
+            _motor2.set_state_feedback(enabled, position_error, speed_error, integral_error);
+        }
+
+        const char* getName() const override {
+            return "lqr_speed_err";
+        }
+
+        const char* getTitle() const override {
+            return "State feedback speed error";
+        }
+
+        const char* getDescription() const override {
+            return "Acceptable speed error of the state feedback. Lower values give more damping";
+        }
+
+        const char* getUnit() const override {
+            return "deg/s";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 1.0;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 1000.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 1.0;
+        }
+    };
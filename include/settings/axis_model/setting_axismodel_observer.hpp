@@ -0,0 +1,46 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelObserverSetting : public SettingBool {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelObserverSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        bool getValue() const override {
+            bool enabled;
+            float bandwidth;
+
+            _motor1.get_disturbance_observer(&enabled, &bandwidth);
+            return enabled;
+        }
+
+        void setValue(const bool value) override {
+            bool enabled;
+            float bandwidth;
+
+            _motor1.get_disturbance_observer(&enabled, &bandwidth);
+            enabled = value;
+            _motor1.set_disturbance_observer(enabled, bandwidth);
+
+            _motor2.get_disturbance_observer(&enabled, &bandwidth);
+            enabled = value;
+            _motor2.set_disturbance_observer(enabled, bandwidth);
+        }
+
+        const char* getName() const override {
+            return "observer";
+        }
+
+        const char* getTitle() const override {
+            return "Disturbance observer";
+        }
+
+        const char* getDescription() const override {
+            return "Estimate the load not covered by the model, like the arm weight, and cancel it in a few control periods instead of waiting for the integral action. Needs the identified model";
+        }
+    };
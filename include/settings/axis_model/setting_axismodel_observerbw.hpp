@@ -0,0 +1,74 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelObserverBandwidthSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelObserverBandwidthSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            bool enabled;
+            float bandwidth;
+
+            _motor1.get_disturbance_observer(&enabled, &bandwidth);
+            return bandwidth;
+        }
+
+        void setValue(const float value) override {
+            bool enabled;
+            float bandwidth;
+
+            _motor1.get_disturbance_observer(&enabled, &bandwidth);
+            bandwidth = value;
+            _motor1.set_disturbance_observer(enabled, bandwidth);
+
+            _motor2.get_disturbance_observer(&enabled, &bandwidth);
+            bandwidth = value;
+            _motor2.set_disturbance_observer(enabled, bandwidth);
+        }
+
+        const char* getName() const override {
+            return "observer_bw";
+        }
+
+        const char* getTitle() const override {
+            return "Disturbance observer bandwidth";
+        }
+
+        const char* getDescription() const override {
+            return "Cutoff frequency of the disturbance estimate. Higher values cancel the load faster but let more speed noise into the control";
+        }
+
+        const char* getUnit() const override {
+            return "Hz";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return PBIO_OBSERVER_MIN_BANDWIDTH;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return PBIO_OBSERVER_MAX_BANDWIDTH;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 1.0;
+        }
+    };
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelShaperSetting : public SettingUInt8 {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelShaperSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        uint8_t getValue() const override {
+            pbio_shaper_type_t type;
+            float frequency;
+            float damping;
+
+            _motor1.get_input_shaper(&type, &frequency, &damping);
+            return (uint8_t)type;
+        }
+
+        void setValue(const uint8_t value) override {
+            pbio_shaper_type_t type;
+            float frequency;
+            float damping;
+
+            _motor1.get_input_shaper(&type, &frequency, &damping);
+            type = (pbio_shaper_type_t)value;
+            _motor1.set_input_shaper(type, frequency, damping);
+
+            _motor2.get_input_shaper(&type, &frequency, &damping);
+            type = (pbio_shaper_type_t)value;
+            _motor2.set_input_shaper(type, frequency, damping);
+        }
+
+        const char* getName() const override {
+            return "shaper";
+        }
+
+        const char* getTitle() const override {
+            return "Input shaper";
+        }
+
+        const char* getDescription() const override {
+            return "Shape the move reference so the arm does not oscillate at the end of the move: 0 off, 1 ZV, 2 ZVD. ZVD is robust to a wrong frequency but delays the end of the move by a whole oscillation period";
+        }
+
+        const char* getUnit() const override {
+            return "";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const uint8_t getMinValue() const override {
+            return PBIO_SHAPER_NONE;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const uint8_t getMaxValue() const override {
+            return PBIO_SHAPER_ZVD;
+        }
+    };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelShaperDampingSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelShaperDampingSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            pbio_shaper_type_t type;
+            float frequency;
+            float damping;
+
+            _motor1.get_input_shaper(&type, &frequency, &damping);
+            return damping;
+        }
+
+        void setValue(const float value) override {
+            pbio_shaper_type_t type;
+            float frequency;
+            float damping;
+
+            _motor1.get_input_shaper(&type, &frequency, &damping);
+            damping = value;
+            _motor1.set_input_shaper(type, frequency, damping);
+
+            _motor2.get_input_shaper(&type, &frequency, &damping);
+            damping = value;
+            _motor2.set_input_shaper(type, frequency, damping);
+        }
+
+        const char* getName() const override {
+            return "shaper_damping";
+        }
+
+        const char* getTitle() const override {
+            return "Input shaper damping";
+        }
+
+        const char* getDescription() const override {
+            return "Damping ratio of the arm oscillation to suppress. Zero for an oscillation that doesn't decay";
+        }
+
+        const char* getUnit() const override {
+            return "";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 0.0;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return PBIO_SHAPER_MAX_DAMPING;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.01;
+        }
+    };
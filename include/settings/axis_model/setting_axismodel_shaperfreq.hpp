@@ -0,0 +1,76 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelShaperFreqSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelShaperFreqSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            pbio_shaper_type_t type;
+            float frequency;
+            float damping;
+
+            _motor1.get_input_shaper(&type, &frequency, &damping);
+            return frequency;
+        }
+
+        void setValue(const float value) override {
+            pbio_shaper_type_t type;
+            float frequency;
+            float damping;
+
+            _motor1.get_input_shaper(&type, &frequency, &damping);
+            frequency = value;
+            _motor1.set_input_shaper(type, frequency, damping);
+
+            _motor2.get_input_shaper(&type, &frequency, &damping);
+            frequency = value;
+            _motor2.set_input_shaper(type, frequency, damping);
+        }
+
+        const char* getName() const override {
+            return "shaper_freq";
+        }
+
+        const char* getTitle() const override {
+            return "Input shaper frequency";
+        }
+
+        const char* getDescription() const override {
+            return "Frequency of the arm oscillation to suppress, as seen in the step response log after the move";
+        }
+
+        const char* getUnit() const override {
+            return "Hz";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return PBIO_SHAPER_MIN_FREQUENCY;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return PBIO_SHAPER_MAX_FREQUENCY;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.1;
+        }
+    };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "motor_control\motor.hpp"
+#include "settings\setting.hpp"
+
+class AxisModelTimeConstNegSetting : public SettingFloat {
+    private:
+        Motor& _motor1;
+        Motor& _motor2;
+
+    public:
+        AxisModelTimeConstNegSetting(Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) {}
+
+        float getValue() const override {
+            float gain_pos;
+            float gain_neg;
+            float time_constant_pos;
+            float time_constant_neg;
+            float coulomb;
+            float viscous;
+            float gravity;
+
+            _motor1.get_model(&gain_pos, &gain_neg, &time_constant_pos, &time_constant_neg, &coulomb, &viscous, &gravity);
+            return time_constant_neg;
+        }
+
+        void setValue(const float value) override {
+            float gain_pos;
+            float gain_neg;
+            float time_constant_pos;
+            float time_constant_neg;
+            float coulomb;
+            float viscous;
+            float gravity;
+
+            _motor1.get_model(&gain_pos, &gain_neg, &time_constant_pos, &time_constant_neg, &coulomb, &viscous, &gravity);
+            time_constant_neg = value;
+            _motor1.set_model(gain_pos, gain_neg, time_constant_pos, time_constant_neg, coulomb, viscous, gravity);
+
+            _motor2.get_model(&gain_pos, &gain_neg, &time_constant_pos, &time_constant_neg, &coulomb, &viscous, &gravity);
+            time_constant_neg = value;
+            _motor2.set_model(gain_pos, gain_neg, time_constant_pos, time_constant_neg, coulomb, viscous, gravity);
+        }
+
+        const char* getName() const override {
+            return "tau_neg";
+        }
+
+        const char* getTitle() const override {
+            return "Time constant (negative)";
+        }
+
+        const char* getDescription() const override {
+            return "Time needed to reach 63% of the steady state speed while moving in negative direction";
+        }
+
+        const char* getUnit() const override {
+            return "s";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 0.0;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 5.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.001;
+        }
+    };
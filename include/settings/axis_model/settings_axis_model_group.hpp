@@ -0,0 +1,81 @@
+#include "settings/setting.hpp"
+#include "settings/settings_group.hpp"
+#include "setting_axismodel_gainpos.hpp"
+#include "setting_axismodel_gainneg.hpp"
+#include "setting_axismodel_timeconstpos.hpp"
+#include "setting_axismodel_timeconstneg.hpp"
+#include "setting_axismodel_coulomb.hpp"
+#include "setting_axismodel_viscous.hpp"
+#include "setting_axismodel_gravity.hpp"
+#include "setting_axismodel_collision.hpp"
+#include "setting_axismodel_collthreshold.hpp"
+#include "setting_axismodel_collticks.hpp"
+#include "setting_axismodel_collreaction.hpp"
+#include "setting_axismodel_observer.hpp"
+#include "setting_axismodel_observerbw.hpp"
+#include "setting_axismodel_learning.hpp"
+#include "setting_axismodel_learninggain.hpp"
+#include "setting_axismodel_learninglead.hpp"
+#include "setting_axismodel_lqr.hpp"
+#include "setting_axismodel_lqrposerr.hpp"
+#include "setting_axismodel_lqrspeederr.hpp"
+#include "setting_axismodel_lqrinterr.hpp"
+#include "setting_axismodel_shaper.hpp"
+#include "setting_axismodel_shaperfreq.hpp"
+#include "setting_axismodel_shaperdamping.hpp"
+#include "motor_control\motor.hpp"
+
+class SettingsAxisModelGroup : public SettingsGroup {
+    private:
+        const char* _name;
+        const char* _title;
+
+        Motor& _motor1;
+        Motor& _motor2;
+        AxisModelGainPosSetting _gainPos = AxisModelGainPosSetting(_motor1, _motor2);
+        AxisModelGainNegSetting _gainNeg = AxisModelGainNegSetting(_motor1, _motor2);
+        AxisModelTimeConstPosSetting _timeConstPos = AxisModelTimeConstPosSetting(_motor1, _motor2);
+        AxisModelTimeConstNegSetting _timeConstNeg = AxisModelTimeConstNegSetting(_motor1, _motor2);
+        AxisModelCoulombSetting _coulomb = AxisModelCoulombSetting(_motor1, _motor2);
+        AxisModelViscousSetting _viscous = AxisModelViscousSetting(_motor1, _motor2);
+        AxisModelGravitySetting _gravity = AxisModelGravitySetting(_motor1, _motor2);
+        AxisModelCollisionSetting _collision = AxisModelCollisionSetting(_motor1, _motor2);
+        AxisModelCollisionThresholdSetting _collThreshold = AxisModelCollisionThresholdSetting(_motor1, _motor2);
+        AxisModelCollisionTicksSetting _collTicks = AxisModelCollisionTicksSetting(_motor1, _motor2);
+        AxisModelCollisionReactionSetting _collReaction = AxisModelCollisionReactionSetting(_motor1, _motor2);
+        AxisModelObserverSetting _observer = AxisModelObserverSetting(_motor1, _motor2);
+        AxisModelObserverBandwidthSetting _observerBandwidth = AxisModelObserverBandwidthSetting(_motor1, _motor2);
+        AxisModelLearningSetting _learning = AxisModelLearningSetting(_motor1, _motor2);
+        AxisModelLearningGainSetting _learningGain = AxisModelLearningGainSetting(_motor1, _motor2);
+        AxisModelLearningLeadSetting _learningLead = AxisModelLearningLeadSetting(_motor1, _motor2);
+        AxisModelLqrSetting _lqr = AxisModelLqrSetting(_motor1, _motor2);
+        AxisModelLqrPosErrSetting _lqrPosErr = AxisModelLqrPosErrSetting(_motor1, _motor2);
+        AxisModelLqrSpeedErrSetting _lqrSpeedErr = AxisModelLqrSpeedErrSetting(_motor1, _motor2);
+        AxisModelLqrIntErrSetting _lqrIntErr = AxisModelLqrIntErrSetting(_motor1, _motor2);
+        AxisModelShaperSetting _shaper = AxisModelShaperSetting(_motor1, _motor2);
+        AxisModelShaperFreqSetting _shaperFreq = AxisModelShaperFreqSetting(_motor1, _motor2);
+        AxisModelShaperDampingSetting _shaperDamping = AxisModelShaperDampingSetting(_motor1, _motor2);
+
+        ISetting* _settings[23] = {
+            &_gainPos, &_gainNeg, 
+            &_timeConstPos, &_timeConstNeg, 
+            &_coulomb, &_viscous, &_gravity,
+            &_collision, &_collThreshold, &_collTicks, &_collReaction,
+            &_observer, &_observerBandwidth,
+            &_learning, &_learningGain, &_learningLead,
+            &_lqr, &_lqrPosErr, &_lqrSpeedErr, &_lqrIntErr,
+            &_shaper, &_shaperFreq, &_shaperDamping
+        };
+
+    public:
+        SettingsAxisModelGroup(const char* name, const char* title, Motor& motor1, Motor& motor2);
+
+        const char* getName() const;
+        const char* getTitle() const;
+
+        ISetting** getSettings();
+
+        uint16_t getSettingsCount() const {
+            return sizeof(_settings) / sizeof(ISetting*);
+        }
+};
\ No newline at end of file
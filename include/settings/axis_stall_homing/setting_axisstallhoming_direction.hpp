@@ -0,0 +1,32 @@
+#pragma once
+
+#include "motor_control\motorwithstallreference.hpp"
+#include "settings\setting.hpp"
+
+class AxisStallHomingDirectionSetting : public SettingBool {
+    private:
+        stall_homing_config_t& _config;
+
+    public:
+        AxisStallHomingDirectionSetting(stall_homing_config_t& config) : _config(config) {}
+
+        bool getValue() const override {
+            return _config.start_in_positive_direction;
+        }
+
+        void setValue(const bool value) override {
+            _config.start_in_positive_direction = value;
+        }
+
+        const char* getName() const override {
+            return "positive_dir";
+        }
+
+        const char* getTitle() const override {
+            return "Home in positive direction";
+        }
+
+        const char* getDescription() const override {
+            return "Move toward the reference obstacle in the positive direction of the axis";
+        }
+    };
@@ -1,5 +1,6 @@
 #include "settings/setting.hpp"
 #include "settings/settings_group.hpp"
+#include "setting_axisstallhoming_direction.hpp"
 #include "setting_axisstallhoming_speed.hpp"
 #include "setting_axisstallhoming_dutylimit.hpp"
 #include "setting_axisstallhoming_minimumtravel.hpp"
@@ -11,16 +12,17 @@ class SettingsAxisStallHomingGroup : public SettingsGroup {
         const char* _name;
         const char* _description;
 
-        MotorWithStallReference& _motor;
-        AxisStallHomingSpeedSetting _speed = AxisStallHomingSpeedSetting(*_motor.config());
-        AxisStallHomingDutyLimitSetting _dutyLimit = AxisStallHomingDutyLimitSetting(*_motor.config());
-        AxisStallHomingMinimumTravelSetting _minimumTravel = AxisStallHomingMinimumTravelSetting(*_motor.config());
-        AxisStallHomingHomeObstaclePosSetting _homeObstaclePos = AxisStallHomingHomeObstaclePosSetting(*_motor.config());
+        stall_homing_config_t& _config;
+        AxisStallHomingDirectionSetting _direction = AxisStallHomingDirectionSetting(_config);
+        AxisStallHomingSpeedSetting _speed = AxisStallHomingSpeedSetting(_config);
+        AxisStallHomingDutyLimitSetting _dutyLimit = AxisStallHomingDutyLimitSetting(_config);
+        AxisStallHomingMinimumTravelSetting _minimumTravel = AxisStallHomingMinimumTravelSetting(_config);
+        AxisStallHomingHomeObstaclePosSetting _homeObstaclePos = AxisStallHomingHomeObstaclePosSetting(_config);
 
-        ISetting* _settings[5] = {&_speed, &_dutyLimit, &_minimumTravel, &_homeObstaclePos};
+        ISetting* _settings[5] = {&_direction, &_speed, &_dutyLimit, &_minimumTravel, &_homeObstaclePos};
 
     public:
-        SettingsAxisStallHomingGroup(const char* name, const char* description, MotorWithStallReference& motor);
+        SettingsAxisStallHomingGroup(const char* name, const char* description, stall_homing_config_t& config);
 
         const char* getName() const;
         const char* getTitle() const;
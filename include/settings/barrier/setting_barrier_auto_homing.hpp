@@ -0,0 +1,32 @@
+#pragma once
+
+#include "barrier_config.h"
+#include "settings\setting.hpp"
+
+class BarrierAutoHomingSetting : public SettingBool {
+    private:
+        barrier_config_t& _config;
+
+    public:
+        BarrierAutoHomingSetting(barrier_config_t& config) : _config(config) {}
+
+        bool getValue() const override {
+            return _config.auto_homing;
+        }
+
+        void setValue(const bool value) override {
+            _config.auto_homing = value;
+        }
+
+        const char* getName() const override {
+            return "auto_homing";
+        }
+
+        const char* getTitle() const override {
+            return "Automatic homing";
+        }
+
+        const char* getDescription() const override {
+            return "At power-up, home the gantry by stalling both motors against the end stop instead of the manual homing with the knob";
+        }
+    };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "barrier_config.h"
+#include "settings\setting.hpp"
+
+class BarrierLoweringAccelerationSetting : public SettingFloat {
+    private:
+        barrier_config_t& _config;
+
+    public:
+        BarrierLoweringAccelerationSetting(barrier_config_t& config) : _config(config) {}
+
+        float getValue() const override {
+            return _config.barrier_lower_acceleration;
+        }
+
+        void setValue(const float value) override {
+            _config.barrier_lower_acceleration = value;
+        }
+
+        const char* getName() const override {
+            return "lowering_accel";
+        }
+
+        const char* getTitle() const override {
+            return "Barrier lowering acceleration";
+        }
+
+        const char* getDescription() const override {
+            return "Axis acceleration used to lower the barrier, capped by the axis acceleration limit. Zero to use the limit";
+        }
+
+        const char* getUnit() const override {
+            return "deg/s^2";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 0.0;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 50000.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 50.0;
+        }
+    };
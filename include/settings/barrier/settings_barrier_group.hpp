@@ -1,11 +1,14 @@
 #include "settings/setting.hpp"
 #include "settings/settings_group.hpp"
+#include "setting_barrier_auto_homing.hpp"
 #include "setting_barrier_homing_speed.hpp"
 #include "setting_barrier_homing_jog_multiplier.hpp"
 #include "barrier_config.h"
 #include "setting_barrier_lowering_speed.hpp"
 #include "setting_barrier_raising_speed.hpp"
 #include "setting_barrier_raising_power.hpp"
+#include "setting_barrier_lowering_acceleration.hpp"
+#include "setting_barrier_raising_acceleration.hpp"
 #include "setting_barrier_hold_time.hpp"
 
 class SettingsBarrierGroup : public SettingsGroup {
@@ -15,16 +18,20 @@ class SettingsBarrierGroup : public SettingsGroup {
 
         barrier_config_t& _config;
 
+        BarrierAutoHomingSetting _auto_homing = BarrierAutoHomingSetting(_config);
         BarrierHomingSpeedSetting _speed = BarrierHomingSpeedSetting(_config);
         BarrierJogMultiplierSetting _jog_multiplier = BarrierJogMultiplierSetting(_config);
         BarrierLoweringSpeedSetting _lowering_speed = BarrierLoweringSpeedSetting(_config);
         BarrierRaisingSpeedSetting _raising_speed = BarrierRaisingSpeedSetting(_config);
         BarrierRaisingPowerSetting _raising_power = BarrierRaisingPowerSetting(_config);
+        BarrierLoweringAccelerationSetting _lowering_acceleration = BarrierLoweringAccelerationSetting(_config);
+        BarrierRaisingAccelerationSetting _raising_acceleration = BarrierRaisingAccelerationSetting(_config);
         BarrierHoldTimeSetting _hold_time = BarrierHoldTimeSetting(_config);
 
-        ISetting* _settings[6] = {
-            &_speed, &_jog_multiplier,
+        ISetting* _settings[9] = {
+            &_auto_homing, &_speed, &_jog_multiplier,
             &_lowering_speed, &_raising_speed, &_raising_power, 
+            &_lowering_acceleration, &_raising_acceleration,
             &_hold_time};
 
     public:
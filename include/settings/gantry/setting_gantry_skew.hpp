@@ -0,0 +1,60 @@
+#pragma once
+
+#include "motor_control\gantrymotor.hpp"
+#include "settings\setting.hpp"
+
+class GantrySkewSetting : public SettingFloat {
+    private:
+        GantryMotor& _motor;
+
+    public:
+        GantrySkewSetting(GantryMotor& motor) : _motor(motor) {}
+
+        float getValue() const override {
+            return _motor.getHomedSkew();
+        }
+
+        void setValue(const float value) override {
+            _motor.setHomedSkew(value);
+        }
+
+        const char* getName() const override {
+            return "skew";
+        }
+
+        const char* getTitle() const override {
+            return "Gantry skew compensation";
+        }
+
+        const char* getDescription() const override {
+            return "Position offset of the second motor, referred to the homed reference, that keeps the gantry square. It is applied once the axis is homed and updated by the skew learning";
+        }
+
+        const char* getUnit() const override {
+            return "deg";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return -45.0;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 45.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.1;
+        }
+    };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "motor_control\gantrymotor.hpp"
+#include "settings\setting.hpp"
+
+class GantrySkewAlarmSetting : public SettingFloat {
+    private:
+        GantryMotor& _motor;
+
+    public:
+        GantrySkewAlarmSetting(GantryMotor& motor) : _motor(motor) {}
+
+        float getValue() const override {
+            return _motor.getSkewAlarmThreshold();
+        }
+
+        void setValue(const float value) override {
+            _motor.setSkewAlarmThreshold(value);
+        }
+
+        const char* getName() const override {
+            return "skew_alarm";
+        }
+
+        const char* getTitle() const override {
+            return "Skew alarm threshold";
+        }
+
+        const char* getDescription() const override {
+            return "Maximum deviation between the measured and the compensated gantry skew before raising a skew alarm";
+        }
+
+        const char* getUnit() const override {
+            return "deg";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 0.5;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 45.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.1;
+        }
+    };
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "motor_control\gantrymotor.hpp"
+#include "settings\setting.hpp"
+
+class GantrySkewLearningSetting : public SettingBool {
+    private:
+        GantryMotor& _motor;
+
+    public:
+        GantrySkewLearningSetting(GantryMotor& motor) : _motor(motor) {}
+
+        bool getValue() const override {
+            return _motor.getSkewLearning();
+        }
+
+        void setValue(const bool value) override {
+            _motor.setSkewLearning(value);
+        }
+
+        const char* getName() const override {
+            return "skew_learning";
+        }
+
+        const char* getTitle() const override {
+            return "Skew learning";
+        }
+
+        const char* getDescription() const override {
+            return "Continuously estimate the gantry skew from the change of the effort balance between the two motors since the homing, while the axis holds or moves slowly";
+        }
+    };
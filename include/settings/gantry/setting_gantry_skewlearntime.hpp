@@ -0,0 +1,60 @@
+#pragma once
+
+#include "motor_control\gantrymotor.hpp"
+#include "settings\setting.hpp"
+
+class GantrySkewLearnTimeSetting : public SettingFloat {
+    private:
+        GantryMotor& _motor;
+
+    public:
+        GantrySkewLearnTimeSetting(GantryMotor& motor) : _motor(motor) {}
+
+        float getValue() const override {
+            return _motor.getSkewLearnTime();
+        }
+
+        void setValue(const float value) override {
+            _motor.setSkewLearnTime(value);
+        }
+
+        const char* getName() const override {
+            return "skew_learn_time";
+        }
+
+        const char* getTitle() const override {
+            return "Skew learning time constant";
+        }
+
+        const char* getDescription() const override {
+            return "Time constant of the skew estimator. Higher values give a more stable but slower estimate";
+        }
+
+        const char* getUnit() const override {
+            return "s";
+        }
+
+        const bool hasMinValue() const override {
+            return true;
+        }
+
+        const float getMinValue() const override {
+            return 0.5;
+        }
+
+        const bool hasMaxValue() const override {
+            return true;
+        }
+
+        const float getMaxValue() const override {
+            return 60.0;
+        }
+
+        const bool hasChangeStep() const override {
+            return true;
+        }
+
+        const float getChangeStep() const override {
+            return 0.5;
+        }
+    };
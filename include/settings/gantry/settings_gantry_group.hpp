@@ -0,0 +1,36 @@
+#include "settings/setting.hpp"
+#include "settings/settings_group.hpp"
+#include "setting_gantry_skew.hpp"
+#include "setting_gantry_skewlearning.hpp"
+#include "setting_gantry_skewlearntime.hpp"
+#include "setting_gantry_skewalarm.hpp"
+#include "motor_control\gantrymotor.hpp"
+
+class SettingsGantryGroup : public SettingsGroup {
+    private:
+        const char* _name;
+        const char* _title;
+
+        GantryMotor& _motor;
+        GantrySkewSetting _skew = GantrySkewSetting(_motor);
+        GantrySkewLearningSetting _skewLearning = GantrySkewLearningSetting(_motor);
+        GantrySkewLearnTimeSetting _skewLearnTime = GantrySkewLearnTimeSetting(_motor);
+        GantrySkewAlarmSetting _skewAlarm = GantrySkewAlarmSetting(_motor);
+
+        ISetting* _settings[4] = {
+            &_skew, &_skewLearning, &_skewLearnTime, 
+            &_skewAlarm
+        };
+
+    public:
+        SettingsGantryGroup(const char* name, const char* title, GantryMotor& motor);
+
+        const char* getName() const;
+        const char* getTitle() const;
+
+        ISetting** getSettings();
+
+        uint16_t getSettingsCount() const {
+            return sizeof(_settings) / sizeof(ISetting*);
+        }
+};
\ No newline at end of file
@@ -8,23 +8,36 @@
 #include "barrier_config.h"
 #include "axis/settings_axis_group.hpp"
 #include "barrier/settings_barrier_group.hpp"
+#include "gantry/settings_gantry_group.hpp"
+#include "axis_model/settings_axis_model_group.hpp"
+#include "axis_stall_homing/settings_axis_stall_homing_group.hpp"
 
 class Settings {
     private:
         GantryMotor& _XMotor;
         Motor& _X1Motor;
         Motor& _X2Motor;
+        Motor& _LMotor;
+        Motor& _RMotor;
+        stall_homing_config_t& _xStallHomingConfig;
         barrier_config_t& _barrierConfig;
 
         SettingsAxisGroup _xSettings = SettingsAxisGroup("x_axis", "X Axis", _X1Motor, _X2Motor);
+        SettingsGantryGroup _xGantrySettings = SettingsGantryGroup("x_gantry", "X Gantry", _XMotor);
+        SettingsAxisModelGroup _xModelSettings = SettingsAxisModelGroup("x_model", "X Axis Model", _X1Motor, _X2Motor);
+        SettingsAxisStallHomingGroup _xStallHomingSettings = SettingsAxisStallHomingGroup("x_stall_homing", "X Axis Stall Homing", _xStallHomingConfig);
+        SettingsAxisGroup _lSettings = SettingsAxisGroup("l_axis", "L Axis", _LMotor, _LMotor);
+        SettingsAxisGroup _rSettings = SettingsAxisGroup("r_axis", "R Axis", _RMotor, _RMotor);
         SettingsBarrierGroup _barrierSettings = SettingsBarrierGroup("barrier", "Barrier Settings", _barrierConfig);
 
-        SettingsGroup* _groups[2] = { &_xSettings, &_barrierSettings };
+        SettingsGroup* _groups[7] = { &_xSettings, &_xGantrySettings, &_xModelSettings, &_xStallHomingSettings, &_lSettings, &_rSettings, &_barrierSettings };
         uint16_t _groupsCount = sizeof(_groups) / sizeof(SettingsGroup*);
         
     public:
-        Settings(GantryMotor& xMotor, barrier_config_t& barrierConfig) 
-            : _XMotor(xMotor), _X1Motor(xMotor.motor1()), _X2Motor(xMotor.motor2()), _barrierConfig(barrierConfig)
+        // The single motor axes use the axis settings group with the same motor twice
+        Settings(GantryMotor& xMotor, Motor& lMotor, Motor& rMotor, stall_homing_config_t& xStallHomingConfig, barrier_config_t& barrierConfig) 
+            : _XMotor(xMotor), _X1Motor(xMotor.motor1()), _X2Motor(xMotor.motor2()), _LMotor(lMotor), _RMotor(rMotor), 
+              _xStallHomingConfig(xStallHomingConfig), _barrierConfig(barrierConfig)
         {            
         }
 
@@ -34,5 +47,9 @@ class Settings {
         uint16_t getGroupsCount() const;
 
         void storeInNVS();
+        void storeInNVS(const char* groupName);
+        void storeFeedforwardInNVS();
+        void storeLearningInNVS();
         void restoreFromNVS();
+        void restoreTablesFromNVS();
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <Arduino.h>
+
+/**
+ * Phases of the startup, in the order setup() starts them
+ */
+enum class BootPhase : uint8_t {
+    Io,             // Pins, board LED and start button LED
+    I2C,            // I2C busses and knob encoder
+    Motors,         // Supply sampling and motors begin
+    Settings,       // Settings restore from NVS
+    MotorTask,      // Motor loop task start
+    WiFi,           // WiFi connection
+    LittleFS,       // LittleFS mount
+    Server,         // Web server start
+    Homing,         // Position restore or homing
+    Count
+};
+
+/**
+ * Start and end times of the startup phases, since the power-up (us)
+ *
+ * Phases can run in different tasks at the same time, each one only writes its own times.
+ */
+class BootProfile {
+public:
+    // Get the singleton instance
+    static BootProfile& instance() {
+        static BootProfile profile_instance;
+        return profile_instance;
+    }
+
+    BootProfile(const BootProfile&) = delete;
+    BootProfile& operator=(const BootProfile&) = delete;
+
+    void start(BootPhase phase);
+    void end(BootPhase phase);
+    void ready();
+
+    static const char* name(BootPhase phase);
+
+    // Zero when the phase didn't start or end yet
+    uint32_t startTime(BootPhase phase) const {
+        return _start[(uint8_t)phase];
+    }
+
+    uint32_t endTime(BootPhase phase) const {
+        return _end[(uint8_t)phase];
+    }
+
+    // Time the barrier is ready to run, zero until then
+    uint32_t readyTime() const {
+        return _ready;
+    }
+
+private:
+    BootProfile() {}
+
+    volatile uint32_t _start[(uint8_t)BootPhase::Count] = {};
+    volatile uint32_t _end[(uint8_t)BootPhase::Count] = {};
+    volatile uint32_t _ready = 0;
+};
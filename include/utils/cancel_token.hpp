@@ -3,6 +3,9 @@
 #include <vector>
 #include <algorithm>
 #include <mutex>
+#include <utility>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
 
 // Usage:
 // EXECUTE_IF_CANCELLED(token, {
@@ -20,6 +23,9 @@ private:
     static std::vector<CancelToken*> instances;
     static std::mutex instancesMutex;
     bool cancelled = false;
+    std::vector<std::pair<EventGroupHandle_t, EventBits_t>> subscribers;
+
+    void notify();
 
 public:
     CancelToken();
@@ -29,5 +35,9 @@ public:
     bool isCancelled() const;
     void cancel();
 
+    // Set the bits in the event group when the token is cancelled, to wake up a task blocked on it
+    void subscribe(EventGroupHandle_t group, EventBits_t bits);
+    void unsubscribe(EventGroupHandle_t group);
+
     static void cancelAll();
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+#include "esp_system.h"
+#include "motor_control/gantrymotor.hpp"
+#include "config.h"
+
+#define WARM_BOOT_MAGIC             (0x57424f54)    // "WBOT"
+#define WARM_BOOT_MOVING            (0x4d4f5645)    // "MOVE", the axis moved since the last snapshot
+#define WARM_BOOT_FIRMWARE_BYTES    (8)             // Bytes of the firmware ELF hash kept in the snapshot
+#define WARM_BOOT_STILL_SPEED       (1.0f)          // Highest speed of an axis at standstill (deg/s)
+#define WARM_BOOT_STILL_TICKS       (20)            // Standstill before the position is saved (control periods)
+#define WARM_BOOT_REFRESH_TICKS     (150)           // Refresh period of the saved position at standstill (control periods)
+
+/**
+ * Position of the gantry at standstill, saved to be restored after a reset
+ */
+typedef struct _warm_boot_snapshot_t {
+    uint32_t magic;                                 // WARM_BOOT_MAGIC when the snapshot is valid, WARM_BOOT_MOVING once the axis moves
+    uint8_t firmware[WARM_BOOT_FIRMWARE_BYTES];     // Firmware that saved the snapshot
+    float angle1;                                   // Angle of motor 1 (deg)
+    float angle2;                                   // Angle of motor 2 (deg)
+    float skew_compensation;                        // Skew compensation in use (deg)
+    float hold_duty;                                // Largest duty of the two motors to hold the position (%)
+    uint32_t crc;                                   // CRC of the fields above
+} warm_boot_snapshot_t;
+
+/**
+ * Restores the gantry position after a soft reset, so the barrier is ready without homing.
+ *
+ * The motor loop keeps a snapshot of the position in RTC memory, which survives the soft resets,
+ * while the axis holds still, and marks it as moving as soon as the axis moves. The snapshot
+ * isn't kept in flash: a power cycle loses the RTC memory, and it also lets the axis drop, so
+ * the position can't be restored after it anyway.
+ *
+ * The motors coast through any reset and the bootloader, so a drop at that time can't be seen.
+ * The snapshot is therefore restored only after a software reset, when the axis was held
+ * without a load that could move it, the snapshot was saved by the same firmware and the
+ * encoders don't move while the firmware starts.
+ */
+class WarmBoot {
+    private:
+        GantryMotor& _motor;
+        portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+        // Boot state
+        esp_reset_reason_t _reset_reason = ESP_RST_UNKNOWN;
+        warm_boot_snapshot_t _boot = {};
+        bool _boot_valid = false;
+        float _boot_count1 = 0.0f;
+        float _boot_count2 = 0.0f;
+        uint32_t _begin_time = 0;
+        bool _restored = false;
+
+        // Motor loop state
+        uint32_t _still_ticks = 0;
+
+        bool isStill();
+        void take(warm_boot_snapshot_t* snapshot);
+        const char* check();
+
+    public:
+        WarmBoot(GantryMotor& motor) : _motor(motor) {}
+
+        void begin();
+        bool restore();
+        void homed();
+
+        void update();
+
+        bool restored() const {
+            return _restored;
+        }
+
+        esp_reset_reason_t resetReason() const {
+            return _reset_reason;
+        }
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "web_functions/web_function.hpp"
+#include "motor_control/gantrymotor.hpp"
+#include "motor_control/logger.hpp"
+#include "utils/task_runner.hpp"
+#include "utils/cancel_token.hpp"
+#include "utils/logger.hpp"
+#include "config.h"
+#include "monotonic.h"
+
+#define AUTOTUNE_LOG_DURATION_MS (20000)
+#define AUTOTUNE_SETTLE_TIME_MS (1000)
+#define AUTOTUNE_RELAY_DUTY (20.0f)             // Relay amplitude applied around the holding duty (%)
+#define AUTOTUNE_RELAY_HYSTERESIS (1.0f)        // Relay switching hysteresis (deg)
+#define AUTOTUNE_WARMUP_CYCLES (2)              // Oscillations discarded before measuring
+#define AUTOTUNE_MEASURE_CYCLES (4)             // Oscillations used to measure the ultimate gain and period
+#define AUTOTUNE_TIMEOUT_MS (15000)
+#define AUTOTUNE_RESULTS_COUNT (5)
+
+class WebFunctionAxisAutoTune : public WebFunction{
+private:
+    GantryMotor& _axis;
+    TaskRunner& _taskRunner;
+    TaskHandle_t _taskHandle = nullptr;
+    CancelToken* _cancelToken = nullptr;
+
+    bool _hasResult = false;
+    float _results[AUTOTUNE_RESULTS_COUNT];
+
+    const char* runRelayExperiment(float center, float* amplitude, float* period, CancelToken& cancel_token);
+    void computeGains(float amplitude, float period);
+
+public:
+    WebFunctionAxisAutoTune(GantryMotor& axis, TaskRunner& taskRunner) : _axis(axis), _taskRunner(taskRunner) {};
+
+    // Override methods as needed
+    const char* getName() const override;
+    const char* getTitle() const override;
+    const char* getDescription() const override;
+    uint16_t getPrerequisitesCount() const override;
+    const char* getPrerequisiteDescription(uint16_t index) const override;
+
+    void arePrerequisitesMet(bool* results) const override;
+    WebFunctionExecutionStatus start() override;
+    void stop() override;
+
+    bool hasResult() const override {
+        return _hasResult;
+    }
+
+    uint16_t getResultsCount() const override {
+        return AUTOTUNE_RESULTS_COUNT;
+    }
+
+    const char* getResultName(uint16_t index) const override;
+    const char* getResultUnit(uint16_t index) const override;
+    float getResultValue(uint16_t index) const override;
+    bool saveResult() override;
+    void discardResult() override;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "web_functions/web_function.hpp"
+#include "motor_control/gantrymotor.hpp"
+#include "utils/task_runner.hpp"
+#include "utils/cancel_token.hpp"
+#include "utils/logger.hpp"
+#include "config.h"
+
+#define CTLCOMPARE_RESULTS_COUNT (11)
+
+class WebFunctionAxisControlCompare : public WebFunction{
+private:
+    GantryMotor& _axis;
+    TaskRunner& _taskRunner;
+    TaskHandle_t _taskHandle = nullptr;
+
+    bool _hasResult = false;
+    float _results[CTLCOMPARE_RESULTS_COUNT];
+
+    void storeResults(uint8_t offset, const pbio_simulation_result_t& result, float counts_per_unit);
+
+public:
+    WebFunctionAxisControlCompare(GantryMotor& axis, TaskRunner& taskRunner) : _axis(axis), _taskRunner(taskRunner) {};
+
+    // Override methods as needed
+    const char* getName() const override;
+    const char* getTitle() const override;
+    const char* getDescription() const override;
+    uint16_t getPrerequisitesCount() const override;
+    const char* getPrerequisiteDescription(uint16_t index) const override;
+
+    void arePrerequisitesMet(bool* results) const override;
+    WebFunctionExecutionStatus start() override;
+    void stop() override;
+
+    bool hasResult() const override {
+        return _hasResult;
+    }
+
+    uint16_t getResultsCount() const override {
+        return CTLCOMPARE_RESULTS_COUNT;
+    }
+
+    const char* getResultName(uint16_t index) const override;
+    const char* getResultUnit(uint16_t index) const override;
+    float getResultValue(uint16_t index) const override;
+    bool saveResult() override;
+    void discardResult() override;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "web_functions/web_function.hpp"
+#include "motor_control/gantrymotor.hpp"
+#include "utils/task_runner.hpp"
+#include "utils/cancel_token.hpp"
+#include "utils/logger.hpp"
+#include "config.h"
+
+#define FFCAL_SETTLE_TIME_MS (500)
+#define FFCAL_SWEEP_SPEED (10.0f)           // Speed of the calibration sweeps (deg/s)
+#define FFCAL_SPEED_TOLERANCE (0.3f)        // Relative speed deviation of the samples taken at constant speed
+#define FFCAL_RESULTS_COUNT (4)
+
+class WebFunctionAxisFeedforwardCal : public WebFunction{
+private:
+    GantryMotor& _axis;
+    TaskRunner& _taskRunner;
+    TaskHandle_t _taskHandle = nullptr;
+    CancelToken* _cancelToken = nullptr;
+
+    // Duty sums and samples per motor, direction and table point
+    float _dutySum[2][2][PBIO_CONTROL_FF_TABLE_POINTS];
+    uint16_t _samples[2][2][PBIO_CONTROL_FF_TABLE_POINTS];
+
+    pbio_control_ff_table_t _oldTables[2];
+    pbio_control_ff_table_t _tables[2];
+
+    bool _hasResult = false;
+    float _results[FFCAL_RESULTS_COUNT];
+
+    Motor& motor(uint8_t index) {
+        return index == 0 ? _axis.motor1() : _axis.motor2();
+    }
+
+    const char* sweep(float target, uint8_t direction, float start, float step, float motor2_offset, CancelToken& cancel_token);
+    const char* buildTables(float start, float step, float motor2_offset);
+    void restoreTables();
+
+public:
+    WebFunctionAxisFeedforwardCal(GantryMotor& axis, TaskRunner& taskRunner) : _axis(axis), _taskRunner(taskRunner) {};
+
+    // Override methods as needed
+    const char* getName() const override;
+    const char* getTitle() const override;
+    const char* getDescription() const override;
+    uint16_t getPrerequisitesCount() const override;
+    const char* getPrerequisiteDescription(uint16_t index) const override;
+
+    void arePrerequisitesMet(bool* results) const override;
+    WebFunctionExecutionStatus start() override;
+    void stop() override;
+
+    bool hasResult() const override {
+        return _hasResult;
+    }
+
+    uint16_t getResultsCount() const override {
+        return FFCAL_RESULTS_COUNT;
+    }
+
+    const char* getResultName(uint16_t index) const override;
+    const char* getResultUnit(uint16_t index) const override;
+    float getResultValue(uint16_t index) const override;
+    bool saveResult() override;
+    void discardResult() override;
+
+    bool savesFeedforward() const override {
+        return true;
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "web_functions/web_function.hpp"
+#include "motor_control/gantrymotor.hpp"
+#include "motor_control/logger.hpp"
+#include "motor_control/macros.h"
+#include "barrier_config.h"
+#include "utils/task_runner.hpp"
+#include "utils/cancel_token.hpp"
+#include "utils/logger.hpp"
+#include "config.h"
+
+#define PROFILECAL_SETTLE_TIME_MS (500)
+#define PROFILECAL_MAX_DRIVE_MS (5000)      // Longest open loop drive before the end of the travel is considered not reached
+#define PROFILECAL_MAX_STOP_MS (3000)       // Longest wait for the axis to stop at the end of the travel
+#define PROFILECAL_BRAKE_MARGIN (1.5f)      // Margin on the braking distance at the end of the open loop drive
+#define PROFILECAL_END_MARGIN (5.0f)        // Distance from the end of the travel where the open loop drive ends at the latest (deg)
+#define PROFILECAL_SPEED_MARGIN (0.8f)      // Fraction of the measured top speed used by the profiles
+#define PROFILECAL_ACCEL_MARGIN (0.8f)      // Fraction of the measured acceleration used by the profiles
+#define PROFILECAL_RESULTS_COUNT (9)
+
+/**
+ * Measured capability of the axis in a direction of motion
+ */
+typedef struct _profilecal_measure_t {
+    float top_speed;                // Highest speed reached (deg/s)
+    float acceleration;             // Average acceleration up to the profile speed (deg/s^2)
+} profilecal_measure_t;
+
+class WebFunctionAxisProfileCal : public WebFunction{
+private:
+    GantryMotor& _axis;
+    barrier_config_t& _barrierConfig;
+    TaskRunner& _taskRunner;
+    TaskHandle_t _taskHandle = nullptr;
+    CancelToken* _cancelToken = nullptr;
+
+    bool _hasResult = false;
+    float _results[PROFILECAL_RESULTS_COUNT];
+
+    float getAccelerationLimit(int8_t direction);
+    const char* measureDirection(int8_t direction, uint8_t duty, profilecal_measure_t* measure, CancelToken& cancel_token);
+    const char* runProfile(float speed, float acceleration, float target, uint8_t actuation, float* time, CancelToken& cancel_token);
+
+public:
+    WebFunctionAxisProfileCal(GantryMotor& axis, barrier_config_t& barrierConfig, TaskRunner& taskRunner) : _axis(axis), _barrierConfig(barrierConfig), _taskRunner(taskRunner) {};
+
+    // Override methods as needed
+    const char* getName() const override;
+    const char* getTitle() const override;
+    const char* getDescription() const override;
+    uint16_t getPrerequisitesCount() const override;
+    const char* getPrerequisiteDescription(uint16_t index) const override;
+
+    void arePrerequisitesMet(bool* results) const override;
+    WebFunctionExecutionStatus start() override;
+    void stop() override;
+
+    bool hasResult() const override {
+        return _hasResult;
+    }
+
+    uint16_t getResultsCount() const override {
+        return PROFILECAL_RESULTS_COUNT;
+    }
+
+    const char* getResultName(uint16_t index) const override;
+    const char* getResultUnit(uint16_t index) const override;
+    float getResultValue(uint16_t index) const override;
+    bool saveResult() override;
+    void discardResult() override;
+};
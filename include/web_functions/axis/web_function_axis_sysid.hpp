@@ -0,0 +1,67 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "web_functions/web_function.hpp"
+#include "motor_control/gantrymotor.hpp"
+#include "motor_control/logger.hpp"
+#include "motor_control/identification.hpp"
+#include "utils/task_runner.hpp"
+#include "utils/cancel_token.hpp"
+#include "utils/logger.hpp"
+#include "config.h"
+#include "monotonic.h"
+
+#define SYSID_LOG_DURATION_MS (15000)
+#define SYSID_SETTLE_TIME_MS (1000)
+#define SYSID_EXCITATION_MS (10000)         // Duration of the random excitation
+#define SYSID_PRBS_DUTY (30.0f)             // Excitation amplitude applied around the holding duty (%)
+#define SYSID_PRBS_BIT_MS (60)              // Duration of each bit of the pseudo random sequence
+#define SYSID_TRAVEL_MARGIN (0.15f)         // Fraction of the travel, at both ends, where the excitation is forced back
+#define SYSID_MIN_RATE (2.0f)               // Minimum speed of the samples used to fit the model (deg/s)
+#define SYSID_RESULTS_COUNT (7)
+
+class WebFunctionAxisSysId : public WebFunction{
+private:
+    GantryMotor& _axis;
+    TaskRunner& _taskRunner;
+    TaskHandle_t _taskHandle = nullptr;
+    CancelToken* _cancelToken = nullptr;
+
+    pbio_identification_t _idPos;
+    pbio_identification_t _idNeg;
+
+    bool _hasResult = false;
+    float _results[SYSID_RESULTS_COUNT];
+
+    const char* runExcitation(CancelToken& cancel_token);
+    const char* fitModel();
+
+public:
+    WebFunctionAxisSysId(GantryMotor& axis, TaskRunner& taskRunner) : _axis(axis), _taskRunner(taskRunner) {};
+
+    // Override methods as needed
+    const char* getName() const override;
+    const char* getTitle() const override;
+    const char* getDescription() const override;
+    uint16_t getPrerequisitesCount() const override;
+    const char* getPrerequisiteDescription(uint16_t index) const override;
+
+    void arePrerequisitesMet(bool* results) const override;
+    WebFunctionExecutionStatus start() override;
+    void stop() override;
+
+    bool hasResult() const override {
+        return _hasResult;
+    }
+
+    uint16_t getResultsCount() const override {
+        return SYSID_RESULTS_COUNT;
+    }
+
+    const char* getResultName(uint16_t index) const override;
+    const char* getResultUnit(uint16_t index) const override;
+    float getResultValue(uint16_t index) const override;
+    bool saveResult() override;
+    void discardResult() override;
+};
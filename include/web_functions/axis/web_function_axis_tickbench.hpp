@@ -0,0 +1,59 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "web_functions/web_function.hpp"
+#include "motor_control/gantrymotor.hpp"
+#include "utils/task_runner.hpp"
+#include "utils/cancel_token.hpp"
+#include "utils/logger.hpp"
+#include "config.h"
+
+#define TICKBENCH_SETTLE_TIME_MS (500)
+#define TICKBENCH_PHASE_MS (3000)           // Duration of each load phase
+#define TICKBENCH_FILE_CHUNK (4096)         // Bytes of each LittleFS write
+#define TICKBENCH_FILE_MAX (256 * 1024)     // The scratch file is restarted at this size
+#define TICKBENCH_FILE_PATH "/tickbench.bin"
+#define TICKBENCH_NVS_NAMESPACE "tickbench"
+#define TICKBENCH_RESULTS_COUNT (7)
+
+class WebFunctionAxisTickBench : public WebFunction{
+private:
+    GantryMotor& _axis;
+    TaskRunner& _taskRunner;
+    TaskHandle_t _taskHandle = nullptr;
+    CancelToken* _cancelToken = nullptr;
+
+    bool _hasResult = false;
+    float _results[TICKBENCH_RESULTS_COUNT];
+
+    void measurePhase(uint8_t phase, CancelToken& cancel_token);
+
+public:
+    WebFunctionAxisTickBench(GantryMotor& axis, TaskRunner& taskRunner) : _axis(axis), _taskRunner(taskRunner) {};
+
+    // Override methods as needed
+    const char* getName() const override;
+    const char* getTitle() const override;
+    const char* getDescription() const override;
+    uint16_t getPrerequisitesCount() const override;
+    const char* getPrerequisiteDescription(uint16_t index) const override;
+
+    void arePrerequisitesMet(bool* results) const override;
+    WebFunctionExecutionStatus start() override;
+    void stop() override;
+
+    bool hasResult() const override {
+        return _hasResult;
+    }
+
+    uint16_t getResultsCount() const override {
+        return TICKBENCH_RESULTS_COUNT;
+    }
+
+    const char* getResultName(uint16_t index) const override;
+    const char* getResultUnit(uint16_t index) const override;
+    float getResultValue(uint16_t index) const override;
+    bool saveResult() override;
+    void discardResult() override;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "web_functions/web_function.hpp"
+#include "motor_control/benchmark.hpp"
+#include "utils/task_runner.hpp"
+#include "utils/logger.hpp"
+#include "config.h"
+
+#define TRAJBENCH_RESULTS_COUNT (6)
+
+class WebFunctionAxisTrajectoryBench : public WebFunction{
+private:
+    TaskRunner& _taskRunner;
+    TaskHandle_t _taskHandle = nullptr;
+
+    bool _hasResult = false;
+    float _results[TRAJBENCH_RESULTS_COUNT];
+
+public:
+    WebFunctionAxisTrajectoryBench(TaskRunner& taskRunner) : _taskRunner(taskRunner) {};
+
+    // Override methods as needed
+    const char* getName() const override;
+    const char* getTitle() const override;
+    const char* getDescription() const override;
+    uint16_t getPrerequisitesCount() const override;
+    const char* getPrerequisiteDescription(uint16_t index) const override;
+
+    void arePrerequisitesMet(bool* results) const override;
+    WebFunctionExecutionStatus start() override;
+    void stop() override;
+
+    bool hasResult() const override {
+        return _hasResult;
+    }
+
+    uint16_t getResultsCount() const override {
+        return TRAJBENCH_RESULTS_COUNT;
+    }
+
+    const char* getResultName(uint16_t index) const override;
+    const char* getResultUnit(uint16_t index) const override;
+    float getResultValue(uint16_t index) const override;
+    bool saveResult() override;
+    void discardResult() override;
+};
@@ -5,6 +5,13 @@
 #include "web_functions/axis/web_function_axis_jog.hpp"
 #include "web_functions/axis/web_function_axis_lowertest.hpp"
 #include "web_functions/axis/web_function_axis_stepresponse.hpp"
+#include "web_functions/axis/web_function_axis_autotune.hpp"
+#include "web_functions/axis/web_function_axis_sysid.hpp"
+#include "web_functions/axis/web_function_axis_ffcal.hpp"
+#include "web_functions/axis/web_function_axis_ctlcompare.hpp"
+#include "web_functions/axis/web_function_axis_profilecal.hpp"
+#include "web_functions/axis/web_function_axis_trajbench.hpp"
+#include "web_functions/axis/web_function_axis_tickbench.hpp"
 #include "motor_control/gantrymotor.hpp"
 #include "manual_home.hpp"
 #include "barrier_config.h"
@@ -16,18 +23,25 @@ class WebFunctionGroupAxis : public WebFunctionGroup {
         GantryMotor& _motor;
         ManualHome& _manualHome;
         UnitEncoder& _knob_encoder;
-        const barrier_config_t& barrier_config;
+        barrier_config_t& barrier_config;
 
         WebFunctionAxisHoming _homing = WebFunctionAxisHoming(_motor, _manualHome, _taskRunner);
         WebFunctionAxisJog _jog = WebFunctionAxisJog(_motor, _knob_encoder, barrier_config, _taskRunner);
         WebFunctionAxisStepResponse _stepResponse = WebFunctionAxisStepResponse(_motor, _taskRunner);
         WebFunctionAxisLowerTest _lowerTest = WebFunctionAxisLowerTest(_motor, _taskRunner);
+        WebFunctionAxisAutoTune _autoTune = WebFunctionAxisAutoTune(_motor, _taskRunner);
+        WebFunctionAxisSysId _sysId = WebFunctionAxisSysId(_motor, _taskRunner);
+        WebFunctionAxisFeedforwardCal _ffCal = WebFunctionAxisFeedforwardCal(_motor, _taskRunner);
+        WebFunctionAxisControlCompare _ctlCompare = WebFunctionAxisControlCompare(_motor, _taskRunner);
+        WebFunctionAxisProfileCal _profileCal = WebFunctionAxisProfileCal(_motor, barrier_config, _taskRunner);
+        WebFunctionAxisTrajectoryBench _trajBench = WebFunctionAxisTrajectoryBench(_taskRunner);
+        WebFunctionAxisTickBench _tickBench = WebFunctionAxisTickBench(_motor, _taskRunner);
 
-        WebFunction* _functions[4] = { &_homing, &_jog, &_stepResponse, &_lowerTest};
+        WebFunction* _functions[11] = { &_homing, &_jog, &_stepResponse, &_lowerTest, &_autoTune, &_sysId, &_ffCal, &_ctlCompare, &_profileCal, &_trajBench, &_tickBench};
 
     public:
         WebFunctionGroupAxis(const char* name, const char* title, TaskRunner& taskRunner, 
-            GantryMotor& motor, ManualHome& manualHome, UnitEncoder& knob_encoder, const barrier_config_t& barrierConfig)
+            GantryMotor& motor, ManualHome& manualHome, UnitEncoder& knob_encoder, barrier_config_t& barrierConfig)
             : _motor(motor), _manualHome(manualHome), _knob_encoder(knob_encoder), barrier_config(barrierConfig), WebFunctionGroup(name, title, taskRunner) {}
 
         WebFunction** getFunctions() override {
@@ -34,5 +34,39 @@ public:
     const char* getFailuerDescription() const {
         return _failureDescription;
     }
+
+    // Results computed by the function that can be saved or discarded by the user
+    virtual bool hasResult() const {
+        return false;
+    }
+
+    virtual uint16_t getResultsCount() const {
+        return 0;
+    }
+
+    virtual const char* getResultName(uint16_t index) const {
+        return nullptr;
+    }
+
+    virtual const char* getResultUnit(uint16_t index) const {
+        return nullptr;
+    }
+
+    virtual float getResultValue(uint16_t index) const {
+        return 0.0f;
+    }
+
+    // Apply the results. Returns true if the settings must be stored in NVS
+    virtual bool saveResult() {
+        return false;
+    }
+
+    virtual void discardResult() {
+    }
+
+    // True if the saved results include the feedforward tables, stored apart from the settings
+    virtual bool savesFeedforward() const {
+        return false;
+    }
     
 };
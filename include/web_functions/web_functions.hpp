@@ -16,7 +16,7 @@ class WebFunctions {
         GantryMotor& _XMotor;
         ManualHome& _manualHome;
         UnitEncoder& _knob_encoder;
-        const barrier_config_t& barrier_config;
+        barrier_config_t& barrier_config;
         
         WebFunctionGroupAxis _xAxisGroup = WebFunctionGroupAxis("x_axis", "X-Axis", _taskRunner, _XMotor, _manualHome, _knob_encoder, barrier_config);
 
@@ -24,7 +24,7 @@ class WebFunctions {
         uint16_t _groupsCount = sizeof(_groups) / sizeof(WebFunctionGroup*);
 
     public:
-        WebFunctions(GantryMotor& xMotor, ManualHome& manualHome, UnitEncoder& knob_encoder, const barrier_config_t& barrier_config)
+        WebFunctions(GantryMotor& xMotor, ManualHome& manualHome, UnitEncoder& knob_encoder, barrier_config_t& barrier_config)
             : _XMotor(xMotor), _manualHome(manualHome), _knob_encoder(knob_encoder), barrier_config(barrier_config) {}
 
         WebFunctionGroup* getGroup(const char* name);
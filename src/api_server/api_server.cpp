@@ -31,12 +31,10 @@ String ApiRestServer::uriParam(const String& uri, uint8_t position) {
     return ""; // Return empty string if position is out of bounds
 }
 
-void ApiRestServer::begin(Settings* settings, WebFunctions* webFunctions, Motor* x1Motor, Motor* x2Motor, GantryMotor* xMotor) {
+void ApiRestServer::begin(Settings* settings, WebFunctions* webFunctions, AxisRegistry* axes) {
     _settings = settings;
     _webFunctions = webFunctions;
-    _X1Motor = x1Motor;
-    _X2Motor = x2Motor;
-    _XMotor = xMotor;
+    _axes = axes;
 
     // Confifure logging to Serial
     #ifdef ENABLE_API_SERVER_LOGGING
@@ -59,6 +57,10 @@ void ApiRestServer::begin(Settings* settings, WebFunctions* webFunctions, Motor*
     setupWebFunctionController();
     setupAxisLogController();
     setupAxisInfoController();
+    setupAxisSpectrumController();
+    setupAxisPreviewController();
+    setupBootProfileController();
+    setupAxesMoveController();
 
     // Serve assets static files from LittleFS removing the query string
     _server.on("/assets/*", [](PsychicRequest *request, PsychicResponse *response)
@@ -79,12 +81,5 @@ void ApiRestServer::begin(Settings* settings, WebFunctions* webFunctions, Motor*
 }
 
 PBIOLogger* ApiRestServer::getMotorLoggerByName(const char* name) {
-    if (strcmp(name, "X1") == 0)
-        return this->_X1Motor->get_logger();
-    else if (strcmp(name, "X2") == 0)
-        return this->_X2Motor->get_logger();
-    else if (strcmp(name, "X") == 0)
-        return this->_XMotor->get_logger();
-    else
-        return nullptr;
+    return _axes->findLogger(name);
 }
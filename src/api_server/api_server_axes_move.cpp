@@ -0,0 +1,66 @@
+#include "api_server/api_server.hpp"
+
+void ApiRestServer::setupAxesMoveController() {
+    // Start a coordinated move of several axes, e.g. {"speed": 200, "targets": {"x": 90}}.
+    // All the axes start in the same servo period and reach their targets together
+    _server.on("/axesmove", HTTP_POST, [this](PsychicRequest *request, PsychicResponse *response)
+    {
+        String body = request->body();
+        if (body.length() == 0)
+            return response->send(400);
+
+        JsonDocument doc;
+        DeserializationError err = deserializeJson(doc, body);
+        if (err)
+            return response->send(400);
+
+        // Mandatory "speed" and "targets", one target per axis
+        JsonVariant jsonSpeed = doc["speed"];
+        JsonObject jsonTargets = doc["targets"];
+        if (!jsonSpeed.is<float>() || jsonTargets.isNull())
+            return response->send(400);
+        float speed = jsonSpeed.as<float>();
+        if (speed <= 0)
+            return response->send(400);
+
+        uint8_t count = 0;
+        const char* names[AXIS_REGISTRY_MAX_AXES];
+        float targets[AXIS_REGISTRY_MAX_AXES];
+        for (JsonPair target : jsonTargets) {
+            if (count >= AXIS_REGISTRY_MAX_AXES || !target.value().is<float>())
+                return response->send(400);
+
+            const axis_registry_entry_t* entry = _axes->find(target.key().c_str());
+            if (!entry)
+                return response->send(400);
+
+            // The targets are meaningless until the axis is homed, and only the software limits keep
+            // the move inside the travel. A single motor axis has no homing, so it has no reference
+            if (!entry->gantry || !entry->gantry->referenced() || !entry->gantry->envelopeArmed())
+                return response->send(409, "application/json", "{\"error\":\"Axis not homed or without software limits\"}");
+
+            names[count] = target.key().c_str();
+            targets[count] = target.value().as<float>();
+            count++;
+        }
+        if (count == 0)
+            return response->send(400);
+
+        pbio_error_t move_err = _axes->run_targets(count, names, targets, speed, PBIO_ACTUATION_HOLD, false);
+        if (move_err != PBIO_SUCCESS)
+            return response->send(422, "application/json", "{\"error\":\"The move can't be started\"}");
+
+        return response->send(200);
+    });
+
+    // Get whether the last coordinated move completed
+    _server.on("/axesmove", HTTP_GET, [this](PsychicRequest *request, PsychicResponse *response)
+    {
+        JsonDocument doc;
+        doc["done"] = _axes->is_group_completion();
+
+        String responseStr;
+        serializeJson(doc, responseStr);
+        return response->send(200, "application/json", responseStr.c_str());
+    });
+}
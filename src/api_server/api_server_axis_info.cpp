@@ -1,5 +1,23 @@
 #include "api_server/api_server.hpp"
 
+/**
+Fills the info shared by the single motor and the gantry axes
+*/
+template <typename T>
+static void fillAxisInfo(JsonObject& jAxis, T* motor) {
+    float axis_speed_tolerance, axis_position_tolerance;
+    motor->get_target_tolerances(&axis_speed_tolerance, &axis_position_tolerance);
+
+    jAxis["counts_per_unit"] = motor->get_counts_per_unit();      
+    jAxis["standstill_speed"] = axis_speed_tolerance;
+    jAxis["position_tolerance"] = axis_position_tolerance;    
+    jAxis["speed_limit"] = motor->get_speed_limit();
+    jAxis["acceleration_limit"] = motor->get_acceleration_limit();
+    jAxis["actuation_limit"] = motor->get_actuation_limit();
+    jAxis["sw_limit_m"] = motor->getSwLimitMinus();
+    jAxis["sw_limit_p"] = motor->getSwLimitPlus();
+}
+
 void ApiRestServer::setupAxisInfoController() {
     // Get axis info
     _server.on("/axesinfo", [this](PsychicRequest *request, PsychicResponse *response)
@@ -7,30 +25,52 @@ void ApiRestServer::setupAxisInfoController() {
         // Prepare JSON response
         JsonDocument doc;
         JsonArray jAxes = doc.to<JsonArray>();
-        for(uint8_t i = 0; i < 1; i++) {
-            GantryMotor* motor = nullptr;
-            switch(i) {
-                case 0: motor = _XMotor; break;
-            }
-            if (motor) {
-                float axis_speed_tolerance, axis_position_tolerance;
-                motor->get_target_tolerances(&axis_speed_tolerance, &axis_position_tolerance);
-
-                JsonObject jAxis = jAxes.add<JsonObject>();
-                jAxis["name"] = motor->name();
-                jAxis["counts_per_unit"] = motor->get_counts_per_unit();      
-                jAxis["standstill_speed"] = axis_speed_tolerance;
-                jAxis["position_tolerance"] = axis_position_tolerance;    
-                jAxis["speed_limit"] = motor->get_speed_limit();
-                jAxis["acceleration_limit"] = motor->get_acceleration_limit();
-                jAxis["actuation_limit"] = motor->get_actuation_limit();
-                jAxis["sw_limit_m"] = motor->getSwLimitMinus();
-                jAxis["sw_limit_p"] = motor->getSwLimitPlus();
+        for(uint8_t i = 0; i < _axes->count(); i++) {
+            const axis_registry_entry_t& axis = _axes->get(i);
+
+            JsonObject jAxis = jAxes.add<JsonObject>();
+            jAxis["name"] = axis.name;
+            if (axis.gantry) {
+                GantryMotor* motor = axis.gantry;
+                fillAxisInfo(jAxis, motor);
+                jAxis["skew_compensation"] = motor->getSkewCompensation();
+                jAxis["skew_measured"] = motor->getMeasuredSkew();
+                jAxis["skew_alarm"] = motor->skewAlarm();
+            } else {
+                fillAxisInfo(jAxis, axis.motor);
             }
+            jAxis["update_us"] = axis.update_us;
+            jAxis["update_max_us"] = axis.update_max_us;
+        }
+
+        String responseStr;
+        serializeJson(doc, responseStr);
+        return response->send(200, "application/json", responseStr.c_str());
+    });
+
+    // Get the servo loop timing, optionally clearing the longest times
+    _server.on("/axestiming", [this](PsychicRequest *request, PsychicResponse *response)
+    {
+        JsonDocument doc;
+        doc["period_us"] = PBIO_CONFIG_SERVO_PERIOD_MS * 1000;
+        doc["cycle_us"] = _axes->cycleTime();
+        doc["cycle_max_us"] = _axes->cycleMaxTime();
+
+        JsonArray jAxes = doc["axes"].to<JsonArray>();
+        for(uint8_t i = 0; i < _axes->count(); i++) {
+            const axis_registry_entry_t& axis = _axes->get(i);
+            JsonObject jAxis = jAxes.add<JsonObject>();
+            jAxis["name"] = axis.name;
+            jAxis["update_us"] = axis.update_us;
+            jAxis["update_max_us"] = axis.update_max_us;
+        }
+
+        if (request->hasParam("reset")) {
+            _axes->resetTimings();
         }
 
         String responseStr;
         serializeJson(doc, responseStr);
         return response->send(200, "application/json", responseStr.c_str());
     });
-}
\ No newline at end of file
+}
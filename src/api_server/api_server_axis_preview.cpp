@@ -0,0 +1,109 @@
+#include "api_server/api_server.hpp"
+#include "motor_control/simulation.hpp"
+
+#define AXIS_PREVIEW_DEFAULT_SAMPLES (200)
+
+/**
+Reads a float query parameter
+
+:param value: Return the value, unchanged if the parameter is missing
+:return: False if the parameter is present but not a number
+*/
+static bool floatParam(PsychicRequest *request, const char* name, float* value) {
+    if (!request->hasParam(name))
+        return true;
+
+    String text = request->getParam(name)->value();
+    char* end;
+    float parsed = strtof(text.c_str(), &end);
+    if (text.length() == 0 || *end != '\0')
+        return false;
+
+    *value = parsed;
+    return true;
+}
+
+void ApiRestServer::setupAxisPreviewController() {
+    // Plan a run_target move and return its sampled reference without moving the axis
+    _server.on("/axispreview/*", [this](PsychicRequest *request, PsychicResponse *response)
+    {
+        // Extract parameters from the URL
+        String uri = request->uri();
+        String axis = uriParam(uri, 1);
+
+        // Validate mandatory "axis" parameter
+        axis.toUpperCase();
+        const axis_registry_entry_t* entry = _axes->find(axis.c_str());
+        if (!entry)
+            return response->send(400);
+        Motor* motor = entry->gantry ? &entry->gantry->motor1() : entry->motor;
+
+        // Mandatory "target" and "speed", optional start (default current position), acceleration and limits (default current ones)
+        if (!request->hasParam("target") || !request->hasParam("speed"))
+            return response->send(400);
+        float target = 0.0f, speed = 0.0f, start = motor->angle();
+        float acceleration = 0.0f, speed_limit = 0.0f, acceleration_limit = 0.0f;
+        if (!floatParam(request, "target", &target) || !floatParam(request, "speed", &speed) ||
+            !floatParam(request, "start", &start) || !floatParam(request, "acceleration", &acceleration) ||
+            !floatParam(request, "speed_limit", &speed_limit) || !floatParam(request, "acceleration_limit", &acceleration_limit))
+            return response->send(400);
+        if (acceleration < 0 || speed_limit < 0 || acceleration_limit < 0)
+            return response->send(400);
+
+        uint16_t max_samples = AXIS_PREVIEW_DEFAULT_SAMPLES;
+        if (request->hasParam("samples")) {
+            long value = request->getParam("samples")->value().toInt();
+            if (value < 2 || value > PBIO_SIMULATION_MAX_PREVIEW_SAMPLES)
+                return response->send(400);
+            max_samples = value;
+        }
+
+        pbio_simulation_sample_t* samples = (pbio_simulation_sample_t*)malloc(max_samples * sizeof(pbio_simulation_sample_t));
+        if (!samples)
+            return response->send(500);
+
+        uint16_t rows;
+        pbio_error_t err = motor->preview_target(start, target, speed, acceleration, speed_limit, acceleration_limit, max_samples, samples, &rows);
+        if (err != PBIO_SUCCESS) {
+            free(samples);
+            return response->send(422, "application/json", "{\"error\":\"The move can't be planned\"}");
+        }
+
+        // Stream the samples with the layout of the axis log, so the plan overlays the logged setpoints
+        PsychicStreamResponse response2(response, "application/json");
+        response2.beginSend();
+        response2.print("{\"rows\":");
+        response2.print(String(rows));
+        response2.print(",\"cols\":4");
+        response2.print(",\"duration\":");
+        response2.print(String(samples[rows - 1].time / 1000));
+        response2.print(",\"col_names\":[\"Time since start of maneuver\",\"Position setpoint\",\"Speed setpoint\",\"Acceleration setpoint\"]");
+        response2.print(",\"col_units\":[\"ms\",\"count\",\"count/s\",\"count/s^2\"]");
+        yield(); // Allow background tasks to run
+
+        response2.print(",\"data\":[");
+        int8_t yield_counter = 0;
+        for (uint16_t r = 0; r < rows; r++) {
+            const pbio_simulation_sample_t& sample = samples[r];
+            response2.print("[");
+            response2.print(sample.time / 1000);
+            response2.print(",");
+            response2.print(sample.count);
+            response2.print(",");
+            response2.print(sample.rate);
+            response2.print(",");
+            response2.print(sample.acceleration);
+            response2.print(r < rows - 1 ? "]," : "]");
+
+            // Yield every 10 rows to allow background tasks to run
+            if (++yield_counter >= 10) {
+                yield_counter = 0;
+                yield(); // Allow background tasks to run
+            }
+        }
+        response2.print("]}");
+        free(samples);
+
+        return response2.endSend();
+    });
+}
@@ -0,0 +1,71 @@
+#include "api_server/api_server.hpp"
+#include "motor_control/spectrum.hpp"
+
+void ApiRestServer::setupAxisSpectrumController() {
+    // Analyze the spectrum of the position error and of the duty cycle in the axis log
+    _server.on("/axisspectrum/*", [this](PsychicRequest *request, PsychicResponse *response)
+    {
+        // Extract parameters from the URL
+        String uri = request->uri();
+        String axis = uriParam(uri, 1);
+
+        // Validate mandatory "axis" parameter
+        axis.toUpperCase();
+        PBIOLogger* logger = getMotorLoggerByName(axis.c_str());
+        if (!logger)
+            return response->send(400);
+
+        if (logger->is_active())
+            return response->send(409, "application/json", "{\"error\":\"Log still running\"}");
+
+        // Get optional parameters
+        uint32_t start = 0; // default analyze from the log start
+        uint8_t peaks = 5; // default report 5 peaks
+        if (request->hasParam("start")) {
+            long value = request->getParam("start")->value().toInt();
+            if (value < 0)
+                return response->send(400);
+            start = value;
+        }
+        if (request->hasParam("peaks")) {
+            long value = request->getParam("peaks")->value().toInt();
+            if (value < 1 || value > PBIO_SPECTRUM_MAX_PEAKS)
+                return response->send(400);
+            peaks = value;
+        }
+
+        const uint8_t cols[2] = { PBIO_SPECTRUM_COL_ERROR, PBIO_SPECTRUM_COL_DUTY };
+        const char* names[2] = { "error", "duty" };
+
+        JsonDocument doc;
+        doc["axis"] = axis;
+        JsonArray jColumns = doc["columns"].to<JsonArray>();
+        for (uint8_t i = 0; i < 2; i++) {
+            pbio_spectrum_t spectrum;
+            pbio_error_t err = pbio_spectrum_analyze(logger, cols[i], start, peaks, &spectrum);
+            if (err == PBIO_ERROR_INVALID_OP)
+                return response->send(204); // Not enough logged samples
+            if (err != PBIO_SUCCESS)
+                return response->send(500);
+
+            doc["samples"] = spectrum.samples;
+            doc["sample_rate"] = spectrum.sample_rate;
+            doc["resolution"] = spectrum.resolution;
+
+            JsonObject jColumn = jColumns.add<JsonObject>();
+            jColumn["name"] = names[i];
+            jColumn["unit"] = logger->col_unit(cols[i]);
+            JsonArray jPeaks = jColumn["peaks"].to<JsonArray>();
+            for (uint8_t p = 0; p < spectrum.num_peaks; p++) {
+                JsonObject jPeak = jPeaks.add<JsonObject>();
+                jPeak["frequency"] = spectrum.peaks[p].frequency;
+                jPeak["amplitude"] = spectrum.peaks[p].amplitude;
+            }
+            yield(); // Allow background tasks to run
+        }
+
+        String jsonResponse;
+        serializeJson(doc, jsonResponse);
+        return response->send(200, "application/json", jsonResponse.c_str());
+    });
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "api_server/api_server.hpp"
+#include "utils/boot_profile.hpp"
+
+void ApiRestServer::setupBootProfileController() {
+    // Get the start and end times of the startup phases, since the power-up
+    _server.on("/bootprofile", [](PsychicRequest *request, PsychicResponse *response)
+    {
+        BootProfile& profile = BootProfile::instance();
+
+        JsonDocument doc;
+        doc["ready_us"] = profile.readyTime();
+
+        JsonArray jPhases = doc["phases"].to<JsonArray>();
+        for (uint8_t i = 0; i < (uint8_t)BootPhase::Count; i++) {
+            BootPhase phase = (BootPhase)i;
+            uint32_t start = profile.startTime(phase);
+            uint32_t end = profile.endTime(phase);
+
+            JsonObject jPhase = jPhases.add<JsonObject>();
+            jPhase["name"] = BootProfile::name(phase);
+            jPhase["start_us"] = start;
+            jPhase["end_us"] = end;
+            jPhase["duration_us"] = end >= start && start > 0 ? end - start : 0;
+        }
+
+        String responseStr;
+        serializeJson(doc, responseStr);
+        return response->send(200, "application/json", responseStr.c_str());
+    });
+}
@@ -109,6 +109,27 @@ void ApiRestServer::setupWebFunctionController() {
             if (failureDescription) {
                 doc["failure_description"] = failureDescription;
             }
+            if (function->hasResult()) {
+                JsonArray jresults = doc["results"].to<JsonArray>();
+                for (uint16_t i = 0; i < function->getResultsCount(); i++) {
+                    JsonObject jresult = jresults.add<JsonObject>();
+                    jresult["name"] = function->getResultName(i);
+                    jresult["unit"] = function->getResultUnit(i);
+                    jresult["value"] = function->getResultValue(i);
+                }
+            }
+        } else if (action == "save_result") {
+            if (!function->hasResult() || function->getRunningStatus() == WebFunctionExecutionStatus::InProgress) {
+                return response->send(400, "application/json", "{\"error\":\"No result to save\"}");
+            }
+            if (function->saveResult()) {
+                _settings->storeInNVS();
+                if (function->savesFeedforward()) {
+                    _settings->storeFeedforwardInNVS();
+                }
+            }
+        } else if (action == "discard_result") {
+            function->discardResult();
         } else if (action == "prerequisites") {
             bool prerequisitesMet[function->getPrerequisitesCount()];
             function->arePrerequisitesMet(prerequisitesMet);
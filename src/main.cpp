@@ -11,33 +11,52 @@
 #include "devices/button.hpp"
 #include "motor_control/motor.hpp"
 #include "motor_control/gantrymotor.hpp"
+#include "motor_control/axis_registry.hpp"
+#include "motor_control/battery.hpp"
 #include "motor_control/controlsettings.h"
 #include "motor_control/motor.hpp"
 #include "motor_control/error.hpp"
 #include "utils/i2c_utils.hpp"
 #include "utils/logger.hpp"
 #include "utils/cancel_token.hpp"
+#include "utils/boot_profile.hpp"
 
 #include "io.h"
 #include "manual_home.hpp"
+#include "warm_boot.hpp"
 #include "barrier_config.h"
 #include "settings/settings.hpp"
 #include "web_functions/web_functions.hpp"
 
 barrier_config_t barrier_config = {
+    .auto_homing = false,
     .manual_homing_speed = 100.0f, // deg/s
     .jog_multiplier = 5.0f,
     .barrier_lower_speed = 1000.0f, // deg/s
     .barrier_raise_speed = 400.0f, // deg/s
     .barrier_raise_power = 70, // % of max power
+    .barrier_lower_acceleration = 0.0f, // deg/s^2, axis limit
+    .barrier_raise_acceleration = 0.0f, // deg/s^2, axis limit
     .barrier_hold_time = 20 // seconds
 };
 
+// The reference obstacle is the lower end stop of the barrier
+stall_homing_config_t x_stall_homing_config = {
+    { -5.0f, 0.0f },    // deg, axis position against the end stop and after homing
+    false,              // Start in the negative direction
+    -60.0f,             // deg/s, the direction is given by the flag above
+    40.0f,              // % of max power
+    10.0f               // deg, minimum travel before the end stop
+};
+
 ApiRestServer server;
 
 Motor x1_motor;
 Motor x2_motor;
 GantryMotor x_motor(x1_motor, x2_motor);
+Motor l_motor;
+Motor r_motor;
+AxisRegistry axes;
 
 UnitEncoder knob_encoder;
 RGBLed board_rgb_led;
@@ -46,14 +65,86 @@ Button knob_button;
 Adafruit_NeoPixel start_button_led = Adafruit_NeoPixel(1, START_BUTTON_LED_PIN, NEO_GRB + NEO_KHZ800);
 
 ManualHome manual_home(knob_encoder, x_motor, start_button_led, barrier_config);
+WarmBoot warm_boot(x_motor);
 
-Settings game_settings(x_motor, barrier_config);
+Settings game_settings(x_motor, l_motor, r_motor, x_stall_homing_config, barrier_config);
 WebFunctions web_functions(x_motor, manual_home, knob_encoder, barrier_config);
 
 
 bool service_mode = false;
 
+/**
+ * Last event of an axis, latched by the motor loop and reported by the event task
+ */
+typedef struct _axis_event_t {
+    uint32_t count;     // Events since power-up
+    float angle;        // Axis angle at the event (deg)
+    float value;        // Speed residual of a collision, or braking speed on a software limit (deg/s)
+} axis_event_t;
+
+static axis_event_t collision_events[AXIS_REGISTRY_MAX_AXES] = {};
+static axis_event_t envelope_events[AXIS_REGISTRY_MAX_AXES] = {};
+static portMUX_TYPE axis_events_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void latch_axis_events() {
+    // Copy the obstructions and the maneuvers braked on a software limit since the last check
+    for (uint8_t i = 0; i < axes.count(); i++) {
+        const axis_registry_entry_t& axis = axes.get(i);
+
+        uint32_t collisions = axes.collisionCount(i);
+        if (collisions != collision_events[i].count) {
+            float angle = axis.gantry ? axis.gantry->angle() : axis.motor->angle();
+            float residual = axis.gantry ? axis.gantry->collisionResidual() : axis.motor->collision_residual();
+            taskENTER_CRITICAL(&axis_events_mux);
+            collision_events[i] = { collisions, angle, residual };
+            taskEXIT_CRITICAL(&axis_events_mux);
+        }
+
+        uint32_t violations = axes.envelopeViolations(i);
+        if (violations != envelope_events[i].count) {
+            float angle, speed;
+            if (axis.gantry) {
+                axis.gantry->getEnvelopeViolation(&angle, &speed);
+            } else {
+                axis.motor->get_envelope_violation(&angle, &speed);
+            }
+            taskENTER_CRITICAL(&axis_events_mux);
+            envelope_events[i] = { violations, angle, speed };
+            taskEXIT_CRITICAL(&axis_events_mux);
+        }
+    }
+}
+
+void axis_event_task(void *parameter) {
+    uint32_t collisions[AXIS_REGISTRY_MAX_AXES] = {};
+    uint32_t violations[AXIS_REGISTRY_MAX_AXES] = {};
+
+    // Report the events latched by the motor loop, the logging is too slow for the motor core
+    while (true) {
+        for (uint8_t i = 0; i < axes.count(); i++) {
+            taskENTER_CRITICAL(&axis_events_mux);
+            axis_event_t collision = collision_events[i];
+            axis_event_t violation = envelope_events[i];
+            taskEXIT_CRITICAL(&axis_events_mux);
+
+            const char* name = axes.get(i).name;
+            if (collision.count != collisions[i]) {
+                collisions[i] = collision.count;
+                Logger::instance().logW("Collision detected on " + String(name) + "-axis at " + String(collision.angle, 1) +
+                    " deg, speed residual " + String(collision.value, 1) + " deg/s");
+            }
+            if (violation.count != violations[i]) {
+                violations[i] = violation.count;
+                Logger::instance().logW("Software limit enforced on " + String(name) + "-axis: braking from " +
+                    String(violation.value, 1) + " deg/s at " + String(violation.angle, 1) + " deg");
+            }
+        }
+        delay(AXIS_EVENT_REPORT_MS);
+    }
+}
+
 void motor_loop_task(void *parameter) {
+    TaskHandle_t starter = (TaskHandle_t)parameter;
     int32_t counter = 0;
     bool led = false;
 
@@ -61,8 +152,15 @@ void motor_loop_task(void *parameter) {
         uint64_t start_time = monotonic_us();
         uint32_t millis = (uint32_t)(start_time / US_PER_MS);
 
-        // Update motors motion
-        x_motor.update();
+        // Update the motion of all the axes
+        axes.update();
+        warm_boot.update();
+
+        // Let setup go on once the axes are updated
+        if (starter != NULL) {
+            xTaskNotifyGive(starter);
+            starter = NULL;
+        }
         
         // Blink the watchdog LED every 150 iterations (450 ms)
         counter++;
@@ -70,6 +168,8 @@ void motor_loop_task(void *parameter) {
             counter = 0;
             led = !led;
             digitalWrite(BOARD_LED_OUTPUT, led ? HIGH : LOW);
+
+            latch_axis_events();
         }
 
         // Run the task every 3ms
@@ -77,8 +177,55 @@ void motor_loop_task(void *parameter) {
     }
 }
 
-void setup_wifi() {
-    // Connect to WiFi
+void check_gantry_skew() {
+    static bool skew_alarm = false;
+
+    // Report the skew alarm only when it's raised or cleared
+    if (x_motor.skewAlarm() != skew_alarm) {
+        skew_alarm = x_motor.skewAlarm();
+        if (skew_alarm) {
+            Logger::instance().logE("Gantry skew alarm! Measured skew " + String(x_motor.getMeasuredSkew(), 1) + 
+                " deg, compensation " + String(x_motor.getSkewCompensation(), 1) + " deg");
+        } else {
+            Logger::instance().logI("Gantry skew alarm cleared");
+        }
+    }
+
+    // Persist the learned skew, so it's applied after the next homing
+    if (x_motor.skewNeedsStore()) {
+        game_settings.storeInNVS("x_gantry");
+        x_motor.markSkewStored();
+        Logger::instance().logI("Learned gantry skew stored: " + String(x_motor.getHomedSkew(), 2) + " deg");
+    }
+}
+
+void check_drop_learning() {
+    // Update the drop correction off the control loop, once the drop and its settling are over
+    Motor& motor = x_motor.motor1();
+    float rms;
+    uint16_t iterations;
+    pbio_error_t err = motor.learn(&rms, &iterations);
+    if (err == PBIO_SUCCESS) {
+        Logger::instance().logI("Drop learning iteration " + String(iterations) + ", tracking error " + String(rms, 2) + " deg rms");
+    } else if (err == PBIO_ERROR_FAILED) {
+        Logger::instance().logW("Drop learning diverged with tracking error " + String(rms, 2) + " deg rms, correction reset");
+    }
+
+    // Persist the converged correction, so it's applied from the first race after a power-up
+    if (motor.learning_needs_store()) {
+        game_settings.storeLearningInNVS();
+        motor.mark_learning_stored();
+        Logger::instance().logI("Drop learning converged, correction stored");
+    }
+}
+
+/**
+Starts connecting to WiFi, or starts the access point. The station connection completes in
+the background, see wait_wifi()
+
+:return: False if the network can't be configured
+*/
+bool start_wifi() {
     IPAddress staticIP(IP_ADDRESS);
     IPAddress gateway(IP_GATEWAY);
     IPAddress subnet(IP_SUBNET);
@@ -86,43 +233,91 @@ void setup_wifi() {
 
 #ifdef AP_MODE
     // Set up Access Point mode
-    if (WiFi.softAPConfig(staticIP, gateway, subnet)) {
-        if (WiFi.softAP(WIFI_SSID, WIFI_PASSWORD)) {
-            board_rgb_led.setColor(RGB_COLOR_MAGENTA);
-            Logger::instance().logI("Access Point started!");
-            Logger::instance().logI("SSID: " + String(WIFI_SSID) + ", Password: " + String(WIFI_PASSWORD));
-            Logger::instance().logI("AP IP Address: " + WiFi.softAPIP().toString());
-        } else {
-            Logger::instance().logE("Failed to start Access Point.");
-            board_rgb_led.unrecoverableError();
-        }
-    } else {
+    if (!WiFi.softAPConfig(staticIP, gateway, subnet)) {
         Logger::instance().logE("Access Point configuration failed. Please check the static IP settings.");
-        board_rgb_led.unrecoverableError();
+        return false;
+    }
+    if (!WiFi.softAP(WIFI_SSID, WIFI_PASSWORD)) {
+        Logger::instance().logE("Failed to start Access Point.");
+        return false;
     }
+    Logger::instance().logI("Access Point started!");
+    Logger::instance().logI("SSID: " + String(WIFI_SSID) + ", Password: " + String(WIFI_PASSWORD));
+    Logger::instance().logI("AP IP Address: " + WiFi.softAPIP().toString());
 #else
     // Connect to WiFi in Station mode
-    if (WiFi.config(staticIP, gateway, subnet, dns, dns)) {
-        board_rgb_led.setColor(RGB_COLOR_MAGENTA);
-        WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-        while (WiFi.status() != WL_CONNECTED) {
-            delay(1000);
+    if (!WiFi.config(staticIP, gateway, subnet, dns, dns)) {
+        Logger::instance().logE("WiFi configuration failed. Please check the static IP settings.");
+        return false;
+    }
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+#endif
+    return true;
+}
+
+/**
+Waits for the station connection started by start_wifi()
+*/
+void wait_wifi() {
+#ifndef AP_MODE
+    uint32_t last_log = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+        delay(WIFI_CONNECT_POLL_MS);
+        if (millis() - last_log >= 1000) {
+            last_log = millis();
             Logger::instance().logI("Connecting to WiFi...");
         }
-        Logger::instance().logI("Connected to WiFi!");
-        Logger::instance().logI("IP Address: " + WiFi.localIP().toString());
-    } 
-    else {
-        Logger::instance().logE("WiFi configuration failed. Please check the static IP settings.");
-        board_rgb_led.unrecoverableError();
     }
+    Logger::instance().logI("Connected to WiFi!");
+    Logger::instance().logI("IP Address: " + WiFi.localIP().toString());
 #endif
 }
 
+/**
+Brings up WiFi, LittleFS and the web server, in parallel with the homing.
+
+LittleFS is mounted and the server started while WiFi connects, the server accepts the
+connections once the network is up. A failure stops the firmware only in service mode,
+otherwise the barrier keeps working without the web server.
+*/
+void network_task(void *parameter) {
+    BootProfile& profile = BootProfile::instance();
+
+    profile.start(BootPhase::WiFi);
+    bool network = start_wifi();
+
+    profile.start(BootPhase::LittleFS);
+    bool filesystem = LittleFS.begin();
+    profile.end(BootPhase::LittleFS);
+    if (filesystem) {
+        Serial.println("LittleFS mounted successfully");
+    } else {
+        Serial.println("Failed to mount LittleFS");
+    }
+
+    if (network && filesystem) {
+        profile.start(BootPhase::Server);
+        server.begin(&game_settings, &web_functions, &axes);
+        profile.end(BootPhase::Server);
+
+        wait_wifi();
+        profile.end(BootPhase::WiFi);
+    }
+    else if (service_mode) {
+        board_rgb_led.unrecoverableError();
+    }
+
+    vTaskDelete(NULL);
+}
+
 void setup() {    
+    BootProfile& profile = BootProfile::instance();
+
     // Configure USB uarts
     Serial.begin(115200);
 
+    profile.start(BootPhase::Io);
+
     // Configure inputs
     pinMode(START_BUTTON_PIN, INPUT_PULLUP);
 
@@ -136,21 +331,44 @@ void setup() {
     start_button_led.setBrightness(100); 
     start_button_led.setPixelColor(0, RGB_COLOR_RED);
     start_button_led.show();
+    profile.end(BootPhase::Io);
     
     // Configure two I2C busses
+    profile.start(BootPhase::I2C);
     Wire.begin(I2C_BUS_1_SDA, I2C_BUS_1_SCL, 400000);
     Wire1.begin(I2C_BUS_2_SDA, I2C_BUS_2_SCL, 400000);
     knob_encoder.begin(&Wire);
     knob_encoder.setPulseMode();
     knob_encoder.setLEDColor(0, RGB_COLOR_BLACK);
     knob_encoder.setLEDColor(1, RGB_COLOR_BLACK);
+    profile.end(BootPhase::I2C);
+
+    // Sample the supply before the motors start, they scale the duty with it
+    profile.start(BootPhase::Motors);
+#ifdef SUPPLY_VOLTAGE_ADC_PIN
+    pbio_battery_begin(SUPPLY_VOLTAGE_ADC_PIN);
+    Logger::instance().logI("Supply voltage " + String(pbio_battery_get_voltage_now() / 1000.0f, 2) + " V");
+#endif
 
-    x1_motor.begin("X1", X1_AXIS_ENC_PIN_1, X1_AXIS_ENC_PIN_2, X1_AXIS_PWM_PIN_1, X1_AXIS_PWM_PIN_2, PBIO_DIRECTION_CLOCKWISE, 1.0, &settings_servo_ev3_large);
-    x2_motor.begin("X2", X2_AXIS_ENC_PIN_1, X2_AXIS_ENC_PIN_2, X2_AXIS_PWM_PIN_1, X2_AXIS_PWM_PIN_2, PBIO_DIRECTION_COUNTERCLOCKWISE, 1.0, &settings_servo_ev3_large);
+    x1_motor.begin("X1", X1_AXIS_ENC_PIN_1, X1_AXIS_ENC_PIN_2, X1_AXIS_PWM_PIN_1, X1_AXIS_PWM_PIN_2, PBIO_DIRECTION_CLOCKWISE, 1.0, &settings_servo_ev3_large, nullptr, X_AXIS_PWM_FREQUENCY, X_AXIS_PWM_RESOLUTION);
+    x2_motor.begin("X2", X2_AXIS_ENC_PIN_1, X2_AXIS_ENC_PIN_2, X2_AXIS_PWM_PIN_1, X2_AXIS_PWM_PIN_2, PBIO_DIRECTION_COUNTERCLOCKWISE, 1.0, &settings_servo_ev3_large, nullptr, X_AXIS_PWM_FREQUENCY, X_AXIS_PWM_RESOLUTION);
     x_motor.begin("x");
+    l_motor.begin("L", L_AXIS_ENC_PIN_1, L_AXIS_ENC_PIN_2, L_AXIS_PWM_PIN_1, L_AXIS_PWM_PIN_2, PBIO_DIRECTION_CLOCKWISE, 1.0, &settings_servo_ev3_large, nullptr, L_AXIS_PWM_FREQUENCY, L_AXIS_PWM_RESOLUTION);
+    r_motor.begin("R", R_AXIS_ENC_PIN_1, R_AXIS_ENC_PIN_2, R_AXIS_PWM_PIN_1, R_AXIS_PWM_PIN_2, PBIO_DIRECTION_CLOCKWISE, 1.0, &settings_servo_ev3_large, nullptr, R_AXIS_PWM_FREQUENCY, R_AXIS_PWM_RESOLUTION);
+
+    // Axes updated by the motor loop
+    axes.add("x", x_motor);
+    axes.add("l", l_motor);
+    axes.add("r", r_motor);
+    profile.end(BootPhase::Motors);
 
     // Restore game and axes settings from NVS
+    profile.start(BootPhase::Settings);
     game_settings.restoreFromNVS();
+
+    // Read the position saved before a reset, before the motor loop drops it
+    warm_boot.begin();
+    profile.end(BootPhase::Settings);
     
     service_mode = START_BUTTON_PRESSED;
     bool start_web_server = service_mode;
@@ -163,31 +381,41 @@ void setup() {
 #endif
 
     // Start motor loop task on core 0. Core 0 is used only for motor control
+    profile.start(BootPhase::MotorTask);
     xTaskCreatePinnedToCore (
-        motor_loop_task,        // Function to implement the task
-        "motor_loop",           // Name of the task
-        8000,                   // Stack size in words
-        NULL,                   // Task input parameter
-        MOTION_TASK_PRIORITY,   // Priority of the task
-        NULL,                   // Task handle.
-        MOTION_TASK_CORE        // Core where the task should run
+        motor_loop_task,            // Function to implement the task
+        "motor_loop",               // Name of the task
+        8000,                       // Stack size in words
+        xTaskGetCurrentTaskHandle(),// Task input parameter, notified once the loop runs
+        MOTION_TASK_PRIORITY,       // Priority of the task
+        NULL,                       // Task handle.
+        MOTION_TASK_CORE            // Core where the task should run
     );
-    delay(100); // Ensure that motor loop task is running
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)); // Ensure that motor loop task is running
+    profile.end(BootPhase::MotorTask);
 
-    if (start_web_server) {
-        setup_wifi();
-
-        // Mount LittleFS
-        if (!LittleFS.begin()) {
-            Serial.println("Failed to mount LittleFS");
-            board_rgb_led.unrecoverableError();
-        }
-        Serial.println("LittleFS mounted successfully");
+    // Report the axis events off the motor core
+    xTaskCreatePinnedToCore (
+        axis_event_task,            // Function to implement the task
+        "axis_events",              // Name of the task
+        4096,                       // Stack size in words
+        NULL,                       // Task input parameter
+        OTHER_TASK_PRIORITY,        // Priority of the task
+        NULL,                       // Task handle.
+        OTHER_TASK_CORE             // Core where the task should run
+    );
 
-        // Start the web server
-        server.begin(
-            &game_settings, &web_functions, 
-            &x1_motor, &x2_motor, &x_motor);
+    // Bring up the network in the background, the homing doesn't need it
+    if (start_web_server) {
+        xTaskCreatePinnedToCore (
+            network_task,           // Function to implement the task
+            "network_start",        // Name of the task
+            8192,                   // Stack size in words
+            NULL,                   // Task input parameter
+            OTHER_TASK_PRIORITY,    // Priority of the task
+            NULL,                   // Task handle.
+            OTHER_TASK_CORE         // Core where the task should run
+        );
     }
 
     // Service mode infinite loop to prevent normal operation
@@ -196,16 +424,33 @@ void setup() {
         while (true)
         {
             delay(1000);
+            check_gantry_skew();
         }        
     }
 
-    // Run manual homing procedure
+    // After a soft reset restore the saved position, else run the homing procedure.
+    // The manual one is the fallback when the automatic one fails
+    profile.start(BootPhase::Homing);
     board_rgb_led.setColor(RGB_COLOR_YELLOW);
-    CancelToken cancel_token;
-    manual_home.run_home(cancel_token);
+    if (!warm_boot.restore()) {
+        CancelToken cancel_token;
+        pbio_error_t err = PBIO_ERROR_FAILED;
+        if (barrier_config.auto_homing) {
+            err = x_motor.run_stall_homing(x_stall_homing_config, cancel_token);
+        }
+        if (err != PBIO_SUCCESS) {
+            err = manual_home.run_home(cancel_token);
+        }
+        if (err == PBIO_SUCCESS) {
+            warm_boot.homed();
+        }
+    }
+    profile.end(BootPhase::Homing);
 
     // Set board LED to green to indicate normal operation
     board_rgb_led.setColor(RGB_COLOR_GREEN);
+    profile.ready();
+    Logger::instance().logI("Barrier ready " + String(profile.readyTime() / US_PER_MS) + " ms after boot" + (warm_boot.restored() ? " (position restored)" : ""));
 }
 
 void loop() {
@@ -217,7 +462,7 @@ void loop() {
     start_button_led.setPixelColor(0, RGB_COLOR_YELLOW);
     start_button_led.show();
     x_motor.set_actuation_limit(barrier_config.barrier_raise_power);
-    x_motor.run_target(barrier_config.barrier_raise_speed, x_motor.getSwLimitPlus(), PBIO_ACTUATION_HOLD, true);
+    x_motor.run_target_profile(barrier_config.barrier_raise_speed, barrier_config.barrier_raise_acceleration, x_motor.getSwLimitPlus(), PBIO_ACTUATION_HOLD, true);
     x_motor.set_actuation_limit(100);
 
     // Indicate readiness by setting the start button LED to green
@@ -231,7 +476,8 @@ void loop() {
     // Start lowering the barrier
     start_button_led.setPixelColor(0, RGB_COLOR_RED);
     start_button_led.show();
-    x_motor.run_target(barrier_config.barrier_lower_speed, x_motor.getSwLimitMinus(), PBIO_ACTUATION_HOLD, true);
+    x_motor.motor1().arm_learning();
+    x_motor.run_target_profile(barrier_config.barrier_lower_speed, barrier_config.barrier_lower_acceleration, x_motor.getSwLimitMinus(), PBIO_ACTUATION_HOLD, true);
 
     // Wait with the barrier lowered
     bool led = true;
@@ -241,6 +487,9 @@ void loop() {
         led = !led;
         start_button_led.setPixelColor(0, led ? RGB_COLOR_RED : RGB_COLOR_BLACK);
         start_button_led.show();
+        check_drop_learning();
         delay(300);
     }
+
+    check_gantry_skew();
 }
\ No newline at end of file
@@ -19,7 +19,9 @@ pbio_error_t ManualHome::run_home(CancelToken& cancel_token) {
     int16_t knob_value = INT16_MIN;
     knob_encoder.clearValue();
 
-    // Start positon holding
+    // Start positon holding. The home marker can be beyond the software limits
+    bool envelope_armed = motor.envelopeArmed();
+    motor.armEnvelope(false);
     motor.track_target(motor.angle());
 
     while (!start_button.isHolding()) {
@@ -29,6 +31,9 @@ pbio_error_t ManualHome::run_home(CancelToken& cancel_token) {
         if (cancel_token.isCancelled()) {
             motor.stop();
 
+            // The previous reference is kept, and so are its limits
+            motor.armEnvelope(envelope_armed);
+
             // Switch off knob LEDs
             knob_encoder.setLEDColor(0, RGB_COLOR_BLACK);
             knob_encoder.setLEDColor(1, RGB_COLOR_BLACK);
@@ -110,7 +115,7 @@ pbio_error_t ManualHome::run_home(CancelToken& cancel_token) {
                     x_angle_setpoint = motor.angle();
                 }
                 x_angle_setpoint += (float)knob_delta * barrier_config.jog_multiplier;
-                motor.track_target(x_angle_setpoint);
+                motor.track_target(x_angle_setpoint, true);
             }
         } else {
             // Adjust skew compensation using the knob encoder
@@ -126,6 +131,7 @@ pbio_error_t ManualHome::run_home(CancelToken& cancel_token) {
         delay(20);
     }
     motor.reset_angle(0.0f);
+    motor.armEnvelope(true);
 
     // Switch off knob LEDs
     knob_encoder.setLEDColor(0, RGB_COLOR_BLACK);
@@ -1,4 +1,5 @@
 #include "monotonic.h"
+#include "motor_control/macros.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -9,7 +10,7 @@ static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
 static unsigned long __last_micros_value_2 = 0;
 static uint64_t __accumulated_micros_value_2 = 0;
 
-uint64_t monotonic_us() {
+uint64_t PBIO_IRAM monotonic_us() {
     taskENTER_CRITICAL(&mux);
     unsigned long new_value = micros();
     uint32_t delta;
@@ -0,0 +1,362 @@
+#include "motor_control/axis_registry.hpp"
+#include "monotonic.h"
+
+bool AxisRegistry::add(const char* name, Motor* motor, GantryMotor* gantry) {
+    if (_count >= AXIS_REGISTRY_MAX_AXES || find(name) != nullptr) {
+        return false;
+    }
+
+    axis_registry_entry_t& axis = _axes[_count];
+    axis.name = name;
+    axis.motor = motor;
+    axis.gantry = gantry;
+    axis.update_us = 0;
+    axis.update_max_us = 0;
+    _count++;
+    return true;
+}
+
+/**
+Adds a single motor axis to the servo loop
+
+:param name: Axis name used by the API
+:param motor: Motor of the axis
+:return: False if the registry is full or the name is already in use
+*/
+bool AxisRegistry::add(const char* name, Motor& motor) {
+    return add(name, &motor, nullptr);
+}
+
+/**
+Adds a gantry axis to the servo loop. Both gantry motors are updated by the gantry
+
+:param name: Axis name used by the API
+:param gantry: Gantry axis
+:return: False if the registry is full or the name is already in use
+*/
+bool AxisRegistry::add(const char* name, GantryMotor& gantry) {
+    return add(name, nullptr, &gantry);
+}
+
+/**
+Updates all the axes, in registration order, and measures the time taken by each of them
+*/
+void AxisRegistry::update() {
+    uint64_t cycle_start = monotonic_us();
+
+    for (uint8_t i = 0; i < _count; i++) {
+        axis_registry_entry_t& axis = _axes[i];
+        uint64_t start = monotonic_us();
+
+        if (axis.gantry) {
+            axis.gantry->update();
+        } else {
+            axis.motor->update();
+        }
+
+        axis.update_us = (uint32_t)(monotonic_us() - start);
+        if (axis.update_us > axis.update_max_us) {
+            axis.update_max_us = axis.update_us;
+        }
+    }
+
+    updateGroup();
+
+    _cycle_us = (uint32_t)(monotonic_us() - cycle_start);
+    if (_cycle_us > _cycle_max_us) {
+        _cycle_max_us = _cycle_us;
+    }
+}
+
+/**
+Clears the longest update times
+*/
+void AxisRegistry::resetTimings() {
+    for (uint8_t i = 0; i < _count; i++) {
+        _axes[i].update_max_us = 0;
+    }
+    _cycle_max_us = 0;
+}
+
+/**
+Finds an axis by name, case insensitive
+
+:return: The axis or nullptr if not found
+*/
+const axis_registry_entry_t* AxisRegistry::find(const char* name) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (strcasecmp(name, _axes[i].name) == 0) {
+            return &_axes[i];
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+Finds the logger of an axis or of one of the gantry motors, case insensitive
+
+:param name: Axis name or motor name
+:return: The logger or nullptr if not found
+*/
+PBIOLogger* AxisRegistry::findLogger(const char* name) const {
+    for (uint8_t i = 0; i < _count; i++) {
+        const axis_registry_entry_t& axis = _axes[i];
+        if (strcasecmp(name, axis.name) == 0) {
+            return axis.gantry ? axis.gantry->get_logger() : axis.motor->get_logger();
+        }
+
+        if (axis.gantry) {
+            if (strcasecmp(name, axis.gantry->motor1().name()) == 0) {
+                return axis.gantry->motor1().get_logger();
+            }
+            if (strcasecmp(name, axis.gantry->motor2().name()) == 0) {
+                return axis.gantry->motor2().get_logger();
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+Number of obstructions that stopped the axis since power-up
+*/
+uint32_t AxisRegistry::collisionCount(uint8_t index) const {
+    const axis_registry_entry_t& axis = _axes[index];
+    return axis.gantry ? axis.gantry->collisionCount() : axis.motor->collision_count();
+}
+
+/**
+Number of maneuvers braked on a software limit since power-up
+*/
+uint32_t AxisRegistry::envelopeViolations(uint8_t index) const {
+    const axis_registry_entry_t& axis = _axes[index];
+    return axis.gantry ? axis.gantry->envelopeViolations() : axis.motor->envelope_violations();
+}
+
+/**
+Moves several axes to their targets in a coordinated way.
+
+All the maneuvers start in the same servo period. The speed and acceleration of the faster
+axes are scaled down, so all of them finish together with the slowest one. The group
+signals its completion once, when the last axis is on target.
+
+:param count: Number of axes in the group
+:param names: Names of the axes
+:param targets: Target angle of each axis in deg
+:param speed: Speed limit of the slowest axis in deg/s
+:param then: What to do after coming to a standstill
+:param wait: Wait for the whole group to complete
+:param cancel_token: Token that stops all the axes of the group while waiting
+*/
+pbio_error_t AxisRegistry::run_targets(uint8_t count, const char* const names[], const float targets[], float speed, pbio_actuation_t then, bool wait, CancelToken* cancel_token) {
+    if (count == 0 || count > _count) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Resolve the axes, keeping the registry order to take the motors always in the same order
+    int8_t target_index[AXIS_REGISTRY_MAX_AXES];
+    memset(target_index, -1, sizeof(target_index));
+    for (uint8_t i = 0; i < count; i++) {
+        const axis_registry_entry_t* axis = find(names[i]);
+        if (axis == nullptr) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+        uint8_t index = axis - _axes;
+        if (target_index[index] >= 0) {
+            return PBIO_ERROR_INVALID_ARG;
+        }
+        target_index[index] = i;
+    }
+
+    uint8_t group_count = 0;
+    uint8_t group_axes[AXIS_REGISTRY_MAX_AXES];
+    Motor* motors[AXIS_REGISTRY_MAX_AXES];
+    int32_t durations[AXIS_REGISTRY_MAX_AXES];
+    int32_t group_duration = 0;
+    for (uint8_t index = 0; index < _count; index++) {
+        if (target_index[index] < 0) {
+            continue;
+        }
+
+        axis_registry_entry_t& axis = _axes[index];
+        Motor* motor = axis.gantry ? &axis.gantry->leadMotor() : axis.motor;
+        pbio_error_t err = motor->get_target_duration(speed, targets[target_index[index]], &durations[group_count]);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+
+        group_duration = max(group_duration, durations[group_count]);
+        group_axes[group_count] = index;
+        motors[group_count] = motor;
+        group_count++;
+    }
+
+    // Start all the maneuvers between two servo periods, with the same start time
+    pbio_error_t err = PBIO_SUCCESS;
+    for (uint8_t i = 0; i < group_count; i++) {
+        motors[i]->begin_sync();
+    }
+
+    int32_t time_start = (int32_t)monotonic_us();
+    for (uint8_t i = 0; i < group_count && err == PBIO_SUCCESS; i++) {
+        float time_scale = group_duration > 0 && durations[i] > 0 ? (float)durations[i] / group_duration : 1.0f;
+        err = motors[i]->run_target_synced(time_start, speed, targets[target_index[group_axes[i]]], time_scale, then);
+    }
+
+    xEventGroupClearBits(_groupEvents, AXIS_GROUP_EVENT_DONE | AXIS_GROUP_EVENT_ERROR);
+    portENTER_CRITICAL(&_groupMux);
+    _groupActive = err == PBIO_SUCCESS;
+    _groupCount = group_count;
+    memcpy(_groupAxes, group_axes, sizeof(group_axes));
+    _groupStatus = PBIO_SUCCESS;
+    portEXIT_CRITICAL(&_groupMux);
+
+    for (int8_t i = group_count - 1; i >= 0; i--) {
+        motors[i]->end_sync();
+    }
+
+    if (err != PBIO_SUCCESS) {
+        // Don't leave part of the group moving
+        stopGroup(true);
+        return err;
+    }
+
+    if (wait) {
+        return wait_for_group(cancel_token, MOTOR_WAIT_FOREVER);
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Signals the completion of the coordinated move. Called by the servo loop after updating the axes
+*/
+void AxisRegistry::updateGroup() {
+    portENTER_CRITICAL(&_groupMux);
+    bool active = _groupActive;
+    uint8_t group_count = _groupCount;
+    uint8_t group_axes[AXIS_REGISTRY_MAX_AXES];
+    memcpy(group_axes, _groupAxes, sizeof(group_axes));
+    portEXIT_CRITICAL(&_groupMux);
+
+    if (!active) {
+        return;
+    }
+
+    bool done = true;
+    for (uint8_t i = 0; i < group_count; i++) {
+        axis_registry_entry_t& axis = _axes[group_axes[i]];
+        Motor& motor = axis.gantry ? axis.gantry->motor1() : *axis.motor;
+        if (motor.is_failed()) {
+            portENTER_CRITICAL(&_groupMux);
+            _groupActive = false;
+            _groupStatus = motor.status();
+            portEXIT_CRITICAL(&_groupMux);
+            xEventGroupSetBits(_groupEvents, AXIS_GROUP_EVENT_ERROR);
+            return;
+        }
+        done = done && motor.is_completion();
+    }
+
+    if (done) {
+        portENTER_CRITICAL(&_groupMux);
+        _groupActive = false;
+        portEXIT_CRITICAL(&_groupMux);
+        xEventGroupSetBits(_groupEvents, AXIS_GROUP_EVENT_DONE);
+    }
+}
+
+/**
+Stops all the axes of the last coordinated move
+
+:param hold: Hold the axes in place, otherwise let them coast
+*/
+void AxisRegistry::stopGroup(bool hold) {
+    portENTER_CRITICAL(&_groupMux);
+    _groupActive = false;
+    uint8_t group_count = _groupCount;
+    uint8_t group_axes[AXIS_REGISTRY_MAX_AXES];
+    memcpy(group_axes, _groupAxes, sizeof(group_axes));
+    portEXIT_CRITICAL(&_groupMux);
+
+    for (uint8_t i = 0; i < group_count; i++) {
+        axis_registry_entry_t& axis = _axes[group_axes[i]];
+        Motor& motor = axis.gantry ? axis.gantry->motor1() : *axis.motor;
+        if (motor.is_failed()) {
+            // Already stopped by its own error reaction
+            continue;
+        }
+
+        if (axis.gantry) {
+            hold ? axis.gantry->hold() : axis.gantry->stop();
+        } else {
+            hold ? axis.motor->hold() : axis.motor->stop();
+        }
+    }
+}
+
+/**
+Wait until the coordinated move is completed or fails
+
+:param cancel_token: Token that stops all the axes of the group and ends the wait
+:param timeout_ms: Maximum wait time (ms). The axes keep moving when the wait times out
+:return: PBIO_SUCCESS, the error of the first failed axis, PBIO_ERROR_CANCELED or PBIO_ERROR_TIMEDOUT
+*/
+pbio_error_t AxisRegistry::wait_for_group(CancelToken* cancel_token, uint32_t timeout_ms) {
+    CancelToken localToken;
+    if (cancel_token == nullptr) {
+        cancel_token = &localToken;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = timeout_ms == MOTOR_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    cancel_token->subscribe(_groupEvents, AXIS_GROUP_EVENT_CANCEL);
+
+    EventBits_t bits = 0;
+    while (true) {
+        IF_CANCELLED(*cancel_token, {
+            cancel_token->unsubscribe(_groupEvents);
+            stopGroup(false);
+            return PBIO_ERROR_CANCELED;
+        });
+
+        TickType_t remaining = portMAX_DELAY;
+        if (timeout != portMAX_DELAY) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            remaining = elapsed < timeout ? timeout - elapsed : 0;
+        }
+
+        bits = xEventGroupWaitBits(_groupEvents, AXIS_GROUP_EVENT_DONE | AXIS_GROUP_EVENT_ERROR | AXIS_GROUP_EVENT_CANCEL, pdFALSE, pdFALSE, remaining);
+        if (bits & (AXIS_GROUP_EVENT_DONE | AXIS_GROUP_EVENT_ERROR)) {
+            break;
+        }
+        if (bits & AXIS_GROUP_EVENT_CANCEL) {
+            xEventGroupClearBits(_groupEvents, AXIS_GROUP_EVENT_CANCEL);
+            continue;
+        }
+
+        cancel_token->unsubscribe(_groupEvents);
+        return PBIO_ERROR_TIMEDOUT;
+    }
+    cancel_token->unsubscribe(_groupEvents);
+
+    if (bits & AXIS_GROUP_EVENT_ERROR) {
+        // Stop the axes still moving, so the group doesn't end apart
+        stopGroup(true);
+        portENTER_CRITICAL(&_groupMux);
+        pbio_error_t status = _groupStatus;
+        portEXIT_CRITICAL(&_groupMux);
+        return status;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Check if the last coordinated move is completed
+*/
+bool AxisRegistry::is_group_completion() const {
+    return (xEventGroupGetBits(_groupEvents) & AXIS_GROUP_EVENT_DONE) != 0;
+}
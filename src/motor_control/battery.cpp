@@ -0,0 +1,130 @@
+#include "motor_control/battery.hpp"
+#include "motor_control/macros.h"
+#include "config.h"
+
+static uint8_t battery_adc_pin;
+static bool battery_compensation = SUPPLY_VOLTAGE_COMPENSATION;
+
+// Written by the sampling task only. Both are 32 bit words, read by the motion task without locks
+static volatile int32_t battery_voltage = 0;
+static volatile uint32_t battery_duty_scale = PBIO_BATTERY_SCALE_ONE;
+
+/**
+Read the supply voltage, averaging a few ADC conversions
+
+A failed conversion reads zero or full scale, and a partly failed average would look like a
+drained supply and boost the duty. So the sample is rejected if any conversion is out of range,
+or if the conversions don't agree.
+
+:param voltage: Return the supply voltage (mV)
+:return: False if the sample is rejected
+ */
+static bool battery_read_voltage(int32_t *voltage) {
+    uint32_t sum = 0;
+    uint32_t min_mv = UINT32_MAX;
+    uint32_t max_mv = 0;
+    for (uint8_t i = 0; i < SUPPLY_VOLTAGE_ADC_SAMPLES; i++) {
+        uint32_t mv = analogReadMilliVolts(battery_adc_pin);
+        if (mv == 0 || mv >= SUPPLY_VOLTAGE_ADC_MAX_MV) {
+            return false;
+        }
+        min_mv = PIO_MIN(min_mv, mv);
+        max_mv = PIO_MAX(max_mv, mv);
+        sum += mv;
+    }
+    if (max_mv - min_mv > SUPPLY_VOLTAGE_ADC_SPREAD_MV) {
+        return false;
+    }
+    *voltage = (int32_t)(sum * SUPPLY_VOLTAGE_DIVIDER / SUPPLY_VOLTAGE_ADC_SAMPLES);
+    return true;
+}
+
+/**
+Update the duty scale from the filtered voltage
+
+Below the minimum voltage the measure isn't trusted, e.g. the board is powered from USB
+without the battery, and the duty is applied as it is.
+ */
+static void battery_update_duty_scale() {
+    int32_t voltage = battery_voltage;
+    if (!battery_compensation || voltage < SUPPLY_VOLTAGE_MIN_MV) {
+        battery_duty_scale = PBIO_BATTERY_SCALE_ONE;
+        return;
+    }
+
+    uint32_t scale = ((uint32_t)SUPPLY_VOLTAGE_NOMINAL_MV << 16) / voltage;
+    if (scale > SUPPLY_VOLTAGE_MAX_SCALE * PBIO_BATTERY_SCALE_ONE) {
+        scale = SUPPLY_VOLTAGE_MAX_SCALE * PBIO_BATTERY_SCALE_ONE;
+    }
+    battery_duty_scale = scale;
+}
+
+static void battery_task(void *parameter) {
+    TickType_t last_wake = xTaskGetTickCount();
+    while (true) {
+        // First order low pass filter, to reject the ripple of the PWM currents
+        int32_t voltage;
+        if (battery_read_voltage(&voltage)) {
+            battery_voltage += (voltage - battery_voltage) / SUPPLY_VOLTAGE_FILTER_DIV;
+            battery_update_duty_scale();
+        }
+
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(SUPPLY_VOLTAGE_SAMPLE_PERIOD_MS));
+    }
+}
+
+/**
+Configure the ADC and start sampling the supply voltage
+
+:param adc_pin: Pin of the supply voltage divider
+ */
+void pbio_battery_begin(uint8_t adc_pin) {
+    battery_adc_pin = adc_pin;
+    analogSetPinAttenuation(adc_pin, ADC_11db);
+
+    // Start from a full measure, so the filter doesn't ramp up from zero. Until a sample
+    // is accepted the voltage stays at zero and the duty isn't scaled
+    int32_t voltage;
+    if (battery_read_voltage(&voltage)) {
+        battery_voltage = voltage;
+    }
+    battery_update_duty_scale();
+
+    xTaskCreatePinnedToCore(
+        battery_task,           // Function to implement the task
+        "battery",              // Name of the task
+        2048,                   // Stack size
+        NULL,                   // Task input parameter
+        OTHER_TASK_HIGH_PRIORITY, // Priority of the task
+        NULL,                   // Task handle
+        OTHER_TASK_CORE         // Core where the task should run
+    );
+}
+
+/**
+Get the filtered supply voltage (mV)
+ */
+int32_t PBIO_IRAM pbio_battery_get_voltage_now() {
+    return battery_voltage;
+}
+
+/**
+Get the scale to apply to the duty to compensate the supply voltage (16.16 fixed point)
+ */
+uint32_t PBIO_IRAM pbio_battery_get_duty_scale() {
+    return battery_duty_scale;
+}
+
+bool pbio_battery_get_compensation() {
+    return battery_compensation;
+}
+
+/**
+Enable or disable the supply voltage compensation
+
+:param enabled: Scale the duty by the nominal to measured voltage ratio
+ */
+void pbio_battery_set_compensation(bool enabled) {
+    battery_compensation = enabled;
+    battery_update_duty_scale();
+}
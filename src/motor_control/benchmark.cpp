@@ -0,0 +1,113 @@
+#include "motor_control/benchmark.hpp"
+#include "config.h"
+#include "esp_cpu.h"
+
+#define BENCHMARK_RANGE_US ((DURATION_MAX_S + 120) * US_PER_SECOND)   // Range of a trajectory until its rebase
+
+typedef void (*benchmark_eval_t)(const pbio_trajectory_t *traject, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref);
+
+/**
+ * Trajectory exercised by the benchmark
+ */
+typedef struct _benchmark_case_t {
+    bool forever;                   /**< Time based forever, otherwise angle based */
+    int32_t t0;                     /**< Start time (us) */
+    int32_t th0;                    /**< Start position (count) */
+    int32_t th3;                    /**< Target position of the angle based ones (count) */
+    int32_t wt;                     /**< Target speed (count/s) */
+    int32_t a;                      /**< Acceleration (count/s^2) */
+} benchmark_case_t;
+
+// Slow, fast and reversed runs, long and short moves, with start times across the wrap of the time
+static const benchmark_case_t benchmark_cases[] = {
+    { true, 0, 0, 0, 1, 8000 },
+    { true, INT32_MAX - 1000000000, 123456, 0, 997, 8000 },
+    { true, -2000000000, -98765, 0, -3001, 3200 },
+    { true, 12345, 0, 0, 20000, 8000 },
+    { false, 777, -50000, 600000, 2000, 50 },
+    { false, INT32_MAX - 5000, 1000, -1000, 400, 8000 },
+    { false, 0, 0, 7, 1000, 8000 },
+};
+
+static void benchmark_make(const benchmark_case_t *c, pbio_trajectory_t *traject) {
+    if (c->forever) {
+        pbio_trajectory_make_time_based(traject, c->t0, DURATION_FOREVER, c->th0, 0, 0, c->wt, abs(c->wt), c->a, c->a);
+    }
+    else {
+        pbio_trajectory_make_angle_based(traject, c->t0, c->th0, c->th3, 0, c->wt, abs(c->wt), c->a, c->a);
+    }
+}
+
+/**
+Time of a sample. The first half is dense over the first seconds, where the speed changes, the
+second half spans the full range. The odd microseconds avoid round times only
+ */
+static int32_t benchmark_time(int32_t t0, uint32_t i) {
+    int64_t offset = i < PBIO_BENCHMARK_SAMPLES / 2 ?
+        (int64_t)i * 2003 :
+        (int64_t)BENCHMARK_RANGE_US * (i - PBIO_BENCHMARK_SAMPLES / 2) / (PBIO_BENCHMARK_SAMPLES / 2) + (i * 7919) % 1000;
+    return (int32_t)((uint32_t)t0 + (uint32_t)offset);
+}
+
+/**
+Return the CPU cycles of evaluating a trajectory at all the sample times
+ */
+static uint32_t benchmark_cycles(const pbio_trajectory_t *traject, benchmark_eval_t eval) {
+    volatile int32_t sink = 0;
+    int32_t count, count_ext, rate, acceleration;
+    esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+    for (uint32_t i = 0; i < PBIO_BENCHMARK_SAMPLES; i++) {
+        eval(traject, benchmark_time(traject->t0, i), &count, &count_ext, &rate, &acceleration);
+        sink += count_ext;
+    }
+    return esp_cpu_get_cycle_count() - start;
+}
+
+/**
+Compare the float evaluator of the trajectories with the int64 one, over the full 35 minutes range
+of a trajectory and across the rebase done by pbio_trajectory_get_reference, and measure their cost.
+
+The cycles include the sample time computation, the same for both evaluators.
+
+:param result: Return the differences and the costs
+ */
+void pbio_benchmark_trajectory(pbio_benchmark_result_t *result) {
+    memset(result, 0, sizeof(pbio_benchmark_result_t));
+    uint64_t cycles_int64 = 0;
+    uint64_t cycles_float = 0;
+    uint32_t evaluations = 0;
+
+    for (const benchmark_case_t &c : benchmark_cases) {
+        pbio_trajectory_t traject;
+        benchmark_make(&c, &traject);
+
+        for (uint32_t i = 0; i < PBIO_BENCHMARK_SAMPLES; i++) {
+            int32_t time = benchmark_time(traject.t0, i);
+            int32_t count_i, count_ext_i, rate_i, acceleration_i;
+            int32_t count_f, count_ext_f, rate_f, acceleration_f;
+            pbio_trajectory_eval_int64(&traject, time, &count_i, &count_ext_i, &rate_i, &acceleration_i);
+            pbio_trajectory_eval_float(&traject, time, &count_f, &count_ext_f, &rate_f, &acceleration_f);
+            int64_t error = ((int64_t)count_f - count_i) * 1000 + count_ext_f - count_ext_i;
+            result->position_error = PIO_MAX(result->position_error, (int32_t)PIO_MIN(llabs(error), INT32_MAX));
+            result->rate_error = PIO_MAX(result->rate_error, abs(rate_f - rate_i));
+        }
+
+        cycles_int64 += benchmark_cycles(&traject, pbio_trajectory_eval_int64);
+        cycles_float += benchmark_cycles(&traject, pbio_trajectory_eval_float);
+        evaluations += PBIO_BENCHMARK_SAMPLES;
+
+        // Run the reference in use across its rebase, against the original trajectory still in range
+        pbio_trajectory_t rebased = traject;
+        int32_t time_rebase = traject.t0 + BENCHMARK_RANGE_US;
+        for (int32_t t = -PBIO_BENCHMARK_REBASE_MS * US_PER_MS; t <= PBIO_BENCHMARK_REBASE_MS * US_PER_MS; t += PBIO_CONFIG_SERVO_PERIOD_MS * US_PER_MS) {
+            int32_t count_i, count_ext_i, count_r, count_ext_r, unused;
+            pbio_trajectory_eval_int64(&traject, time_rebase + t, &count_i, &count_ext_i, &unused, &unused);
+            pbio_trajectory_get_reference(&rebased, time_rebase + t, &count_r, &count_ext_r, &unused, &unused);
+            int64_t error = ((int64_t)count_r - count_i) * 1000 + count_ext_r - count_ext_i;
+            result->rebase_error = PIO_MAX(result->rebase_error, (int32_t)PIO_MIN(llabs(error), INT32_MAX));
+        }
+    }
+
+    result->cycles_int64 = (uint32_t)(cycles_int64 / evaluations);
+    result->cycles_float = (uint32_t)(cycles_float / evaluations);
+}
@@ -0,0 +1,134 @@
+#include "motor_control/collision.hpp"
+#include "motor_control/macros.h"
+#include "motor_control/control.hpp"
+#include "config.h"
+
+/**
+Initialize the detector, disabled, with the default settings
+
+:param s: Control settings of the motor, for the unit conversion
+ */
+void pbio_collision_setup(pbio_collision_t *col, const pbio_control_settings_t *s) {
+    memset(col, 0, sizeof(pbio_collision_t));
+    col->settings.enabled = false;
+    col->settings.threshold = pbio_control_user_to_counts(s, PBIO_COLLISION_DEFAULT_THRESHOLD);
+    col->settings.ticks = PBIO_COLLISION_DEFAULT_TICKS;
+    col->settings.reaction = PBIO_ACTUATION_BRAKE;
+}
+
+/**
+Clear the detection latch and restart the model from the next measure. Called at the start of a maneuver
+ */
+void pbio_collision_reset(pbio_collision_t *col) {
+    col->detected = false;
+    col->primed = false;
+    col->count = 0;
+}
+
+/**
+Latch an obstruction
+
+:param residual: Speed residual that flagged the obstruction (counts/s)
+ */
+void pbio_collision_flag(pbio_collision_t *col, int32_t residual) {
+    col->detected = true;
+    col->primed = false;
+    col->count = 0;
+    col->residual = residual;
+    col->detections++;
+}
+
+/**
+Advance the model by one control period and compare it with the measured speed
+
+The model is the identified first order response from duty to speed. The friction and gravity
+offsets are taken in the direction of the modeled motion. The residual is evaluated only while
+the model is moving faster than the threshold, where the identification is valid.
+
+:param s: Control settings with the identified model
+:param time_now: Current time (us)
+:param rate_now: Measured speed (count/s)
+:param actuation: Actuation type applied in this period
+:param control: Duty applied in this period (duty steps)
+:return: True when an obstruction is detected in this period
+ */
+bool PBIO_IRAM pbio_collision_update(pbio_collision_t *col, const pbio_control_settings_t *s, int32_t time_now, int32_t rate_now, pbio_actuation_t actuation, int32_t control) {
+    if (!col->settings.enabled || col->detected || actuation != PBIO_ACTUATION_DUTY || !pbio_control_settings_has_model(s)) {
+        col->primed = false;
+        col->count = 0;
+        return false;
+    }
+
+    // (Re)start from the measure after a pause or a missed period
+    int32_t elapsed = time_now - col->time_prev;
+    if (!col->primed || elapsed <= 0 || elapsed > 2 * PBIO_CONFIG_SERVO_PERIOD_MS * US_PER_MS) {
+        col->primed = true;
+        col->count = 0;
+        col->rate_model = rate_now;
+        col->time_prev = time_now;
+        col->control_prev = control;
+        return false;
+    }
+
+    // Response to the duty applied in the previous period
+    uint8_t d = col->rate_model >= 0 ? 0 : 1;
+    float offset = s->model.gravity + (d == 0 ? s->model.coulomb : -s->model.coulomb);
+    float a = expf(-(float)elapsed / US_PER_SECOND / s->model.time_constant[d]);
+    col->rate_model = a * col->rate_model + (1.0f - a) * s->model.gain[d] * (col->control_prev - offset);
+    col->time_prev = time_now;
+    col->control_prev = control;
+
+    // Positive when the motor is slower than the model
+    float residual = (col->rate_model - rate_now) * (d == 0 ? 1.0f : -1.0f);
+    if (fabsf(col->rate_model) < col->settings.threshold || residual < col->settings.threshold) {
+        // In agreement, realign the model so it doesn't drift away
+        col->count = 0;
+        col->rate_model = rate_now;
+        return false;
+    }
+
+    col->count++;
+    if (col->count < col->settings.ticks) {
+        return false;
+    }
+
+    pbio_collision_flag(col, (int32_t)residual);
+    return true;
+}
+
+/**
+Return the detector settings in user units
+
+:param enabled: Return true if the detector is enabled
+:param threshold: Return the speed residual that flags an obstruction (deg/s)
+:param ticks: Return the consecutive control periods over the threshold
+:param reaction: Return how the motor is stopped on an obstruction
+ */
+void pbio_collision_get_settings(const pbio_collision_t *col, const pbio_control_settings_t *s, bool *enabled, float *threshold, uint8_t *ticks, pbio_actuation_t *reaction) {
+    *enabled = col->settings.enabled;
+    *threshold = pbio_control_counts_to_user(s, col->settings.threshold);
+    *ticks = col->settings.ticks;
+    *reaction = col->settings.reaction;
+}
+
+/**
+Set the detector settings in user units
+
+:param enabled: Enable the detector
+:param threshold: Speed residual that flags an obstruction (deg/s)
+:param ticks: Consecutive control periods over the threshold
+:param reaction: How to stop the motor on an obstruction: coast, brake or hold
+ */
+pbio_error_t pbio_collision_set_settings(pbio_collision_t *col, const pbio_control_settings_t *s, bool enabled, float threshold, uint8_t ticks, pbio_actuation_t reaction) {
+    if (threshold <= 0 || ticks < 1 || ticks > PBIO_COLLISION_MAX_TICKS || reaction == PBIO_ACTUATION_DUTY) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    col->settings.enabled = enabled;
+    col->settings.threshold = pbio_control_user_to_counts(s, threshold);
+    col->settings.ticks = ticks;
+    col->settings.reaction = reaction;
+    col->primed = false;
+    col->count = 0;
+    return PBIO_SUCCESS;
+}
@@ -2,6 +2,128 @@
 // Copyright (c) 2018-2020 The Pybricks Authors
 
 #include "motor_control/control.hpp"
+#include "motor_control/macros.h"
+
+/**
+Calculate the maximum integrator value for which ki*integrator does not exceed max_control
+
+:param pid_ki: Integral gain in use
+:return: Integrator max value
+ */
+static int32_t PBIO_IRAM control_get_max_integrator(const pbio_control_settings_t *s, int32_t pid_ki) {
+    // If ki is very small, then the integrator is "unlimited"
+    if (pid_ki <= 10) {
+        return 1000000000;
+    }
+    // Get the maximum integrator value for which ki*integrator does not exceed max_control
+    return ((s->max_control*US_PER_MS)/pid_ki)*MS_PER_SECOND;
+}
+
+/**
+Select the gains of the direction of motion
+
+While standing still the gains of the last motion are kept. When the gains change during an angle
+maneuver, the position integrator is recomputed so that the PID duty stays the same (bumpless transfer).
+
+:param rate_ref: Reference speed, or the direction of the followed axis while holding (count/s)
+:param count_err: Position error (count)
+:param rate_err: Speed error (count/s)
+ */
+static void PBIO_IRAM control_update_gains(pbio_control_t *ctl, int32_t rate_ref, int32_t count_err, int32_t rate_err) {
+    int8_t direction = ctl->gains_direction;
+    if (rate_ref > 0) {
+        direction = 1;
+    }
+    else if (rate_ref < 0) {
+        direction = -1;
+    }
+    else if (direction == 0) {
+        direction = 1;
+    }
+
+    pbio_control_gains_t gains;
+    pbio_control_settings_get_gains(&ctl->settings, direction, &gains);
+
+    if (ctl->type == PBIO_CONTROL_ANGLE) {
+        pbio_count_integrator_t *itg = &ctl->count_integrator;
+        bool lqr = pbio_lqr_is_active(&ctl->lqr);
+        int32_t integrator_max = lqr ? pbio_lqr_get_max_integrator(&ctl->lqr, &ctl->settings, direction) :
+                                 control_get_max_integrator(&ctl->settings, gains.pid_ki);
+
+        bool pid_changed = gains.pid_kp != ctl->gains.pid_kp || gains.pid_ki != ctl->gains.pid_ki || gains.pid_kd != ctl->gains.pid_kd;
+        if (!lqr && ctl->gains_direction != 0 && pid_changed && gains.pid_ki > 0) {
+            // Move the duty change of the proportional and derivative terms into the integral term
+            int64_t duty = (int64_t)ctl->gains.pid_kp*count_err + (int64_t)ctl->gains.pid_kd*rate_err + 
+                           ((int64_t)ctl->gains.pid_ki*(itg->count_err_integral/US_PER_MS))/MS_PER_SECOND;
+            int64_t duty_integral = duty - (int64_t)gains.pid_kp*count_err - (int64_t)gains.pid_kd*rate_err;
+            int64_t integral = (duty_integral*US_PER_MS*MS_PER_SECOND)/gains.pid_ki;
+            itg->count_err_integral = (int32_t)PIO_MAX(-integrator_max, PIO_MIN(integral, integrator_max));
+        }
+        itg->count_err_integral_max = integrator_max;
+    }
+
+    ctl->gains = gains;
+    ctl->gains_direction = direction;
+}
+
+/** 
+Check whether the trajectory angle (th3) is reached and the motor is standstill
+
+:param time: Actual time (us)
+:param count: Actual encoder count (count)
+:param rate: Actual speed (count/s)
+:return: True when trajectory angle (th3) is reached and the motor is standstill
+*/
+static inline bool PBIO_IRAM control_on_target_angle(const pbio_trajectory_t *trajectory, const pbio_control_settings_t *settings, int32_t time, int32_t count, int32_t rate) {
+    // if not enough time has expired to be done even in the ideal case, we are certainly not done
+    if (time - trajectory->t3 < 0) {
+        return false;
+    }
+
+    // If distance to target is still bigger than the tolerance, we are not there yet.
+    if (trajectory->th3 - count > settings->count_tolerance) {
+        return false;
+    }
+
+    // // If distance past target is still bigger than the tolerance, we are too far, so not there yet
+    if (count - trajectory->th3 > settings->count_tolerance) {
+        return false;
+    }
+
+    // If the motor is not standing still, we are not there yet
+    if (abs(rate) > settings->rate_tolerance) {
+        return false;
+    }
+
+    // There's nothing left to do, so we must be on target
+    return true;
+}
+
+/**
+Check whether the maneuver is done, on the condition of its type
+
+:param time: Actual time (us)
+:param count: Actual encoder count (count)
+:param rate: Actual speed (count/s)
+:return: True when the maneuver is done
+*/
+static inline bool PBIO_IRAM control_on_target(const pbio_control_t *ctl, int32_t time, int32_t count, int32_t rate) {
+    switch (ctl->on_target_type)
+    {
+    case PBIO_CONTROL_ON_TARGET_ALWAYS:
+        return true;
+    case PBIO_CONTROL_ON_TARGET_NEVER:
+        return false;
+    case PBIO_CONTROL_ON_TARGET_ANGLE:
+        return control_on_target_angle(&ctl->trajectory, &ctl->settings, time, count, rate);
+    case PBIO_CONTROL_ON_TARGET_TIME:
+        return time >= ctl->trajectory.t3;
+    case PBIO_CONTROL_ON_TARGET_STALLED:
+        return ctl->stalled;
+    default:
+        return false;
+    }
+}
 
 /**
 Loop function that control the motor
@@ -13,21 +135,26 @@ Loop function that control the motor
 :param actuation_type: Return current control actuation (pbio_actuation_t)
 :param control: Return motor output (duty steps)
  */
-void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t rate_now, pbio_actuation_t *actuation_type, int32_t *control) {
+void PBIO_IRAM control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t rate_now, pbio_actuation_t *actuation_type, int32_t *control) {
 
     // Declare current time, positions, rates, and their reference value and error
     int32_t time_ref;
     int32_t count_ref, count_ref_ext, count_err, count_err_integral, rate_err_integral;
     int32_t rate_ref, rate_err;
     int32_t acceleration_ref;
-    int32_t duty, duty_due_to_proportional, duty_due_to_integral, duty_due_to_derivative, duty_feedforward;
+    int32_t duty, duty_due_to_proportional, duty_due_to_integral, duty_due_to_derivative, duty_feedforward, duty_disturbance;
 
     // Get the time at which we want to evaluate the reference position/velocities.
     // This compensates for any time we may have spent pausing when the motor was stalled.
     time_ref = pbio_control_get_ref_time(ctl, time_now);
 
+    // Advance the setpoint filter of a tracked target
+    if (ctl->tracker.active) {
+        pbio_tracker_update(&ctl->tracker, &ctl->settings, time_ref);
+    }
+
     // Get reference signals
-    pbio_trajectory_get_reference(&ctl->trajectory, time_ref, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
+    pbio_control_get_reference(ctl, time_ref, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
 
     // Calculate control errors, depending on whether we do angle control or speed control
     if (ctl->type == PBIO_CONTROL_ANGLE) {
@@ -44,14 +171,38 @@ void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, in
         count_err_integral = 0;
     }
 
-    // Corresponding PID control signal
-    duty_due_to_proportional = ctl->settings.pid_kp*count_err;
-    duty_due_to_derivative = ctl->settings.pid_kd*rate_err;
-    duty_due_to_integral = (ctl->settings.pid_ki*(count_err_integral/US_PER_MS))/MS_PER_SECOND;
-    duty_feedforward = pbio_math_sign(rate_ref)*ctl->settings.control_offset;
+    // A follower holds a target that moves with the axis it follows: the reference of the hold
+    // stands still, so the direction of motion comes from the followed axis
+    int32_t rate_dir = rate_ref != 0 ? rate_ref : ctl->lead_direction;
+    ctl->ref_direction = (int8_t)pbio_math_sign(rate_dir);
+
+    // Select the gains of the direction of motion
+    control_update_gains(ctl, rate_dir, count_err, rate_err);
+    if (ctl->type == PBIO_CONTROL_ANGLE) {
+        count_err_integral = ctl->count_integrator.count_err_integral;
+    }
+
+    // Corresponding PID control signal, or the state feedback on the same errors
+    if (pbio_lqr_is_active(&ctl->lqr)) {
+        pbio_lqr_get_feedback(&ctl->lqr, ctl->gains_direction, count_err, rate_err, count_err_integral,
+                              &duty_due_to_proportional, &duty_due_to_derivative, &duty_due_to_integral);
+    }
+    else {
+        duty_due_to_proportional = ctl->gains.pid_kp*count_err;
+        duty_due_to_derivative = ctl->gains.pid_kd*rate_err;
+        duty_due_to_integral = (ctl->gains.pid_ki*(count_err_integral/US_PER_MS))/MS_PER_SECOND;
+    }
+    duty_feedforward = ctl->settings.ff_table.count_step > 0 ?
+                       pbio_control_settings_get_feedforward(&ctl->settings, count_ref, rate_dir) :
+                       pbio_math_sign(rate_dir)*ctl->settings.control_offset;
+
+    // Cancel the load estimated by the disturbance observer. Running until stalled the obstruction
+    // is the expected end of the maneuver, so it must not be pushed against
+    duty_disturbance = ctl->on_target_type == PBIO_CONTROL_ON_TARGET_STALLED ? 0 :
+                       pbio_observer_update(&ctl->observer, &ctl->settings.model, time_now, rate_now);
 
     // Total duty signal, capped by the actuation limit
-    duty = duty_due_to_proportional + duty_due_to_integral + duty_due_to_derivative + duty_feedforward;
+    duty = duty_due_to_proportional + duty_due_to_integral + duty_due_to_derivative + duty_feedforward + duty_disturbance;
     duty = PIO_MAX(-ctl->settings.max_control, PIO_MIN(duty, ctl->settings.max_control));
 
     // This completes the computation of the control signal.
@@ -60,8 +211,13 @@ void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, in
     // We want to stop building up further errors if we are at the proportional duty limit. So, we pause the trajectory
     // if we get at this limit. We wait a little longer though, to make sure it does not fall back to below the limit
     // within one sample, which we can predict using the current rate times the loop time, with a factor two tolerance.
-    int32_t max_windup_duty = (ctl->settings.max_control - ctl->settings.control_offset) + (ctl->settings.pid_kp * abs(rate_now) * PBIO_CONFIG_SERVO_PERIOD_MS * 2) / MS_PER_SECOND;
-    max_windup_duty = (int32_t)(max_windup_duty * ctl->settings.max_windup_factor);
+    // The feedforward in use, from the table or the control offset, takes its share of the duty limit.
+    // The position gain of that prediction is the one of the active control law.
+    int32_t max_windup_duty = (ctl->settings.max_control - abs(duty_feedforward)) +
+                              (pbio_lqr_is_active(&ctl->lqr) ?
+                               pbio_lqr_get_travel_duty(&ctl->lqr, ctl->gains_direction, abs(rate_now), PBIO_CONFIG_SERVO_PERIOD_MS * 2) :
+                               (ctl->gains.pid_kp * abs(rate_now) * PBIO_CONFIG_SERVO_PERIOD_MS * 2) / MS_PER_SECOND);
+    max_windup_duty = (int32_t)(max_windup_duty * ctl->gains.max_windup_factor);
     
     // Position anti-windup: pause trajectory or integration if falling behind despite using maximum duty
 
@@ -93,8 +249,9 @@ void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, in
                    pbio_count_integrator_stalled(&ctl->count_integrator, time_now, rate_now, ctl->settings.stall_time, ctl->settings.stall_rate_limit) :
                    pbio_rate_integrator_stalled(&ctl->rate_integrator, time_now, rate_now, ctl->settings.stall_time, ctl->settings.stall_rate_limit);
 
-    // Check if we are on target
-    ctl->on_target = ctl->on_target_func(&ctl->trajectory, &ctl->settings, time_ref, count_now, rate_now, ctl->stalled);
+    // Check if we are on target. The shaped reference arrives later than the trajectory
+    int32_t time_shaped = ctl->type == PBIO_CONTROL_ANGLE ? time_ref - pbio_shaper_get_duration(&ctl->shaper) : time_ref;
+    ctl->on_target = control_on_target(ctl, time_shaped, count_now, rate_now);
 
     // If we are done and the next action is passive then return zero actuation
     if (ctl->on_target && ctl->after_stop != PBIO_ACTUATION_HOLD) {
@@ -122,9 +279,13 @@ void control_update(pbio_control_t *ctl, int32_t time_now, int32_t count_now, in
 Stops the motor and lets it spin freely
  */
 void pbio_control_stop(pbio_control_t *ctl) {
+    pbio_tracker_stop(&ctl->tracker);
     ctl->type = PBIO_CONTROL_NONE;
     ctl->on_target = true;
-    ctl->on_target_func = pbio_control_on_target_always;
+    ctl->on_target_type = PBIO_CONTROL_ON_TARGET_ALWAYS;
+    ctl->gains_direction = 0;
+    ctl->lead_direction = 0;
+    ctl->ref_direction = 0;
     ctl->stalled = false;
 }
 
@@ -146,22 +307,48 @@ pbio_error_t pbio_control_start_angle_control(pbio_control_t *ctl, int32_t time_
     // Set new maneuver action and stop type, and state
     ctl->after_stop = after_stop;
     ctl->on_target = false;
-    ctl->on_target_func = pbio_control_on_target_angle;
+    ctl->on_target_type = PBIO_CONTROL_ON_TARGET_ANGLE;
+    ctl->lead_direction = 0;
+
+    // Acceleration limit of the direction of motion
+    int32_t abs_acceleration = pbio_control_settings_get_abs_acceleration(&ctl->settings, target_count - count_now);
 
     // Compute the trajectory
     if (ctl->type == PBIO_CONTROL_NONE) {
         // If no control is ongoing, start from physical state
-        err = pbio_trajectory_make_angle_based(&ctl->trajectory, time_now, count_now, target_count, rate_now, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
+        pbio_shaper_reset(&ctl->shaper);
+        err = pbio_trajectory_make_angle_based(&ctl->trajectory, time_now, count_now, target_count, rate_now, target_rate, ctl->settings.max_rate, acceleration, abs_acceleration);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+    }
+    else if (ctl->tracker.active) {
+        // A tracked target is not on a trajectory to patch, so start a new one from the filtered reference
+        int32_t time_ref = pbio_control_get_ref_time(ctl, time_now);
+        int32_t count_start, rate_start, unused;
+        pbio_tracker_get_reference(&ctl->tracker, &count_start, &unused, &rate_start, &unused);
+        pbio_shaper_reset(&ctl->shaper);
+        err = pbio_trajectory_make_angle_based(&ctl->trajectory, time_ref, count_start, target_count, rate_start, target_rate, ctl->settings.max_rate, acceleration, abs_acceleration);
         if (err != PBIO_SUCCESS) {
             return err;
         }
+        pbio_tracker_stop(&ctl->tracker);
     }
     else {
         // If control is ongoing, start from its current reference. First get time on current reference signal
         int32_t time_ref = pbio_control_get_ref_time(ctl, time_now);
 
+        // A shaped reference keeps following the replaced trajectory for the delayed impulses.
+        // A speed reference is not shaped, so the new trajectory is shaped from its start
+        if (ctl->type == PBIO_CONTROL_ANGLE) {
+            pbio_shaper_replace(&ctl->shaper, &ctl->trajectory, time_ref);
+        }
+        else {
+            pbio_shaper_reset(&ctl->shaper);
+        }
+
         // Make the new trajectory and try to patch to existing one
-        err = pbio_trajectory_make_angle_based_patched(&ctl->trajectory, time_ref, target_count, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
+        err = pbio_trajectory_make_angle_based_patched(&ctl->trajectory, time_ref, target_count, target_rate, ctl->settings.max_rate, acceleration, abs_acceleration);
         if (err != PBIO_SUCCESS) {
             return err;
         }
@@ -204,7 +391,7 @@ pbio_error_t pbio_control_start_relative_angle_control(pbio_control_t *ctl, int3
     else {
         int32_t time_ref = pbio_control_get_ref_time(ctl, time_now);
         int32_t unused;
-        pbio_trajectory_get_reference(&ctl->trajectory, time_ref, &count_start, &unused, &unused, &unused);
+        pbio_control_get_reference(ctl, time_ref, &count_start, &unused, &unused, &unused);
     }
 
     // The target count is the start count plus the count to be traveled.  If speed is negative, traveled count also flips.
@@ -220,19 +407,20 @@ pbio_error_t pbio_control_start_relative_angle_control(pbio_control_t *ctl, int3
 }
 
 /**
-Hold the motor at a given angle
+Hold the reference at a given angle, without changing the setpoint filter
 
 :param time_now: Current time (us)
 :param target_count: Angle to hold (count)
  */
-void pbio_control_start_hold_control(pbio_control_t *ctl, int32_t time_now, int32_t target_count) {
+static void control_start_hold(pbio_control_t *ctl, int32_t time_now, int32_t target_count) {
 
     // Set new maneuver action and stop type, and state
     ctl->after_stop = PBIO_ACTUATION_HOLD;
     ctl->on_target = false;
-    ctl->on_target_func = pbio_control_on_target_always;
+    ctl->on_target_type = PBIO_CONTROL_ON_TARGET_ALWAYS;
 
-    // Compute new maneuver based on user argument, starting from the initial state
+    // Compute new maneuver based on user argument, starting from the initial state. Holding is not shaped
+    pbio_shaper_reset(&ctl->shaper);
     pbio_trajectory_make_stationary(&ctl->trajectory, time_now, target_count);
     // If called for the first time, set state and reset PID
     if (ctl->type != PBIO_CONTROL_ANGLE) {
@@ -245,6 +433,48 @@ void pbio_control_start_hold_control(pbio_control_t *ctl, int32_t time_now, int3
     }
 }
 
+/**
+Hold the motor at a given angle
+
+:param time_now: Current time (us)
+:param target_count: Angle to hold (count)
+ */
+void pbio_control_start_hold_control(pbio_control_t *ctl, int32_t time_now, int32_t target_count) {
+    pbio_tracker_stop(&ctl->tracker);
+    ctl->lead_direction = 0;
+    control_start_hold(ctl, time_now, target_count);
+}
+
+/**
+Track a target angle through the setpoint filter. A new target while tracking only redirects the
+filter, so the reference keeps its speed instead of stepping
+
+:param time_now: Current time (us)
+:param count_now: Current encoder angle (count)
+:param rate_now: Current speed (count/sec)
+:param target_count: Angle to track (count)
+ */
+void pbio_control_start_track_control(pbio_control_t *ctl, int32_t time_now, int32_t count_now, int32_t rate_now, int32_t target_count) {
+    // Start from the reference in use if control is ongoing, otherwise from the physical state
+    int32_t count_start = count_now;
+    int32_t rate_start = rate_now;
+    if (!ctl->tracker.active && ctl->type != PBIO_CONTROL_NONE) {
+        int32_t unused;
+        pbio_control_get_reference(ctl, pbio_control_get_ref_time(ctl, time_now), &count_start, &unused, &rate_start, &unused);
+    }
+
+    // The trajectory stands at the target, for the integrator and the maneuver state
+    control_start_hold(ctl, time_now, target_count);
+    ctl->lead_direction = 0;
+
+    if (ctl->tracker.active) {
+        ctl->tracker.target = target_count;
+    }
+    else {
+        pbio_tracker_start(&ctl->tracker, pbio_control_get_ref_time(ctl, time_now), count_start, rate_start, target_count);
+    }
+}
+
 /**
 Runs the motor at a constant speed for a given amount of time
 
@@ -254,22 +484,26 @@ Runs the motor at a constant speed for a given amount of time
 :param rate_now: Current speed (count/sec)
 :param target_rate: Target speed (count/sec)
 :param acceleration: Acceleration/deceleration rate (count/sec^2)
-:param stop_func: On target function to call
+:param stop_type: Condition that ends the maneuver
 :param after_stop: What to do after reaching target angle
  */
-pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, int32_t time_now, int32_t duration, int32_t count_now, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_control_on_target_t stop_func, pbio_actuation_t after_stop) {
+pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, int32_t time_now, int32_t duration, int32_t count_now, int32_t rate_now, int32_t target_rate, int32_t acceleration, pbio_control_on_target_t stop_type, pbio_actuation_t after_stop) {
 
     pbio_error_t err;
 
     // Set new maneuver action and stop type, and state
     ctl->after_stop = after_stop;
     ctl->on_target = false;
-    ctl->on_target_func = stop_func;
+    ctl->on_target_type = stop_type;
+    ctl->lead_direction = 0;
+
+    // Acceleration limit of the direction of motion
+    int32_t abs_acceleration = pbio_control_settings_get_abs_acceleration(&ctl->settings, target_rate);
 
     // Compute the trajectory
     if (ctl->type == PBIO_CONTROL_TIMED) {
         // If timed control is already ongoing make the new trajectory and try to patch to existing one
-        err = pbio_trajectory_make_time_based_patched(&ctl->trajectory, time_now, duration, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
+        err = pbio_trajectory_make_time_based_patched(&ctl->trajectory, time_now, duration, target_rate, ctl->settings.max_rate, acceleration, abs_acceleration);
         if (err != PBIO_SUCCESS) {
             return err;
         }
@@ -278,17 +512,18 @@ pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, int32_t time_
         // If position based control is ongoing, start from its current reference. First get current reference signal.
         int32_t time_ref = pbio_control_get_ref_time(ctl, time_now);
         int32_t count_start, rate_start, unused;
-        pbio_trajectory_get_reference(&ctl->trajectory, time_ref, &count_start, &unused, &rate_start, &unused);
+        pbio_control_get_reference(ctl, time_ref, &count_start, &unused, &rate_start, &unused);
+        pbio_tracker_stop(&ctl->tracker);
 
         // Now start the timed trajectory from there
-        err = pbio_trajectory_make_time_based(&ctl->trajectory, time_now, duration, count_start, 0, rate_start, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
+        err = pbio_trajectory_make_time_based(&ctl->trajectory, time_now, duration, count_start, 0, rate_start, target_rate, ctl->settings.max_rate, acceleration, abs_acceleration);
         if (err != PBIO_SUCCESS) {
             return err;
         }
     }
     else {
         // If no control is ongoing, start from physical state
-        err = pbio_trajectory_make_time_based(&ctl->trajectory, time_now, duration, count_now, 0, rate_now, target_rate, ctl->settings.max_rate, acceleration, ctl->settings.abs_acceleration);
+        err = pbio_trajectory_make_time_based(&ctl->trajectory, time_now, duration, count_now, 0, rate_now, target_rate, ctl->settings.max_rate, acceleration, abs_acceleration);
         if (err != PBIO_SUCCESS) {
             return err;
         }
@@ -306,97 +541,6 @@ pbio_error_t pbio_control_start_timed_control(pbio_control_t *ctl, int32_t time_
     return PBIO_SUCCESS;
 }
 
-/**
-On target function that return always True
-
-:param time: Actual time (us)
-:param count: Actual encoder count (count)
-:param rate: Actual speed (count/s)
-:param stalled: True when the motor is stalled
-:return: Always True
-*/
-static bool _pbio_control_on_target_always(pbio_trajectory_t *trajectory, pbio_control_settings_t *settings, int32_t time, int32_t count, int32_t rate, bool stalled) {
-    return true;
-}
-pbio_control_on_target_t pbio_control_on_target_always = _pbio_control_on_target_always;
-
-/**
-On target function that return always False
-
-:param time: Actual time (us)
-:param count: Actual encoder count (count)
-:param rate: Actual speed (count/s)
-:param stalled: True when the motor is stalled
-:return: Always False
- */
-static bool _pbio_control_on_target_never(pbio_trajectory_t *trajectory, pbio_control_settings_t *settings, int32_t time, int32_t count, int32_t rate, bool stalled) {
-    return false;
-}
-pbio_control_on_target_t pbio_control_on_target_never = _pbio_control_on_target_never;
-
-/** 
-On target function that return true when trajectory angle (th3) is reached and the motor is standstill
-
-:param time: Actual time (us)
-:param count: Actual encoder count (count)
-:param rate: Actual speed (count/s)
-:param stalled: True when the motor is stalled
-:return: True when trajectory angle (th3) is reached and the motor is standstill
-*/
-static bool _pbio_control_on_target_angle(pbio_trajectory_t *trajectory, pbio_control_settings_t *settings, int32_t time, int32_t count, int32_t rate, bool stalled) {
-    // if not enough time has expired to be done even in the ideal case, we are certainly not done
-    if (time - trajectory->t3 < 0) {
-        return false;
-    }
-
-    // If distance to target is still bigger than the tolerance, we are not there yet.
-    if (trajectory->th3 - count > settings->count_tolerance) {
-        return false;
-    }
-
-    // // If distance past target is still bigger than the tolerance, we are too far, so not there yet
-    if (count - trajectory->th3 > settings->count_tolerance) {
-        return false;
-    }
-
-    // If the motor is not standing still, we are not there yet
-    if (abs(rate) > settings->rate_tolerance) {
-        return false;
-    }
-
-    // There's nothing left to do, so we must be on target
-    return true;
-}
-pbio_control_on_target_t pbio_control_on_target_angle = _pbio_control_on_target_angle;
-
-/**
-On target function that return true when trajectory time (t3) is elapsed
-
-:param time: Actual time (us)
-:param count: Actual encoder count (count)
-:param rate: Actual speed (count/s)
-:param stalled: True when the motor is stalled
-:return: True when trajectory time (t3) is elapsed
- */
-static bool _pbio_control_on_target_time(pbio_trajectory_t *trajectory, pbio_control_settings_t *settings, int32_t time, int32_t count, int32_t rate, bool stalled) {
-    return time >= trajectory->t3;
-}
-pbio_control_on_target_t pbio_control_on_target_time = _pbio_control_on_target_time;
-
-/**
-On target function that return true when the motor is stalled
-
-:param time: Actual time (us)
-:param count: Actual encoder count (count)
-:param rate: Actual speed (count/s)
-:param stalled: True when the motor is stalled
-:return: True when the motor is stalled
- */
-static bool _pbio_control_on_target_stalled(pbio_trajectory_t *trajectory, pbio_control_settings_t *settings, int32_t time, int32_t count, int32_t rate, bool stalled) {
-    return stalled;
-}
-pbio_control_on_target_t pbio_control_on_target_stalled = _pbio_control_on_target_stalled;
-
 /**
 Convert control units (counts, rate) in physical user units (deg or mm, deg/s or mm/s)
 
@@ -550,18 +694,235 @@ pbio_error_t pbio_control_settings_set_stall_tolerances(pbio_control_settings_t
     return PBIO_SUCCESS;
 }
 
+/**
+Return the identified plant model in user units
+
+:param gain_pos: Return steady state speed gain moving in positive direction (user units/s per %)
+:param gain_neg: Return steady state speed gain moving in negative direction (user units/s per %)
+:param time_constant_pos: Return speed time constant moving in positive direction (s)
+:param time_constant_neg: Return speed time constant moving in negative direction (s)
+:param coulomb: Return Coulomb friction (%)
+:param viscous: Return viscous friction (% per user units/s)
+:param gravity: Return gravity offset (%)
+ */
+void pbio_control_settings_get_model(const pbio_control_settings_t *s, float *gain_pos, float *gain_neg, float *time_constant_pos, float *time_constant_neg, float *coulomb, float *viscous, float *gravity) {
+    *gain_pos = s->model.gain[0] * s->actuation_scale / s->counts_per_unit;
+    *gain_neg = s->model.gain[1] * s->actuation_scale / s->counts_per_unit;
+    *time_constant_pos = s->model.time_constant[0];
+    *time_constant_neg = s->model.time_constant[1];
+    *coulomb = s->model.coulomb / s->actuation_scale;
+    *viscous = s->model.viscous * s->counts_per_unit / s->actuation_scale;
+    *gravity = s->model.gravity / s->actuation_scale;
+}
+
+/**
+Set the identified plant model in user units
+
+:param gain_pos: Steady state speed gain moving in positive direction (user units/s per %)
+:param gain_neg: Steady state speed gain moving in negative direction (user units/s per %)
+:param time_constant_pos: Speed time constant moving in positive direction (s)
+:param time_constant_neg: Speed time constant moving in negative direction (s)
+:param coulomb: Coulomb friction (%)
+:param viscous: Viscous friction (% per user units/s)
+:param gravity: Gravity offset (%)
+ */
+pbio_error_t pbio_control_settings_set_model(pbio_control_settings_t *s, float gain_pos, float gain_neg, float time_constant_pos, float time_constant_neg, float coulomb, float viscous, float gravity) {
+    if (gain_pos < 0 || gain_neg < 0 || time_constant_pos < 0 || time_constant_neg < 0 || coulomb < 0 || viscous < 0) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    s->model.gain[0] = gain_pos * s->counts_per_unit / s->actuation_scale;
+    s->model.gain[1] = gain_neg * s->counts_per_unit / s->actuation_scale;
+    s->model.time_constant[0] = time_constant_pos;
+    s->model.time_constant[1] = time_constant_neg;
+    s->model.coulomb = coulomb * s->actuation_scale;
+    s->model.viscous = viscous * s->actuation_scale / s->counts_per_unit;
+    s->model.gravity = gravity * s->actuation_scale;
+    return PBIO_SUCCESS;
+}
+
+/**
+Return true if the plant model has been identified
+
+:return: True if the model can be used
+ */
+bool pbio_control_settings_has_model(const pbio_control_settings_t *s) {
+    return s->model.gain[0] > 0 && s->model.gain[1] > 0 && 
+        s->model.time_constant[0] > 0 && s->model.time_constant[1] > 0;
+}
+
+/**
+Get the position indexed feedforward table
+
+:param table: Return a copy of the table
+ */
+void pbio_control_settings_get_ff_table(const pbio_control_settings_t *s, pbio_control_ff_table_t *table) {
+    *table = s->ff_table;
+}
+
+/**
+Set the position indexed feedforward table. A table with zero step disables it and restores the control offset
+
+:param table: Table to copy in the settings
+ */
+pbio_error_t pbio_control_settings_set_ff_table(pbio_control_settings_t *s, const pbio_control_ff_table_t *table) {
+    if (table->count_step < 0) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    for (uint8_t d = 0; d < 2; d++) {
+        for (uint8_t i = 0; i < PBIO_CONTROL_FF_TABLE_POINTS; i++) {
+            if (abs(table->duty[d][i]) > s->max_control) {
+                return PBIO_ERROR_INVALID_ARG;
+            }
+        }
+    }
+
+    s->ff_table = *table;
+    return PBIO_SUCCESS;
+}
+
+/**
+Interpolate the feedforward table at the given position
+
+Outside of the table the first or the last point is used. At standstill the mean of
+the two directions is used: it holds the axis against gravity, while the friction helps.
+
+:param count: Position (count)
+:param rate: Reference speed (count/s), selects the direction of motion
+:return: Feedforward (duty steps)
+ */
+int32_t PBIO_IRAM pbio_control_settings_get_feedforward(const pbio_control_settings_t *s, int32_t count, int32_t rate) {
+    const pbio_control_ff_table_t *t = &s->ff_table;
+    if (t->count_step <= 0) {
+        return 0;
+    }
+
+    // Find the table interval and the position within it
+    int32_t offset = count - t->count_start;
+    int32_t index = offset / t->count_step;
+    int32_t fraction = offset % t->count_step;
+    if (offset <= 0) {
+        index = 0;
+        fraction = 0;
+    }
+    else if (index >= PBIO_CONTROL_FF_TABLE_POINTS - 1) {
+        index = PBIO_CONTROL_FF_TABLE_POINTS - 1;
+        fraction = 0;
+    }
+
+    int32_t duty[2];
+    for (uint8_t d = 0; d < 2; d++) {
+        int32_t d0 = t->duty[d][index];
+        int32_t d1 = fraction > 0 ? t->duty[d][index + 1] : d0;
+        duty[d] = d0 + (int32_t)(((int64_t)(d1 - d0) * fraction) / t->count_step);
+    }
+
+    if (rate > 0) {
+        return duty[0];
+    }
+    if (rate < 0) {
+        return duty[1];
+    }
+    return (duty[0] + duty[1]) / 2;
+}
+
+/**
+Return the gains used while moving in negative direction, in user units
+
+:param pid_kp: Return PID Kp
+:param pid_ki: Return PID Ki
+:param pid_kd: Return PID Kd
+:param acceleration: Return acceleration/deceleration (user units/s^2)
+:param max_windup_factor: Return integrator max windup factor
+ */
+void pbio_control_settings_get_gains_neg(const pbio_control_settings_t *s, int16_t *pid_kp, int16_t *pid_ki, int16_t *pid_kd, float *acceleration, float *max_windup_factor) {
+    // Until they are set, the negative direction gains are the same of the positive direction
+    pbio_control_gains_t gains = s->gains_neg;
+    if (gains.abs_acceleration == 0) {
+        pbio_control_settings_get_gains(s, 1, &gains);
+    }
+
+    *pid_kp = gains.pid_kp;
+    *pid_ki = gains.pid_ki;
+    *pid_kd = gains.pid_kd;
+    *acceleration = pbio_control_counts_to_user(s, gains.abs_acceleration);
+    *max_windup_factor = gains.max_windup_factor;
+}
+
+/**
+Set the gains used while moving in negative direction, in user units
+
+:param pid_kp: PID Kp
+:param pid_ki: PID Ki
+:param pid_kd: PID Kd
+:param acceleration: Acceleration/deceleration (user units/s^2)
+:param max_windup_factor: Integrator max windup factor
+ */
+pbio_error_t pbio_control_settings_set_gains_neg(pbio_control_settings_t *s, int16_t pid_kp, int16_t pid_ki, int16_t pid_kd, float acceleration, float max_windup_factor) {
+    if (pid_kp < 0 || pid_ki < 0 || pid_kd < 0 || acceleration < 1 || max_windup_factor <= 0) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    s->gains_neg.pid_kp = pid_kp;
+    s->gains_neg.pid_ki = pid_ki;
+    s->gains_neg.pid_kd = pid_kd;
+    s->gains_neg.abs_acceleration = pbio_control_user_to_counts(s, acceleration);
+    s->gains_neg.max_windup_factor = max_windup_factor;
+    return PBIO_SUCCESS;
+}
+
+/**
+Enable or disable the gains scheduling on the direction of motion
+
+When enabled for the first time the negative direction gains start as a copy of the positive ones.
+
+:param enable: True to use the negative direction gains while moving in negative direction
+ */
+void pbio_control_settings_set_gain_scheduling(pbio_control_settings_t *s, bool enable) {
+    if (enable && s->gains_neg.abs_acceleration == 0) {
+        pbio_control_settings_get_gains(s, 1, &s->gains_neg);
+    }
+    s->gain_scheduling = enable;
+}
+
+/**
+Return the gains of a direction of motion
+
+:param direction: Direction of motion, negative values select the negative direction gains
+:param gains: Return the gains in control units
+ */
+void PBIO_IRAM pbio_control_settings_get_gains(const pbio_control_settings_t *s, int32_t direction, pbio_control_gains_t *gains) {
+    if (s->gain_scheduling && direction < 0) {
+        *gains = s->gains_neg;
+        return;
+    }
+    gains->pid_kp = s->pid_kp;
+    gains->pid_ki = s->pid_ki;
+    gains->pid_kd = s->pid_kd;
+    gains->abs_acceleration = s->abs_acceleration;
+    gains->max_windup_factor = s->max_windup_factor;
+}
+
+/**
+Return the acceleration limit of a direction of motion
+
+:param direction: Direction of motion, negative values select the negative direction limit
+:return: Acceleration limit (count/s^2)
+ */
+int32_t PBIO_IRAM pbio_control_settings_get_abs_acceleration(const pbio_control_settings_t *s, int32_t direction) {
+    if (s->gain_scheduling && direction < 0) {
+        return s->gains_neg.abs_acceleration;
+    }
+    return s->abs_acceleration;
+}
+
 /**
 Calculate the maximum integrator value for witch ki*integrator does not exceed max_control
 
 :return: Integrator max value
  */
 int32_t pbio_control_settings_get_max_integrator(const pbio_control_settings_t *s) {
-    // If ki is very small, then the integrator is "unlimited"
-    if (s->pid_ki <= 10) {
-        return 1000000000;
-    }
-    // Get the maximum integrator value for which ki*integrator does not exceed max_control
-    return ((s->max_control*US_PER_MS)/s->pid_ki)*MS_PER_SECOND;
+    return control_get_max_integrator(s, s->pid_ki);
 }
 
 /**
@@ -570,7 +931,7 @@ Return the integrator current time
 :param time_now: Current time in us
 :return: Integrator current reference time (us)
  */
-int32_t pbio_control_get_ref_time(const pbio_control_t *ctl, int32_t time_now) {
+int32_t PBIO_IRAM pbio_control_get_ref_time(const pbio_control_t *ctl, int32_t time_now) {
 
     if (ctl->type == PBIO_CONTROL_ANGLE) {
         return pbio_count_integrator_get_ref_time(&ctl->count_integrator, time_now);
@@ -581,10 +942,31 @@ int32_t pbio_control_get_ref_time(const pbio_control_t *ctl, int32_t time_now) {
     return 0;
 }
 
+/**
+Get the reference the control follows, shaped when under angle control
+
+:param time_ref: Time of reference evaluation (us)
+:param count_ref: Return the reference position (count)
+:param count_ref_ext: Return the reference position decimals (millicount)
+:param rate_ref: Return the reference speed (count/s)
+:param acceleration_ref: Return the reference acceleration (count/s^2)
+*/
+void PBIO_IRAM pbio_control_get_reference(pbio_control_t *ctl, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref) {
+    if (ctl->tracker.active) {
+        pbio_tracker_get_reference(&ctl->tracker, count_ref, count_ref_ext, rate_ref, acceleration_ref);
+    }
+    else if (ctl->type == PBIO_CONTROL_ANGLE) {
+        pbio_shaper_get_reference(&ctl->shaper, &ctl->trajectory, time_ref, count_ref, count_ref_ext, rate_ref, acceleration_ref);
+    }
+    else {
+        pbio_trajectory_get_reference(&ctl->trajectory, time_ref, count_ref, count_ref_ext, rate_ref, acceleration_ref);
+    }
+}
+
 /**
 Return true when there is an ongoing command and the motor is stalled
 */
-bool pbio_control_is_stalled(pbio_control_t *ctl) {
+bool PBIO_IRAM pbio_control_is_stalled(pbio_control_t *ctl) {
     return ctl->type != PBIO_CONTROL_NONE && ctl->stalled;
 }
 
@@ -593,7 +975,7 @@ Checks if an ongoing command or maneuver is done
 
 :return: True is the maneuver is done
 */
-bool pbio_control_is_done(pbio_control_t *ctl) {
+bool PBIO_IRAM pbio_control_is_done(pbio_control_t *ctl) {
     return ctl->type == PBIO_CONTROL_NONE || ctl->on_target;
 }
 
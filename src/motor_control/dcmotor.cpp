@@ -1,20 +1,86 @@
 #include "motor_control/dcmotor.hpp"
+#include "motor_control/macros.h"
 
-void DCMotor::begin(uint8_t pwmPin1, uint8_t pwmPin2, pbio_direction_t direction, uint16_t userPwmMax) {
-    _pwmPin1 = pwmPin1;
-    _pwmPin2 = pwmPin2;
+uint8_t DCMotor::_instances = 0;
+
+static void check(esp_err_t err) {
+    if (err != ESP_OK)
+        throw -1;
+}
+
+/**
+Set up the MCPWM timer, operator, comparator and generators of the motor and coast it
+
+The timer runs at the fastest integer division of the MCPWM clock that still gives at least
+the requested resolution in a period, so the actual resolution is usually a bit finer.
+
+:param pwmPin1: Pin driven with PWM when the duty is positive
+:param pwmPin2: Pin driven with PWM when the duty is negative
+:param direction: Motor direction
+:param userPwmMax: Duty that gives the full period (duty steps)
+:param frequency: PWM frequency (Hz)
+:param resolution: Minimum resolution of the duty in a PWM period (bits)
+ */
+void DCMotor::begin(uint8_t pwmPin1, uint8_t pwmPin2, pbio_direction_t direction, uint16_t userPwmMax, uint32_t frequency, uint8_t resolution) {
     _direction = direction;
     _userPwmMax = userPwmMax;
 
-    bool success = ledcAttach(pwmPin1, MOTOR_PWM_FREQUENCY, MOTOR_PWM_RESOLUTION);
-    success = ledcAttach(pwmPin2, MOTOR_PWM_FREQUENCY, MOTOR_PWM_RESOLUTION);
-    if (!success)
+    uint8_t group = _instances / SOC_MCPWM_OPERATORS_PER_GROUP;
+    if (group >= SOC_MCPWM_GROUPS || frequency == 0 || resolution == 0 || userPwmMax == 0)
+        throw -1;
+
+    uint32_t prescale = MOTOR_MCPWM_CLOCK_HZ / (frequency << resolution);
+    if (prescale == 0)
         throw -1;
+    uint32_t resolution_hz = MOTOR_MCPWM_CLOCK_HZ / prescale;
+    _periodTicks = resolution_hz / frequency;
+    if (_periodTicks > UINT16_MAX)
+        throw -1;
+    _dutyScale = (_periodTicks << 16) / userPwmMax;
+
+    mcpwm_timer_config_t timer_config = {};
+    timer_config.group_id = group;
+    timer_config.clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT;
+    timer_config.resolution_hz = resolution_hz;
+    timer_config.count_mode = MCPWM_TIMER_COUNT_MODE_UP;
+    timer_config.period_ticks = _periodTicks;
+    check(mcpwm_new_timer(&timer_config, &_timer));
+
+    mcpwm_operator_config_t operator_config = {};
+    operator_config.group_id = group;
+    check(mcpwm_new_operator(&operator_config, &_operator));
+    check(mcpwm_operator_connect_timer(_operator, _timer));
+
+    // Latch the compare value at the start of the period
+    mcpwm_comparator_config_t comparator_config = {};
+    comparator_config.flags.update_cmp_on_tez = true;
+    check(mcpwm_new_comparator(_operator, &comparator_config, &_comparator));
+
+    mcpwm_generator_config_t generator_config = {};
+    generator_config.gen_gpio_num = pwmPin1;
+    check(mcpwm_new_generator(_operator, &generator_config, &_gen1));
+    generator_config.gen_gpio_num = pwmPin2;
+    check(mcpwm_new_generator(_operator, &generator_config, &_gen2));
+
+    mcpwm_gen_handle_t generators[2] = { _gen1, _gen2 };
+    for (uint8_t i = 0; i < 2; i++) {
+        check(mcpwm_generator_set_action_on_timer_event(generators[i],
+            MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, MCPWM_TIMER_EVENT_EMPTY, MCPWM_GEN_ACTION_HIGH)));
+        check(mcpwm_generator_set_action_on_compare_event(generators[i],
+            MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, _comparator, MCPWM_GEN_ACTION_LOW)));
+    }
 
+    _output = DCMOTOR_OUTPUT_NONE;
+    _cmpTicks = UINT32_MAX;
+    setCompare(0);
     coast();
+
+    check(mcpwm_timer_enable(_timer));
+    check(mcpwm_timer_start_stop(_timer, MCPWM_TIMER_START_NO_STOP));
+    _instances++;
 }
 
-void DCMotor::getState(pbio_passivity_t *state, int32_t *duty_now) const {
+void PBIO_IRAM DCMotor::getState(pbio_passivity_t *state, int32_t *duty_now) const {
     *state = _state;
     *duty_now = _duty_now;
 }
@@ -23,35 +89,84 @@ uint16_t DCMotor::getUserPwmMax() {
     return _userPwmMax;
 }
 
-void DCMotor::coast() {
-    _state = PBIO_DCMOTOR_COAST;
-    set_duty_cycle(0);
+/**
+Set the output stage, forcing the pins that don't carry the PWM. A force level of -1 releases
+the pin to the generator actions
+ */
+void PBIO_IRAM DCMotor::setOutput(dcmotor_output_t output) {
+    if (output == _output)
+        return;
+
+    switch (output) {
+        case DCMOTOR_OUTPUT_BRAKE:
+            mcpwm_generator_set_force_level(_gen1, 1, true);
+            mcpwm_generator_set_force_level(_gen2, 1, true);
+            break;
+        case DCMOTOR_OUTPUT_FORWARD:
+            mcpwm_generator_set_force_level(_gen1, -1, true);
+            mcpwm_generator_set_force_level(_gen2, 0, true);
+            break;
+        case DCMOTOR_OUTPUT_BACKWARD:
+            mcpwm_generator_set_force_level(_gen1, 0, true);
+            mcpwm_generator_set_force_level(_gen2, -1, true);
+            break;
+        default:
+            mcpwm_generator_set_force_level(_gen1, 0, true);
+            mcpwm_generator_set_force_level(_gen2, 0, true);
+            break;
+    }
+    _output = output;
 }
 
-void DCMotor::brake() {
-    _state = PBIO_DCMOTOR_BRAKE;
-    set_duty_cycle(MOTOR_PWM_MAX_VALUE);
+void PBIO_IRAM DCMotor::setCompare(uint32_t ticks) {
+    if (ticks == _cmpTicks)
+        return;
+
+    mcpwm_comparator_set_compare_value(_comparator, ticks);
+    _cmpTicks = ticks;
 }
 
-void DCMotor::set_duty_cycle(int32_t duty_steps) {
+void PBIO_IRAM DCMotor::coast() {
+    _state = PBIO_DCMOTOR_COAST;
+    _duty_now = 0;
+    setOutput(DCMOTOR_OUTPUT_COAST);
+}
+
+void PBIO_IRAM DCMotor::brake() {
     _state = PBIO_DCMOTOR_BRAKE;
-    _duty_now = duty_steps;
+    _duty_now = 0;
+    setOutput(DCMOTOR_OUTPUT_BRAKE);
+}
 
-    duty_steps = duty_steps * MOTOR_PWM_MAX_VALUE / _userPwmMax;
+/**
+Drive the motor with a duty cycle
 
-    if (duty_steps > MOTOR_PWM_MAX_VALUE)
-        duty_steps = MOTOR_PWM_MAX_VALUE;
-    if (duty_steps < -MOTOR_PWM_MAX_VALUE)
-        duty_steps = -MOTOR_PWM_MAX_VALUE;
+:param duty_steps: Duty, signed, where userPwmMax is the full period (duty steps)
+:param scale: Scale applied to the duty at the output, the state keeps the requested duty (16.16 fixed point)
+ */
+void PBIO_IRAM DCMotor::set_duty_cycle(int32_t duty_steps, uint32_t scale) {
+    _state = PBIO_DCMOTOR_DUTY_PASSIVE;
+    _duty_now = duty_steps;
 
     if (_direction == PBIO_DIRECTION_COUNTERCLOCKWISE)
         duty_steps = -duty_steps;
 
-    if (duty_steps >= 0) {
-        ledcWrite(_pwmPin1, duty_steps);
-        ledcWrite(_pwmPin2, 0);
-    } else {
-        ledcWrite(_pwmPin1, 0);
-        ledcWrite(_pwmPin2, -duty_steps);
+    uint32_t magnitude = duty_steps >= 0 ? duty_steps : -duty_steps;
+    if (scale != PBIO_BATTERY_SCALE_ONE)
+        magnitude = ((uint64_t)magnitude * scale) >> 16;
+    if (magnitude > _userPwmMax)
+        magnitude = _userPwmMax;
+
+    // The compare event can't fire past the last tick of the period
+    uint32_t ticks = (magnitude * _dutyScale) >> 16;
+    if (ticks >= _periodTicks)
+        ticks = _periodTicks - 1;
+
+    if (ticks == 0) {
+        setOutput(DCMOTOR_OUTPUT_COAST);
+        return;
     }
+
+    setCompare(ticks);
+    setOutput(duty_steps > 0 ? DCMOTOR_OUTPUT_FORWARD : DCMOTOR_OUTPUT_BACKWARD);
 }
@@ -0,0 +1,97 @@
+#include "motor_control/envelope.hpp"
+#include "motor_control/const.h"
+#include "motor_control/macros.h"
+#include "config.h"
+
+/**
+Initialize the envelope, disabled and not armed, without limits
+ */
+void pbio_envelope_setup(pbio_envelope_t *env) {
+    memset(env, 0, sizeof(pbio_envelope_t));
+    env->count_min = INT32_MIN;
+    env->count_max = INT32_MAX;
+}
+
+/**
+Set the limits
+
+:param count_min: Lower limit (count)
+:param count_max: Upper limit (count)
+ */
+void pbio_envelope_set_limits(pbio_envelope_t *env, int32_t count_min, int32_t count_max) {
+    env->count_min = count_min;
+    env->count_max = count_max;
+}
+
+/**
+Arm the envelope once the position is referenced, disarm it while the reference is searched
+
+:param armed: The position frame is referenced
+ */
+void pbio_envelope_arm(pbio_envelope_t *env, bool armed) {
+    env->armed = armed;
+}
+
+/**
+:return: True when the limits are enforced
+ */
+bool PBIO_IRAM pbio_envelope_is_active(const pbio_envelope_t *env) {
+    return env->enabled && env->armed && env->count_min <= env->count_max;
+}
+
+/**
+Bring a target within the limits, when they are enforced
+
+:param count: Target (count)
+:return: The target within the limits (count)
+ */
+int32_t pbio_envelope_clamp(const pbio_envelope_t *env, int32_t count) {
+    if (!pbio_envelope_is_active(env)) {
+        return count;
+    }
+    return PIO_MAX(env->count_min, PIO_MIN(count, env->count_max));
+}
+
+/**
+Check whether the motor still stops within the limits when it starts braking in the next period
+
+:param ctl: Controller, for the maneuver in progress and the acceleration limits
+:param count_now: Current position (count)
+:param rate_now: Current speed (count/s)
+:param count_limit: Return the limit to stop on
+:return: True when the maneuver must be replaced by a braking trajectory now
+ */
+bool PBIO_IRAM pbio_envelope_update(pbio_envelope_t *env, const pbio_control_t *ctl, int32_t count_now, int32_t rate_now, int32_t *count_limit) {
+    if (!pbio_envelope_is_active(env) || rate_now == 0) {
+        return false;
+    }
+
+    // Maneuvers that end within the limits, or on an obstacle
+    if (ctl->type == PBIO_CONTROL_ANGLE) {
+        int32_t target = ctl->tracker.active ? ctl->tracker.target : ctl->trajectory.th3;
+        if (target >= env->count_min && target <= env->count_max) {
+            return false;
+        }
+    }
+    else if (ctl->type == PBIO_CONTROL_TIMED && ctl->on_target_type == PBIO_CONTROL_ON_TARGET_STALLED) {
+        return false;
+    }
+
+    // Braking distance at the acceleration limit, plus the travel until the brake starts
+    int64_t rate = rate_now;
+    int64_t acceleration = PIO_MAX(pbio_control_settings_get_abs_acceleration(&ctl->settings, rate_now), 1);
+    int64_t distance = rate * rate / (2 * acceleration) +
+                       (llabs(rate) * PBIO_ENVELOPE_MARGIN_TICKS * PBIO_CONFIG_SERVO_PERIOD_MS) / MS_PER_SECOND;
+
+    int32_t limit = rate_now > 0 ? env->count_max : env->count_min;
+    int64_t room = rate_now > 0 ? (int64_t)limit - count_now : (int64_t)count_now - limit;
+    if (distance < room) {
+        return false;
+    }
+
+    env->violations++;
+    env->violation_count = count_now;
+    env->violation_rate = rate_now;
+    *count_limit = limit;
+    return true;
+}
@@ -35,6 +35,8 @@ const char *pbio_error_str(pbio_error_t err) {
         return "Tacho sequence error";
     case PBIO_ERROR_HOME_SWITCH_ERR:
         return "Home switch sequence error";
+    case PBIO_ERROR_COLLISION:
+        return "Collision detected";
     }
 
     return nullptr;
@@ -2,8 +2,9 @@
 // Copyright (c) 2018-2020 The Pybricks Authors
 
 #include "motor_control/extra_math.h"
+#include "motor_control/macros.h"
 
-int32_t pbio_math_sign(int32_t a) {
+int32_t PBIO_IRAM pbio_math_sign(int32_t a) {
     if (a == 0) {
         return 0;
     }
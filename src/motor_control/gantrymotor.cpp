@@ -1,5 +1,7 @@
 #include "motor_control/gantrymotor.hpp"
 #include "motor_control/servo.hpp"
+#include "motor_control/macros.h"
+#include "utils/logger.hpp"
 
 void GantryMotor::begin(const char* name) {
     _name = name;
@@ -21,11 +23,36 @@ float GantryMotor::speed() const {
     return _motor1.speed();
 }
 
+/**
+Resets the angle of both motors, which references the axis, and applies the homed skew.
+
+Before homing motor 2 holds the offset the frame had at power-up, so the gantry isn't racked
+by a skew referred to another position.
+
+:param angle: Value in deg to which the angle should be reset
+*/
 void GantryMotor::reset_angle(float angle) {
     _motor1.reset_angle(angle);
     _motor2.reset_angle(angle);
-    _skew_pos_compensation = 0.0f;
+    _skew_pos_compensation = _skew_homed;
+    _referenced = true;
+    memset(_skew_balance_ticks, 0, sizeof(_skew_balance_ticks));
+}
+
+/**
+Sets the angles of the two motors and the skew compensation to known values, and marks the
+axis as referenced. Used to restore a position saved before a reset, instead of homing
+
+:param angle1: Angle of motor 1 (deg)
+:param angle2: Angle of motor 2 (deg)
+:param skew_compensation: Skew compensation in use at the saved position (deg)
+*/
+void GantryMotor::restore_angles(float angle1, float angle2, float skew_compensation) {
+    _motor1.reset_angle(angle1);
+    _motor2.reset_angle(angle2);
+    _skew_pos_compensation = skew_compensation;
     _referenced = true;
+    memset(_skew_balance_ticks, 0, sizeof(_skew_balance_ticks));
 }
 
 /**
@@ -34,6 +61,7 @@ Stops the motor and lets it spin freely
 The motor gradually stops due to friction
 */
 void GantryMotor::stop() {
+    _open_loop = false;
     _motor1.stop();
     _motor2.stop();
 }
@@ -44,6 +72,7 @@ Passively brakes the motor
 The motor stops due to friction, plus the voltage that is generated while the motor is still moving
 */
 void GantryMotor::brake() {
+    _open_loop = false;
     _motor1.brake();
     _motor2.brake();
 }
@@ -52,23 +81,46 @@ void GantryMotor::brake() {
 Stops the motor and actively holds it at its current angle.
 */
 void GantryMotor::hold() {
+    _open_loop = false;
     _motor1.hold();
     _motor2.hold();
 }
 
+/**
+Rotates the motors at a given duty cycle (also known as "power").
+
+Motor 2 mirrors the duty cycle of motor 1 until another command is given.
+
+:param duty: The duty cycle (-100.0 to 100)
+*/
+void GantryMotor::dc(float duty) {
+    _motor1.dc(duty);
+    _motor2.dc(duty);
+    _open_loop = true;
+}
+
 void GantryMotor::update() {
     _motor1.update();
 
     // Motor 2 follows motor 1 with a position compensation to correct gantry skew
     // only if the motor 1 is in a position hold control mode
     pbio_control_type_t state = _motor1.getActuationStatus();
-    if (state == PBIO_CONTROL_ANGLE || state == PBIO_CONTROL_TIMED) {
+    if (_homing) {
+        // Each motor runs against the reference obstacle on its own
+    }
+    else if (state == PBIO_CONTROL_ANGLE || state == PBIO_CONTROL_TIMED) {
         // Apply a feedforward target to motor 2 based on motor 1 position and speed
         float speed1 = _motor1.speed();
         float angle1 = _motor1.angle();
         float angle2 = angle1 + (speed1 * (float)PBIO_CONFIG_SERVO_PERIOD_MS / 1000.0f / 2.0f); // Apply half the speed as feedforward
         angle2 += _skew_pos_compensation;
-        _motor2.track_target(angle2);
+
+        // The hold of motor 2 stands still, so its gains and feedforward take the direction of motor 1
+        _motor2.track_target(angle2, false, _motor1.reference_direction());
+    }
+    else if (_open_loop) {
+        // Motor 1 is driven in open loop, so apply the same duty cycle to motor 2
+        _motor2.dc(_motor1.duty());
     }
     else {
         // Motor 1 is not in position control mode, so just release motor 2
@@ -77,6 +129,22 @@ void GantryMotor::update() {
 
     _motor2.update();
 
+    // An obstruction seen by motor 2 stops the whole axis
+    uint32_t collisions2 = _motor2.collision_count();
+    if (collisions2 != _motor2_collisions) {
+        _motor2_collisions = collisions2;
+        _motor2_collision_latched = true;
+        _motor1.collision_stop(_motor2.collision_residual());
+    }
+    else if (_motor2_collision_latched && !_motor1.collision_detected()) {
+        // Motor 2 keeps tracking targets while motor 1 holds after the obstruction, so it never
+        // starts a maneuver of its own. Its latch follows the one of motor 1, cleared by the next move
+        _motor2_collision_latched = false;
+        _motor2.collision_reset();
+    }
+
+    learn_skew();
+
     PBIOLogger* logger = get_logger();
     if (logger && logger->is_active()) {
         int32_t count_now = _motor2.motor_count();
@@ -87,3 +155,202 @@ void GantryMotor::update() {
         });
     }
 }
+
+
+/**
+Estimates the gantry skew from the effort balance between the two motors.
+
+The two sides of the frame don't carry the same load or friction, so the duty difference between
+the motors isn't zero even when the frame is square. It is averaged right after the homing, when
+the frame is known square, separately while holding and while moving in each direction. A racked
+frame loads motor 2 against motor 1 and shifts the balance, so the compensation slowly moves the
+target of motor 2 back toward where the frame holds it, until the balance is back within the
+deadband. At higher speeds the tracking error of the second motor would bias the estimate, so the
+learning is paused.
+*/
+void GantryMotor::learn_skew() {
+    pbio_control_type_t state = _motor1.getActuationStatus();
+    if (!_referenced || _homing || (state != PBIO_CONTROL_ANGLE && state != PBIO_CONTROL_TIMED)) {
+        return;
+    }
+
+    float skew_error = getMeasuredSkew() - _skew_pos_compensation;
+    _skew_alarm = fabsf(skew_error) > _skew_alarm_threshold;
+
+    // Don't learn a skew while the gantry is racked beyond the alarm threshold
+    if (!_skew_learning || _skew_alarm || _skew_learn_time <= 0.0f) {
+        return;
+    }
+
+    float speed = _motor1.speed();
+    if (fabsf(speed) > GANTRY_SKEW_LEARN_MAX_SPEED) {
+        return;
+    }
+
+    // Average the balance of this direction while the frame is still square from the homing
+    uint8_t direction = fabsf(speed) < GANTRY_SKEW_HOLD_SPEED ? 0 : (speed > 0 ? 1 : 2);
+    float effort = _motor2.duty() - _motor1.duty();
+    if (_skew_balance_ticks[direction] < GANTRY_SKEW_BALANCE_TICKS) {
+        _skew_balance_ticks[direction]++;
+        _skew_balance[direction] += (effort - _skew_balance[direction]) / _skew_balance_ticks[direction];
+        return;
+    }
+
+    float deviation = effort - _skew_balance[direction];
+    if (fabsf(deviation) < GANTRY_SKEW_EFFORT_DEADBAND) {
+        return;
+    }
+
+    // Motor 2 pushing forward means the frame holds it behind its target, so the target moves back
+    float alpha = ((float)PBIO_CONFIG_SERVO_PERIOD_MS / 1000.0f) / _skew_learn_time;
+    _skew_pos_compensation -= alpha * GANTRY_SKEW_COMPLIANCE * deviation;
+}
+
+/**
+Runs both motors toward the reference obstacle until each of them stalls on it.
+
+The motors aren't coupled, so each one stops against the obstacle wherever its side of the
+gantry reaches it. They hold the stall position afterwards.
+
+:param speed: Speed of the motors in deg/s
+*/
+pbio_error_t GantryMotor::run_until_both_stalled(float speed, CancelToken& cancel_token) {
+    PBIO_RETURN_ON_ERROR(_motor1.start_until_stalled(speed, PBIO_ACTUATION_HOLD));
+    pbio_error_t err = _motor2.start_until_stalled(speed, PBIO_ACTUATION_HOLD);
+    if (err != PBIO_SUCCESS) {
+        stop();
+        return err;
+    }
+
+    uint32_t start = millis();
+    err = _motor1.wait_for_completion(&cancel_token, GANTRY_STALL_HOMING_TIMEOUT_MS);
+    if (err == PBIO_SUCCESS) {
+        uint32_t elapsed = millis() - start;
+        uint32_t remaining = elapsed < GANTRY_STALL_HOMING_TIMEOUT_MS ? GANTRY_STALL_HOMING_TIMEOUT_MS - elapsed : 0;
+        err = _motor2.wait_for_completion(&cancel_token, remaining);
+    }
+    if (err != PBIO_SUCCESS) {
+        stop();
+    }
+    return err;
+}
+
+/**
+Moves both motors back by the same angle, each one on its own
+
+:param speed: Speed of the motors in deg/s
+:param angle: Angle by which the motors rotate in deg
+*/
+pbio_error_t GantryMotor::retract_both(float speed, float angle, CancelToken& cancel_token) {
+    PBIO_RETURN_ON_ERROR(_motor1.run_angle(speed, angle, PBIO_ACTUATION_HOLD, false));
+    pbio_error_t err = _motor2.run_angle(speed, angle, PBIO_ACTUATION_HOLD, false);
+    if (err == PBIO_SUCCESS) {
+        err = _motor1.wait_for_completion(&cancel_token);
+    }
+    if (err == PBIO_SUCCESS) {
+        err = _motor2.wait_for_completion(&cancel_token);
+    }
+    if (err != PBIO_SUCCESS) {
+        stop();
+    }
+    return err;
+}
+
+/**
+Homes the gantry without sensors, stalling both motors against the reference obstacle.
+
+Each motor runs toward the obstacle on its own with a limited duty, so each side of the gantry
+stops against it. Both sides are then at the same position, whatever the skew of the frame was:
+the angle of both motors is reset there, which squares the gantry and references the axis. The
+skew measured between the two stall positions is compared to the compensation in use, to report
+a frame that was racked at power-up. Finally the coupled axis moves to the position after home.
+
+:param config: Stall homing configuration. The direction of the speed is given by start_in_positive_direction
+:return: PBIO_ERROR_HOME_SWITCH_ERR if the obstacle is hit too early twice, PBIO_ERROR_TIMEDOUT if the motors don't stall
+*/
+pbio_error_t GantryMotor::run_stall_homing(const stall_homing_config_t& config, CancelToken& cancel_token) {
+    float speed = fabsf(config.speed);
+    float forward_speed = config.start_in_positive_direction ? speed : -speed;
+    float backward_speed = -2.0f * forward_speed;
+    uint8_t actuation1 = _motor1.get_actuation_limit();
+    uint8_t actuation2 = _motor2.get_actuation_limit();
+    bool canRetry = true;
+
+    Logger::instance().logI("Starting " + String(_name) + "-axis stall homing....");
+
+    // The reference obstacle is beyond the software limits
+    bool envelope_armed = envelopeArmed();
+    armEnvelope(false);
+    _open_loop = false;
+    _homing = true;
+    set_actuation_limit((uint8_t)config.duty_limit);
+
+    pbio_error_t err;
+    float start1 = _motor1.angle();
+    float start2 = _motor2.angle();
+    while (true) {
+        err = run_until_both_stalled(forward_speed, cancel_token);
+        if (err != PBIO_SUCCESS) {
+            break;
+        }
+
+        // Both motors must have moved, else one of them started against the obstacle
+        float travel = PIO_MIN(fabsf(_motor1.angle() - start1), fabsf(_motor2.angle() - start2));
+        if (travel >= config.minimum_travel) {
+            break;
+        }
+
+        if (!canRetry) {
+            Logger::instance().logE(String(_name) + "-axis hit the reference obstacle too early after retrying. Aborting homing");
+            err = PBIO_ERROR_HOME_SWITCH_ERR;
+            break;
+        }
+
+        // Retract and try again
+        canRetry = false;
+        Logger::instance().logI(String(_name) + "-axis hit the reference obstacle too early. Retract and try again");
+        err = retract_both(backward_speed, config.minimum_travel * 1.2f, cancel_token);
+        if (err != PBIO_SUCCESS) {
+            break;
+        }
+        start1 = _motor1.angle();
+        start2 = _motor2.angle();
+    }
+
+    _motor1.set_actuation_limit(actuation1);
+    _motor2.set_actuation_limit(actuation2);
+    if (err != PBIO_SUCCESS) {
+        stop();
+        _homing = false;
+
+        // The angle wasn't reset, so the previous reference and its limits still hold
+        armEnvelope(envelope_armed);
+        if (err == PBIO_ERROR_CANCELED) {
+            Logger::instance().logI("Homing canceled by the user");
+        } else if (err == PBIO_ERROR_TIMEDOUT) {
+            Logger::instance().logE(String(_name) + "-axis didn't reach the reference obstacle. Aborting homing");
+        }
+        return err;
+    }
+
+    // Both sides of the gantry are against the obstacle: the measured skew is the frame skew
+    float measured_skew = getMeasuredSkew();
+    float skew_error = measured_skew - _skew_pos_compensation;
+    Logger::instance().logI(String(_name) + "-axis hit the reference obstacle, skew " + String(measured_skew, 2) + 
+        " deg, compensation " + String(_skew_pos_compensation, 2) + " deg");
+    if (fabsf(skew_error) > _skew_alarm_threshold) {
+        Logger::instance().logW(String(_name) + "-axis was racked by " + String(skew_error, 1) + " deg before homing");
+    }
+
+    // Square the gantry on the obstacle and couple the motors again. The axis is referenced from
+    // now on, so the limits are armed even if the final move fails. A move toward a target within
+    // the limits isn't braked, even when it starts beyond them
+    reset_angle(config.axis_position_at_home_marker);
+    armEnvelope(true);
+    _homing = false;
+    hold();
+
+    // Move away from the obstacle to the final position
+    float backward_final_speed = get_speed_limit() * (forward_speed > 0 ? -1 : 1);
+    return run_target(backward_final_speed, config.axis_position_after_home, PBIO_ACTUATION_HOLD, true, &cancel_token);
+}
@@ -0,0 +1,129 @@
+#include "motor_control/identification.hpp"
+#include "motor_control/const.h"
+
+/**
+Clear all the accumulated samples
+
+:param id: Identification accumulator
+ */
+void pbio_identification_reset(pbio_identification_t *id) {
+    memset(id, 0, sizeof(pbio_identification_t));
+}
+
+/**
+Accumulate a sample of the speed response
+
+:param rate_now: Speed at the sample time (count/s)
+:param duty_now: Duty applied at the sample time (duty steps)
+:param rate_next: Speed one sample period later (count/s)
+ */
+void pbio_identification_add_sample(pbio_identification_t *id, int32_t rate_now, int32_t duty_now, int32_t rate_next) {
+    double x[3] = { (double)rate_now, (double)duty_now, 1.0 };
+
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            id->xx[i][j] += x[i] * x[j];
+        }
+        id->xy[i] += x[i] * rate_next;
+    }
+    id->samples++;
+}
+
+/**
+Fit the first order speed model of the accumulated samples
+
+:param period_us: Time between two samples (us)
+:param gain: Return steady state speed per duty step above the offset (counts/s per duty step)
+:param time_constant: Return speed time constant (s)
+:param offset: Return duty at which the speed settles at zero (duty steps)
+ */
+pbio_error_t pbio_identification_solve(const pbio_identification_t *id, int32_t period_us, float *gain, float *time_constant, float *offset) {
+    if (id->samples < PBIO_IDENTIFICATION_MIN_SAMPLES) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    // Solve the normal equations with Gaussian elimination and partial pivoting
+    double m[3][4];
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            m[i][j] = id->xx[i][j];
+        }
+        m[i][3] = id->xy[i];
+    }
+
+    for (uint8_t col = 0; col < 3; col++) {
+        uint8_t pivot = col;
+        for (uint8_t row = col + 1; row < 3; row++) {
+            if (fabs(m[row][col]) > fabs(m[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (fabs(m[pivot][col]) < 1e-9) {
+            // Not enough excitation to separate the parameters
+            return PBIO_ERROR_FAILED;
+        }
+        if (pivot != col) {
+            for (uint8_t j = 0; j < 4; j++) {
+                double tmp = m[col][j];
+                m[col][j] = m[pivot][j];
+                m[pivot][j] = tmp;
+            }
+        }
+        for (uint8_t row = 0; row < 3; row++) {
+            if (row == col) {
+                continue;
+            }
+            double factor = m[row][col] / m[col][col];
+            for (uint8_t j = col; j < 4; j++) {
+                m[row][j] -= factor * m[col][j];
+            }
+        }
+    }
+
+    double a = m[0][3] / m[0][0];
+    double b = m[1][3] / m[1][1];
+    double c = m[2][3] / m[2][2];
+
+    // The speed response must be stable and increase with the duty
+    if (a <= 0.0 || a >= 1.0 || b <= 0.0) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    *gain = (float)(b / (1.0 - a));
+    *time_constant = (float)(-((double)period_us / US_PER_SECOND) / log(a));
+    *offset = (float)(-c / b);
+    return PBIO_SUCCESS;
+}
+
+/**
+Fit the plant model from the samples of both directions of motion
+
+The duty offsets of the two directions give the friction, that opposes the motion, 
+and the gravity, that always pushes in the same direction.
+
+:param id_pos: Samples moving in positive direction
+:param id_neg: Samples moving in negative direction
+:param period_us: Time between two samples (us)
+:param model: Return the fitted model
+ */
+pbio_error_t pbio_identification_make_model(const pbio_identification_t *id_pos, const pbio_identification_t *id_neg, int32_t period_us, pbio_control_model_t *model) {
+    float gain[2], time_constant[2], offset[2];
+
+    pbio_error_t err = pbio_identification_solve(id_pos, period_us, &gain[0], &time_constant[0], &offset[0]);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+    err = pbio_identification_solve(id_neg, period_us, &gain[1], &time_constant[1], &offset[1]);
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    for (uint8_t i = 0; i < 2; i++) {
+        model->gain[i] = gain[i];
+        model->time_constant[i] = time_constant[i];
+    }
+    model->coulomb = max((offset[0] - offset[1]) / 2.0f, 0.0f);
+    model->gravity = (offset[0] + offset[1]) / 2.0f;
+    model->viscous = (1.0f / gain[0] + 1.0f / gain[1]) / 2.0f;
+    return PBIO_SUCCESS;
+}
\ No newline at end of file
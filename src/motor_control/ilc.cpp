@@ -0,0 +1,378 @@
+#include "motor_control/ilc.hpp"
+#include "motor_control/const.h"
+#include "motor_control/macros.h"
+#include "config.h"
+#include "esp_heap_caps.h"
+
+#define ILC_TICK_US (PBIO_CONFIG_SERVO_PERIOD_MS * US_PER_MS)
+
+// Marks the ticks not reached by the control loop during an iteration
+#define ILC_NO_SAMPLE INT32_MIN
+
+/**
+Allocate the table and the error buffers in PSRAM, with their work copies, once
+ */
+static bool ilc_alloc(pbio_ilc_t *ilc) {
+    if (ilc->correction) {
+        return true;
+    }
+
+    int16_t *correction = (int16_t *)heap_caps_calloc(PBIO_ILC_MAX_TICKS, sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    int32_t *count_err = (int32_t *)heap_caps_malloc(PBIO_ILC_MAX_TICKS * sizeof(int32_t), MALLOC_CAP_SPIRAM);
+    int32_t *rate_err = (int32_t *)heap_caps_malloc(PBIO_ILC_MAX_TICKS * sizeof(int32_t), MALLOC_CAP_SPIRAM);
+    int16_t *work_correction = (int16_t *)heap_caps_calloc(PBIO_ILC_MAX_TICKS, sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    int32_t *work_count_err = (int32_t *)heap_caps_malloc(PBIO_ILC_MAX_TICKS * sizeof(int32_t), MALLOC_CAP_SPIRAM);
+    int32_t *work_rate_err = (int32_t *)heap_caps_malloc(PBIO_ILC_MAX_TICKS * sizeof(int32_t), MALLOC_CAP_SPIRAM);
+    if (!correction || !count_err || !rate_err || !work_correction || !work_count_err || !work_rate_err) {
+        heap_caps_free(correction);
+        heap_caps_free(count_err);
+        heap_caps_free(rate_err);
+        heap_caps_free(work_correction);
+        heap_caps_free(work_count_err);
+        heap_caps_free(work_rate_err);
+        return false;
+    }
+
+    ilc->correction = correction;
+    ilc->count_err = count_err;
+    ilc->rate_err = rate_err;
+    ilc->work.correction = work_correction;
+    ilc->work.count_err = work_count_err;
+    ilc->work.rate_err = work_rate_err;
+    return true;
+}
+
+/**
+Return true if two maneuvers share the table. The start position changes a little from race
+to race, within the position tolerance
+
+:param s: Control settings, for the position tolerance
+ */
+static bool ilc_same_maneuver(const pbio_ilc_key_t *a, const pbio_ilc_key_t *b, const pbio_control_settings_t *s) {
+    return abs(a->count_start - b->count_start) <= 2 * s->count_tolerance &&
+           a->count_target == b->count_target &&
+           a->rate == b->rate &&
+           a->acceleration == b->acceleration &&
+           a->shaper.type == b->shaper.type &&
+           a->shaper.frequency == b->shaper.frequency &&
+           a->shaper.damping == b->shaper.damping &&
+           a->gain_scheduling == b->gain_scheduling;
+}
+
+/**
+Discard the table and start learning a new maneuver
+
+:param key: Maneuver to learn
+:param length: Ticks of the new table
+ */
+static void ilc_reset_table(pbio_ilc_t *ilc, const pbio_ilc_key_t *key, uint16_t length) {
+    memset(ilc->correction, 0, PBIO_ILC_MAX_TICKS * sizeof(int16_t));
+    ilc->key = *key;
+    ilc->length = length;
+    ilc->iterations = 0;
+    ilc->rms = 0.0f;
+    ilc->rms_best = INFINITY;
+    ilc->rms_stored = INFINITY;
+    ilc->converged = false;
+    ilc->needs_store = false;
+    ilc->generation++;
+}
+
+/**
+Initialize the learning, disabled and without a table
+ */
+void pbio_ilc_setup(pbio_ilc_t *ilc) {
+    memset(ilc, 0, sizeof(pbio_ilc_t));
+    ilc->settings.enabled = false;
+    ilc->settings.gain = PBIO_ILC_DEFAULT_GAIN;
+    ilc->settings.lead = PBIO_ILC_DEFAULT_LEAD_MS / PBIO_CONFIG_SERVO_PERIOD_MS;
+    ilc->rms_best = INFINITY;
+    ilc->rms_stored = INFINITY;
+}
+
+/**
+Make the next run_target an iteration of the learning
+ */
+void pbio_ilc_arm(pbio_ilc_t *ilc) {
+    ilc->armed = true;
+}
+
+/**
+Start an iteration on a new run_target maneuver, if armed
+
+:param s: Control settings, for the position tolerance
+:param t0: Start time of the trajectory (us)
+:param duration: Duration of the trajectory (us)
+:param key: Maneuver parameters. When they differ from the ones of the table, the table is discarded
+ */
+void pbio_ilc_start(pbio_ilc_t *ilc, const pbio_control_settings_t *s, int32_t t0, int32_t duration, const pbio_ilc_key_t *key) {
+    ilc->armed = false;
+    ilc->recording = false;
+    ilc->ready = false;
+    if (!ilc->settings.enabled || !ilc->correction) {
+        return;
+    }
+
+    // Too long to learn
+    int32_t length = (duration + PBIO_ILC_TAIL_MS * US_PER_MS) / ILC_TICK_US + 1;
+    if (length > PBIO_ILC_MAX_TICKS) {
+        return;
+    }
+
+    if (ilc->length == 0 || !ilc_same_maneuver(key, &ilc->key, s)) {
+        ilc_reset_table(ilc, key, length);
+    }
+
+    for (uint16_t t = 0; t < ilc->length; t++) {
+        ilc->count_err[t] = ILC_NO_SAMPLE;
+    }
+    ilc->t0 = t0;
+    ilc->recording = true;
+    ilc->generation++;
+}
+
+/**
+Record the tracking error of this tick and return its correction. Runs in the control loop
+
+:param active: True while the maneuver is under angle control
+:param t0: Start time of the trajectory under control (us)
+:param time_ref: Time of reference evaluation (us)
+:param count_err: Position error (count)
+:param rate_err: Speed error (count/s)
+:return: Duty to add to the control (duty steps)
+ */
+int32_t PBIO_IRAM pbio_ilc_update(pbio_ilc_t *ilc, bool active, int32_t t0, int32_t time_ref, int32_t count_err, int32_t rate_err) {
+    if (!ilc->recording) {
+        return 0;
+    }
+
+    // Interrupted by another command, a stop or an obstruction: the iteration is discarded
+    if (!active || t0 != ilc->t0) {
+        ilc->recording = false;
+        return 0;
+    }
+
+    int32_t tick = (time_ref - t0) / ILC_TICK_US;
+    if (tick < 0) {
+        return 0;
+    }
+    if (tick >= ilc->length) {
+        ilc->recording = false;
+        ilc->ready = true;
+        return 0;
+    }
+
+    ilc->count_err[tick] = count_err;
+    ilc->rate_err[tick] = rate_err;
+    return ilc->correction[tick];
+}
+
+/**
+Take the errors of the last iteration and a copy of the table to learn them off the control
+loop. Runs under the motor lock. The error buffers are swapped, the control loop doesn't write
+them until the next iteration starts
+
+:param s: Control settings, for the PD gains that weight the errors
+:return: PBIO_ERROR_AGAIN if no iteration is waiting to be learned
+ */
+pbio_error_t pbio_ilc_learn_begin(pbio_ilc_t *ilc, const pbio_control_settings_t *s) {
+    if (!ilc->ready || ilc->learning) {
+        return PBIO_ERROR_AGAIN;
+    }
+    ilc->ready = false;
+    ilc->learning = true;
+
+    pbio_ilc_work_t *work = &ilc->work;
+    int32_t *count_err = ilc->count_err;
+    int32_t *rate_err = ilc->rate_err;
+    ilc->count_err = work->count_err;
+    ilc->rate_err = work->rate_err;
+    work->count_err = count_err;
+    work->rate_err = rate_err;
+    memcpy(work->correction, ilc->correction, ilc->length * sizeof(int16_t));
+
+    // Gains of the direction of the maneuver
+    const bool negative = s->gain_scheduling && ilc->key.count_target < ilc->key.count_start;
+    work->kp = negative ? s->gains_neg.pid_kp : s->pid_kp;
+    work->kd = negative ? s->gains_neg.pid_kd : s->pid_kd;
+    work->max_control = s->max_control;
+    work->gain = ilc->settings.gain;
+    work->lead = ilc->settings.lead;
+    work->generation = ilc->generation;
+    work->length = ilc->length;
+    work->iterations = ilc->iterations;
+    work->rms_best = ilc->rms_best;
+    return PBIO_SUCCESS;
+}
+
+/**
+Update the table copy from the errors of the last iteration. Runs outside of the control loop
+and of the motor lock
+
+:return: PBIO_ERROR_FAILED if the learning diverged, the table must be reset
+ */
+pbio_error_t pbio_ilc_learn(pbio_ilc_work_t *work) {
+    // Ticks skipped by the loop jitter take the error of the previous tick
+    int32_t count_prev = 0;
+    int32_t rate_prev = 0;
+    float sum = 0.0f;
+    for (uint16_t t = 0; t < work->length; t++) {
+        if (work->count_err[t] == ILC_NO_SAMPLE) {
+            work->count_err[t] = count_prev;
+            work->rate_err[t] = rate_prev;
+        }
+        count_prev = work->count_err[t];
+        rate_prev = work->rate_err[t];
+        sum += (float)count_prev * count_prev;
+    }
+    work->rms_iteration = sqrtf(sum / work->length);
+
+    // Learning is making it worse, start over
+    if (work->iterations > 0 && work->rms_iteration > PBIO_ILC_DIVERGENCE_FACTOR * work->rms_best) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    // Learning step with phase lead. The step of a tick is written over its error, which
+    // is not read again because the lead only looks ahead
+    int32_t last = work->length - 1;
+    for (int32_t t = 0; t <= last; t++) {
+        int32_t i = PIO_MIN(t + work->lead, last);
+        float step = work->gain * (work->kp * work->count_err[i] + work->kd * work->rate_err[i]);
+        work->count_err[t] = work->correction[t] + (int32_t)step;
+    }
+
+    // Zero phase low pass filter, [1 2 1] / 4
+    for (int32_t t = 0; t <= last; t++) {
+        int32_t prev = work->count_err[PIO_MAX(t - 1, 0)];
+        int32_t next = work->count_err[PIO_MIN(t + 1, last)];
+        int32_t value = (prev + 2 * work->count_err[t] + next) / 4;
+        work->correction[t] = (int16_t)PIO_MAX(-work->max_control, PIO_MIN(value, work->max_control));
+    }
+    return PBIO_SUCCESS;
+}
+
+/**
+Swap the learned table in. Runs under the motor lock. The result is dropped if the table was
+reset or loaded, or an iteration started with the old table, while it was learned
+
+:param err: Result of pbio_ilc_learn
+:return: PBIO_ERROR_AGAIN if the result was dropped, PBIO_ERROR_FAILED if the learning diverged and the table was reset
+ */
+pbio_error_t pbio_ilc_learn_end(pbio_ilc_t *ilc, pbio_error_t err) {
+    pbio_ilc_work_t *work = &ilc->work;
+    ilc->learning = false;
+    if (work->generation != ilc->generation) {
+        return PBIO_ERROR_AGAIN;
+    }
+
+    float rms = work->rms_iteration;
+    if (err != PBIO_SUCCESS) {
+        pbio_ilc_key_t key = ilc->key;
+        ilc_reset_table(ilc, &key, ilc->length);
+        ilc->rms = rms;
+        return err;
+    }
+
+    int16_t *correction = ilc->correction;
+    ilc->correction = work->correction;
+    work->correction = correction;
+
+    ilc->converged = ilc->iterations >= PBIO_ILC_MIN_ITERATIONS && rms > ilc->rms * (1.0f - PBIO_ILC_CONVERGED_IMPROVEMENT);
+    ilc->needs_store = ilc->converged && rms < ilc->rms_stored * (1.0f - PBIO_ILC_STORE_IMPROVEMENT);
+    ilc->rms = rms;
+    ilc->rms_best = fminf(ilc->rms_best, rms);
+    ilc->iterations++;
+    return PBIO_SUCCESS;
+}
+
+/**
+Return the learning settings
+
+:param enabled: Return true if the learning is enabled
+:param gain: Return the learning gain
+:param lead_ms: Return the phase lead (ms)
+ */
+void pbio_ilc_get_settings(const pbio_ilc_t *ilc, bool *enabled, float *gain, uint16_t *lead_ms) {
+    *enabled = ilc->settings.enabled;
+    *gain = ilc->settings.gain;
+    *lead_ms = ilc->settings.lead * PBIO_CONFIG_SERVO_PERIOD_MS;
+}
+
+/**
+Set the learning settings
+
+:param enabled: Apply and learn the correction
+:param gain: Fraction of the PD control action on the error learned at each iteration (0 to 1)
+:param lead_ms: Time advance of the error used to learn a tick (ms)
+ */
+pbio_error_t pbio_ilc_set_settings(pbio_ilc_t *ilc, bool enabled, float gain, uint16_t lead_ms) {
+    if (gain <= 0.0f || gain > 1.0f || lead_ms > PBIO_ILC_MAX_LEAD_MS) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    if (enabled && !ilc_alloc(ilc)) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    ilc->settings.enabled = enabled;
+    ilc->settings.gain = gain;
+    ilc->settings.lead = (lead_ms + PBIO_CONFIG_SERVO_PERIOD_MS / 2) / PBIO_CONFIG_SERVO_PERIOD_MS;
+    if (!enabled) {
+        ilc->armed = false;
+        ilc->recording = false;
+        ilc->ready = false;
+    }
+    return PBIO_SUCCESS;
+}
+
+/**
+Return a copy of the correction table
+
+:param table: Return the table, with a zero length if there is none
+ */
+void pbio_ilc_get_table(const pbio_ilc_t *ilc, pbio_ilc_table_t *table) {
+    memset(table, 0, sizeof(pbio_ilc_table_t));
+    if (!ilc->correction) {
+        return;
+    }
+
+    table->key = ilc->key;
+    table->length = ilc->length;
+    table->iterations = ilc->iterations;
+    table->rms = ilc->rms;
+    memcpy(table->correction, ilc->correction, ilc->length * sizeof(int16_t));
+}
+
+/**
+Load a correction table, e.g. the one stored at the previous power-up
+
+:param table: Table to load. A zero length discards the current table
+ */
+pbio_error_t pbio_ilc_set_table(pbio_ilc_t *ilc, const pbio_ilc_table_t *table) {
+    if (table->length > PBIO_ILC_MAX_TICKS) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+    if (!ilc_alloc(ilc)) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    ilc->recording = false;
+    ilc->ready = false;
+    ilc_reset_table(ilc, &table->key, table->length);
+    memcpy(ilc->correction, table->correction, table->length * sizeof(int16_t));
+    if (table->length > 0) {
+        ilc->iterations = table->iterations;
+        ilc->rms = table->rms;
+        ilc->rms_best = table->rms;
+        ilc->rms_stored = table->rms;
+        ilc->converged = true;
+    }
+    return PBIO_SUCCESS;
+}
+
+/**
+Mark the table as stored, so it's stored again only after a further improvement
+ */
+void pbio_ilc_mark_stored(pbio_ilc_t *ilc) {
+    ilc->rms_stored = ilc->rms;
+    ilc->needs_store = false;
+}
@@ -2,6 +2,7 @@
 // Copyright (c) 2018-2020 The Pybricks Authors
 
 #include "motor_control/integrator.hpp"
+#include "motor_control/macros.h"
 
 /* Rate integrator used for speed-based control */
 /**
@@ -11,7 +12,7 @@ Pause the rate integrator error accumulation and store current accumulated error
 :param count: Encoder count actual value (count)
 :param count_ref: Encoder expected count (count)
 */
-void pbio_rate_integrator_pause(pbio_rate_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref) {
+void PBIO_IRAM pbio_rate_integrator_pause(pbio_rate_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref) {
 
     // Pause only if running
     if (!itg->running) {
@@ -35,7 +36,7 @@ void pbio_rate_integrator_pause(pbio_rate_integrator_t *itg, int32_t time_now, i
 :param count: Encoder count actual value (count)
 :param count_ref: Encoder expected count (count)
  */
-void pbio_rate_integrator_resume(pbio_rate_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref) {
+void PBIO_IRAM pbio_rate_integrator_resume(pbio_rate_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref) {
 
     // Resume only if paused
     if (itg->running) {
@@ -80,7 +81,7 @@ Compute the speed instantaneus and integral error
 :param rate_err: Return istantaneus speed error (count/s)
 :param rate_err_integral: Return accumulated speed error (count)
  */
-void pbio_rate_integrator_get_errors(pbio_rate_integrator_t *itg,
+void PBIO_IRAM pbio_rate_integrator_get_errors(pbio_rate_integrator_t *itg,
                                 int32_t rate,
                                 int32_t rate_ref,
                                 int32_t count,
@@ -109,7 +110,7 @@ Return true when the motor is in stall (rate integrator)
 :param rate_stall: Stall speed threshold (count/s)
 :return: Return true when the motor is in stall
  */
-bool pbio_rate_integrator_stalled(const pbio_rate_integrator_t *itg, int32_t time_now, int32_t rate, int32_t time_stall, int32_t rate_stall) {
+bool PBIO_IRAM pbio_rate_integrator_stalled(const pbio_rate_integrator_t *itg, int32_t time_now, int32_t rate, int32_t time_stall, int32_t rate_stall) {
     // If were running, we're not stalled
     if (itg->running) {
         return false;
@@ -137,7 +138,7 @@ Return current time when is running or the pause time when is not running
 :param time_now: Current time (us)
 :return: Integrator reference time (us)
  */
-int32_t pbio_count_integrator_get_ref_time(const pbio_count_integrator_t *itg, int32_t time_now) {
+int32_t PBIO_IRAM pbio_count_integrator_get_ref_time(const pbio_count_integrator_t *itg, int32_t time_now) {
     // The wall time at which we are is either the current time, or whenever we stopped last
     int32_t real_time = itg->trajectory_running ? time_now : itg->time_pause_begin;
 
@@ -152,7 +153,7 @@ Pause the count integrator
 :param count: Encoder count actual value (count)
 :param count_ref: Encoder expected count (count)
  */
-void pbio_count_integrator_pause(pbio_count_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref) {
+void PBIO_IRAM pbio_count_integrator_pause(pbio_count_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref) {
 
     // Return if already paused
     if (!itg->trajectory_running) {
@@ -171,7 +172,7 @@ Resume the count integrator
 :param count: Encoder count actual value (count)
 :param count_ref: Encoder expected count (count)
  */
-void pbio_count_integrator_resume(pbio_count_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref) {
+void PBIO_IRAM pbio_count_integrator_resume(pbio_count_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref) {
 
     // Return if already trajectory_running
     if (itg->trajectory_running) {
@@ -220,7 +221,7 @@ Update the integrator error if running
 :param integral_range: Distance from target when the integrator can accumulate error (count)
 :param integral_rate: Maximum integral change per update (count)
  */
-void pbio_count_integrator_update(pbio_count_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref, int32_t count_target, int32_t integral_range, int32_t integral_rate) {
+void PBIO_IRAM pbio_count_integrator_update(pbio_count_integrator_t *itg, int32_t time_now, int32_t count, int32_t count_ref, int32_t count_target, int32_t integral_range, int32_t integral_rate) {
     // Integrate and update position error
     if (itg->trajectory_running) {
 
@@ -266,7 +267,7 @@ Calculate istantaneus and integral count error
 :param count_err: Return istantaneus poistion error (count)
 :param count_err_integral: Return accumulated position error (count)
  */
-void pbio_count_integrator_get_errors(pbio_count_integrator_t *itg, int32_t count, int32_t count_ref, int32_t *count_err, int32_t *count_err_integral) {
+void PBIO_IRAM pbio_count_integrator_get_errors(pbio_count_integrator_t *itg, int32_t count, int32_t count_ref, int32_t *count_err, int32_t *count_err_integral) {
     // Calculate current error state
     *count_err = count_ref - count;
     *count_err_integral = itg->count_err_integral;
@@ -281,7 +282,7 @@ Return true when the motor is in stall (count integrator)
 :param rate_stall: Stall speed threshold (count/s)
 :return: True when the motor is in stall (count integrator)
  */
-bool pbio_count_integrator_stalled(const pbio_count_integrator_t *itg, int32_t time_now, int32_t rate, int32_t time_stall, int32_t rate_stall) {
+bool PBIO_IRAM pbio_count_integrator_stalled(const pbio_count_integrator_t *itg, int32_t time_now, int32_t rate, int32_t time_stall, int32_t rate_stall) {
     // If we're running and the integrator is not saturated, we're not stalled
     if (itg->trajectory_running && abs(itg->count_err_integral) < itg->count_err_integral_max) {
         return false;
@@ -2,6 +2,7 @@
 // Copyright (c) 2018-2020 The Pybricks Authors
 
 #include "motor_control/logger.hpp"
+#include "motor_control/macros.h"
 #include "config.h"
 #include "motor_control/const.h"
 #include "monotonic.h"
@@ -20,7 +21,9 @@ PBIOLogger::PBIOLogger() {
         (char *)"Error: position for angle maneuver or else speed",
         (char *)"Accumulated position error",
         (char *)"Current position motor 2",
-        (char *)"Current speed motor 2"
+        (char *)"Current speed motor 2",
+        (char *)"Supply voltage",
+        (char *)"Estimated disturbance"
     };
     _col_names = servo_col_names;
     static char *servo_col_units[] {
@@ -34,7 +37,9 @@ PBIOLogger::PBIOLogger() {
         (char *)"count or count/s",
         (char *)"count",
         (char *)"count",
-        (char *)"count/s"
+        (char *)"count/s",
+        (char *)"mV",
+        (char *)"duty steps"
     };
     _col_units = servo_col_units;
 }
@@ -122,7 +127,7 @@ void PBIOLogger::stop() {
     }
 }
 
-pbio_error_t PBIOLogger::update(int32_t *buf) {
+pbio_error_t PBIO_IRAM PBIOLogger::update(int32_t *buf) {
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
         // Log nothing if logger is inactive
         if (!_active) {
@@ -0,0 +1,251 @@
+#include "motor_control/lqr.hpp"
+#include "motor_control/control.hpp"
+#include "motor_control/const.h"
+#include "motor_control/macros.h"
+#include "config.h"
+
+#define LQR_PERIOD_S (PBIO_CONFIG_SERVO_PERIOD_MS / (double)MS_PER_SECOND)
+
+/**
+Solve the discrete Riccati equation of one direction of motion by iteration
+
+The plant is the first order speed model with the position and its integral appended, discretized
+exactly for the position and speed, and with the rectangle rule for the integral.
+
+:param gain: Steady state speed per duty step (counts/s per duty step)
+:param time_constant: Time constant of the speed response (s)
+:param q: State weights, integral, position and speed
+:param r: Duty weight
+:param k: Return the gains, integral (per count*s), position (per count) and speed (per count/s)
+:return: PBIO_ERROR_FAILED if the iterations don't converge
+ */
+static pbio_error_t lqr_solve(double gain, double time_constant, const double q[3], double r, double k[3]) {
+    const double T = LQR_PERIOD_S;
+    const double a = exp(-T / time_constant);
+    const double A[3][3] = {
+        { 1.0, T, 0.0 },
+        { 0.0, 1.0, time_constant * (1.0 - a) },
+        { 0.0, 0.0, a },
+    };
+    const double B[3] = { 0.0, gain * (T - time_constant * (1.0 - a)), gain * (1.0 - a) };
+
+    double P[3][3] = {};
+    for (uint8_t i = 0; i < 3; i++) {
+        P[i][i] = q[i];
+    }
+
+    for (uint16_t n = 0; n < PBIO_LQR_MAX_ITERATIONS; n++) {
+        // PB = P * B, PA = P * A
+        double PB[3];
+        double PA[3][3];
+        for (uint8_t i = 0; i < 3; i++) {
+            PB[i] = P[i][0] * B[0] + P[i][1] * B[1] + P[i][2] * B[2];
+            for (uint8_t j = 0; j < 3; j++) {
+                PA[i][j] = P[i][0] * A[0][j] + P[i][1] * A[1][j] + P[i][2] * A[2][j];
+            }
+        }
+
+        // K = (R + B' P B)^-1 B' P A, with B' P A = (P B)' A as P is symmetric
+        double s = r + B[0] * PB[0] + B[1] * PB[1] + B[2] * PB[2];
+        double BPA[3];
+        double k_new[3];
+        double change = 0.0;
+        double norm = 0.0;
+        for (uint8_t j = 0; j < 3; j++) {
+            BPA[j] = PB[0] * A[0][j] + PB[1] * A[1][j] + PB[2] * A[2][j];
+            k_new[j] = BPA[j] / s;
+            change = fmax(change, fabs(k_new[j] - k[j]));
+            norm = fmax(norm, fabs(k_new[j]));
+            k[j] = k_new[j];
+        }
+        if (!isfinite(norm)) {
+            return PBIO_ERROR_FAILED;
+        }
+
+        // P = Q + A' P A - (B' P A)' (B' P A) / s
+        for (uint8_t i = 0; i < 3; i++) {
+            for (uint8_t j = 0; j < 3; j++) {
+                double APA = A[0][i] * PA[0][j] + A[1][i] * PA[1][j] + A[2][i] * PA[2][j];
+                P[i][j] = (i == j ? q[i] : 0.0) + APA - BPA[i] * BPA[j] / s;
+            }
+        }
+
+        if (n > 0 && change <= PBIO_LQR_CONVERGENCE * norm) {
+            return PBIO_SUCCESS;
+        }
+    }
+    return PBIO_ERROR_FAILED;
+}
+
+/**
+Convert a gain to 16.16 fixed point
+
+:return: False if it doesn't fit
+ */
+static bool lqr_to_fixed(double value, int32_t *fixed) {
+    double scaled = round(value * (1 << PBIO_LQR_GAIN_SHIFT));
+    if (!isfinite(scaled) || scaled > INT32_MAX || scaled < INT32_MIN) {
+        return false;
+    }
+    *fixed = (int32_t)scaled;
+    return true;
+}
+
+/**
+Initialize the state feedback, disabled, with the default weights
+ */
+void pbio_lqr_setup(pbio_lqr_t *lqr) {
+    memset(lqr, 0, sizeof(pbio_lqr_t));
+    lqr->settings.enabled = false;
+    lqr->settings.position_error = PBIO_LQR_DEFAULT_POSITION_ERROR;
+    lqr->settings.speed_error = PBIO_LQR_DEFAULT_SPEED_ERROR;
+    lqr->settings.integral_error = PBIO_LQR_DEFAULT_INTEGRAL_ERROR;
+}
+
+/**
+Compute the gains of both directions from the identified model. Runs outside of the control loop,
+whenever the model or the weights change
+
+:param s: Control settings, for the model and the unit conversion
+:return: PBIO_ERROR_INVALID_OP if the model is not identified, PBIO_ERROR_FAILED if there is no solution
+ */
+pbio_error_t pbio_lqr_update_gains(pbio_lqr_t *lqr, const pbio_control_settings_t *s) {
+    lqr->valid = false;
+    if (!pbio_control_settings_has_model(s)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    double position_error = lqr->settings.position_error * s->counts_per_unit;
+    double speed_error = lqr->settings.speed_error * s->counts_per_unit;
+    double integral_error = lqr->settings.integral_error * s->counts_per_unit;
+    const double q[3] = {
+        1.0 / (integral_error * integral_error),
+        1.0 / (position_error * position_error),
+        1.0 / (speed_error * speed_error),
+    };
+    const double r = 1.0 / ((double)MOTOR_MAX_CONTROL * MOTOR_MAX_CONTROL);
+
+    int32_t k_count[2], k_rate[2], k_integral[2];
+    for (uint8_t d = 0; d < 2; d++) {
+        double k[3] = {};
+        pbio_error_t err = lqr_solve(s->model.gain[d], s->model.time_constant[d], q, r, k);
+        if (err != PBIO_SUCCESS) {
+            return err;
+        }
+
+        // The integrator runs in count*us, evaluated in count*ms
+        if (!lqr_to_fixed(k[0] / MS_PER_SECOND, &k_integral[d]) ||
+            !lqr_to_fixed(k[1], &k_count[d]) ||
+            !lqr_to_fixed(k[2], &k_rate[d])) {
+            return PBIO_ERROR_FAILED;
+        }
+    }
+
+    memcpy(lqr->k_count, k_count, sizeof(k_count));
+    memcpy(lqr->k_rate, k_rate, sizeof(k_rate));
+    memcpy(lqr->k_integral, k_integral, sizeof(k_integral));
+    lqr->valid = true;
+    return PBIO_SUCCESS;
+}
+
+/**
+Evaluate the state feedback. Runs in the control loop
+
+:param direction: Direction of the gains in use, 1 or -1
+:param count_err: Position error (count)
+:param rate_err: Speed error (count/s)
+:param count_err_integral: Integral of the position error (count*us)
+:param duty_count: Return the duty due to the position error (duty steps)
+:param duty_rate: Return the duty due to the speed error (duty steps)
+:param duty_integral: Return the duty due to the integral error (duty steps)
+ */
+void PBIO_IRAM pbio_lqr_get_feedback(const pbio_lqr_t *lqr, int8_t direction, int32_t count_err, int32_t rate_err, int32_t count_err_integral,
+                           int32_t *duty_count, int32_t *duty_rate, int32_t *duty_integral) {
+    uint8_t d = direction < 0 ? 1 : 0;
+    *duty_count = (int32_t)(((int64_t)lqr->k_count[d] * count_err) >> PBIO_LQR_GAIN_SHIFT);
+    *duty_rate = (int32_t)(((int64_t)lqr->k_rate[d] * rate_err) >> PBIO_LQR_GAIN_SHIFT);
+    *duty_integral = (int32_t)(((int64_t)lqr->k_integral[d] * (count_err_integral / US_PER_MS)) >> PBIO_LQR_GAIN_SHIFT);
+}
+
+/**
+Return the integrator limit for which the integral duty does not exceed max_control
+
+:param s: Control settings, for the actuation limit
+:param direction: Direction of the gains in use, 1 or -1
+:return: Integrator max value (count*us)
+ */
+int32_t pbio_lqr_get_max_integrator(const pbio_lqr_t *lqr, const pbio_control_settings_t *s, int8_t direction) {
+    int32_t k_integral = lqr->k_integral[direction < 0 ? 1 : 0];
+    int64_t integrator_max = k_integral > 0 ? ((((int64_t)s->max_control) << PBIO_LQR_GAIN_SHIFT) / k_integral) * US_PER_MS : INT64_MAX;
+    return (int32_t)PIO_MIN(integrator_max, (int64_t)1000000000);
+}
+
+/**
+Return the duty of the position feedback on the distance travelled at some speed
+
+:param direction: Direction of the gains in use, 1 or -1
+:param rate: Speed (count/s)
+:param time: Travel time (ms)
+:return: Position feedback duty (duty steps)
+ */
+int32_t PBIO_IRAM pbio_lqr_get_travel_duty(const pbio_lqr_t *lqr, int8_t direction, int32_t rate, int32_t time) {
+    int64_t k_count = lqr->k_count[direction < 0 ? 1 : 0];
+    return (int32_t)(((k_count * rate * time) / MS_PER_SECOND) >> PBIO_LQR_GAIN_SHIFT);
+}
+
+/**
+Return the state feedback settings
+
+:param enabled: Return true if the state feedback is enabled
+:param position_error: Return the acceptable position error (user units)
+:param speed_error: Return the acceptable speed error (user units/s)
+:param integral_error: Return the acceptable integral of the position error (user units*s)
+ */
+void pbio_lqr_get_settings(const pbio_lqr_t *lqr, bool *enabled, float *position_error, float *speed_error, float *integral_error) {
+    *enabled = lqr->settings.enabled;
+    *position_error = lqr->settings.position_error;
+    *speed_error = lqr->settings.speed_error;
+    *integral_error = lqr->settings.integral_error;
+}
+
+/**
+Set the state feedback settings and compute the gains
+
+Without an identified model the settings are kept and the PID stays in use until the model is set.
+
+:param s: Control settings, for the model and the unit conversion
+:param enabled: Use the state feedback instead of the PID
+:param position_error: Acceptable position error (user units)
+:param speed_error: Acceptable speed error (user units/s)
+:param integral_error: Acceptable integral of the position error (user units*s)
+ */
+pbio_error_t pbio_lqr_set_settings(pbio_lqr_t *lqr, const pbio_control_settings_t *s, bool enabled, float position_error, float speed_error, float integral_error) {
+    if (position_error <= 0.0f || speed_error <= 0.0f || integral_error <= 0.0f) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    lqr->settings.enabled = enabled;
+    lqr->settings.position_error = position_error;
+    lqr->settings.speed_error = speed_error;
+    lqr->settings.integral_error = integral_error;
+
+    pbio_error_t err = pbio_lqr_update_gains(lqr, s);
+    return err == PBIO_ERROR_INVALID_OP ? PBIO_SUCCESS : err;
+}
+
+/**
+Return the gains of a direction of motion in user units
+
+:param s: Control settings, for the unit conversion
+:param direction: Direction of motion, 1 or -1
+:param k_position: Return the position error gain (% per user unit)
+:param k_speed: Return the speed error gain (% per user unit/s)
+:param k_integral: Return the integral error gain (% per user unit*s)
+ */
+void pbio_lqr_get_gains(const pbio_lqr_t *lqr, const pbio_control_settings_t *s, int8_t direction, float *k_position, float *k_speed, float *k_integral) {
+    uint8_t d = direction < 0 ? 1 : 0;
+    float scale = s->counts_per_unit / s->actuation_scale / (1 << PBIO_LQR_GAIN_SHIFT);
+    *k_position = lqr->k_count[d] * scale;
+    *k_speed = lqr->k_rate[d] * scale;
+    *k_integral = lqr->k_integral[d] * scale * MS_PER_SECOND;
+}
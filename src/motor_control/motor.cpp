@@ -1,4 +1,6 @@
 #include "motor_control/motor.hpp"
+#include "motor_control/macros.h"
+#include "esp_cpu.h"
 
 void Motor::begin(
     const char *name,
@@ -9,11 +11,13 @@ void Motor::begin(
     pbio_direction_t direction, 
     float gearRatio, 
     pbio_control_settings_t *settings,
-    motor_error_output_func_t error_output_func) {
+    motor_error_output_func_t error_output_func,
+    uint32_t pwm_frequency,
+    uint8_t pwm_resolution) {
         _name = name;
         float counts_per_unit = gearRatio * ENCODER_COUNTS_PER_DEGREE;
         _tacho.begin(encoderPi1, encoderPi2, counts_per_unit, direction);
-        _dcmotor.begin(pwmPi1, pwmPi2, direction, MOTOR_MAX_CONTROL);
+        _dcmotor.begin(pwmPi1, pwmPi2, direction, MOTOR_MAX_CONTROL, pwm_frequency, pwm_resolution);
         _current_error_output_func = error_output_func;
 
 
@@ -76,6 +80,16 @@ void Motor::getState(pbio_passivity_t *state, int32_t *duty_now) const {
     }
 }
 
+/**
+Gets the duty cycle applied to the motor (-100.0 to 100)
+*/
+float Motor::duty() const {
+    pbio_passivity_t state;
+    int32_t duty_now;
+    getState(&state, &duty_now);
+    return (float)duty_now * 100.0f / MOTOR_MAX_CONTROL;
+}
+
 /**
 Stops the motor and lets it spin freely
 
@@ -132,6 +146,7 @@ The motor accelerates to the given speed and keeps running at this speed until y
 pbio_error_t Motor::run(float speed) {
     pbio_error_t err;
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        start_events();
         err = pbio_servo_run(&_servo, speed);
         xSemaphoreGive(_xMutex);
     }
@@ -165,6 +180,7 @@ pbio_error_t Motor::run_time(float speed, uint32_t time_ms, pbio_actuation_t the
     }
     
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        start_events();
         err = pbio_servo_run_time(&_servo, speed, time_ms, then);
         xSemaphoreGive(_xMutex);
     }
@@ -232,6 +248,7 @@ pbio_error_t Motor::run_until_stalled(float speed, float duty_limit, pbio_actuat
 
     // Call pbio with parsed user/default arguments
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        start_events();
         err = pbio_servo_run_until_stalled(&_servo, speed, then);
         xSemaphoreGive(_xMutex);
     }
@@ -282,6 +299,30 @@ pbio_error_t Motor::run_until_stalled(float speed, float duty_limit, pbio_actuat
     return PBIO_SUCCESS;
 }
 
+/**
+Starts running the motor at a constant speed until it stalls, without waiting for the stall.
+
+Used to run several motors against their obstacles at the same time. The duty isn't limited
+here, so limit it beforehand with set_actuation_limit() if needed.
+
+:param speed: Speed of the motor in deg/s
+:param then: What to do after coming to a standstill
+ */
+pbio_error_t Motor::start_until_stalled(float speed, pbio_actuation_t then) {
+    pbio_error_t err;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        start_events();
+        err = pbio_servo_run_until_stalled(&_servo, speed, then);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::start_until_stalled(%f) init failed", speed);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
 /**
 Runs the motor at a constant speed by a given angle (relative)
 
@@ -293,6 +334,7 @@ Runs the motor at a constant speed by a given angle (relative)
 pbio_error_t Motor::run_angle(float speed, float angle, pbio_actuation_t then, bool wait, CancelToken* cancel_token) {
     pbio_error_t err;
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        start_events();
         err = pbio_servo_run_angle(&_servo, speed, angle, then);
         xSemaphoreGive(_xMutex);
     }
@@ -323,20 +365,37 @@ The direction of rotation is automatically selected based on the target angle. I
 :param wait: Wait for the maneuver to complete before continuing with the rest of the program
 */
 pbio_error_t Motor::run_target(float speed, float target_angle, pbio_actuation_t then, bool wait, CancelToken* cancel_token) {
+    return run_target_profile(speed, 0.0f, target_angle, then, wait, cancel_token);
+}
+
+/**
+Runs the motor towards a given target angle with the given speed and acceleration profile.
+
+Same as run_target(), with the acceleration of the move given instead of the acceleration limit.
+The acceleration can't exceed the limit.
+
+:param speed: Speed of the motor in deg/s
+:param acceleration: Acceleration/deceleration in deg/s^2. Zero to use the acceleration limit
+:param target_angle: Angle that the motor should rotate to in deg
+:param then: What to do after coming to a standstill
+:param wait: Wait for the maneuver to complete before continuing with the rest of the program
+*/
+pbio_error_t Motor::run_target_profile(float speed, float acceleration, float target_angle, pbio_actuation_t then, bool wait, CancelToken* cancel_token) {
     pbio_error_t err;
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
-        err = pbio_servo_run_target(&_servo, speed, target_angle, then);
+        start_events();
+        err = pbio_servo_run_target(&_servo, speed, target_angle, acceleration, then);
         xSemaphoreGive(_xMutex);
     }
     if (err != PBIO_SUCCESS) {
-        output_motor_error(err, "Motor::run_target(%f, %f) init failed", speed, target_angle);
+        output_motor_error(err, "Motor::run_target(%f, %f, %f) init failed", speed, acceleration, target_angle);
         return err;
     }
 
     if (wait) {
         err = wait_for_completion(cancel_token);
         if (err != PBIO_SUCCESS) {
-            output_motor_error(err, "Motor::run_target(%f, %f) movement failed", speed, target_angle);
+            output_motor_error(err, "Motor::run_target(%f, %f, %f) movement failed", speed, acceleration, target_angle);
             return err;
         }
     }
@@ -347,25 +406,47 @@ pbio_error_t Motor::run_target(float speed, float target_angle, pbio_actuation_t
 /** 
 Tracks a target angle. 
 
-This is similar to run_target(), but the usual smooth acceleration is skipped: it will move 
-to the target angle as fast as possible. This method is useful if you want to continuously 
-change the target angle.
+This is similar to run_target(), but without a planned trajectory. With smoothing, the motor
+follows the target within the speed and acceleration limits, without stepping when the target
+changes. Without it, the motor moves to the target angle as fast as possible. This method is
+useful if you want to continuously change the target angle.
 
 :param target_angle: Target angle that the motor should rotate to in deg
+:param smooth: Follow the target within the speed and acceleration limits
+:param direction: Direction of motion of the axis the target follows (-1, 0 or 1). Without smoothing
+the reference stands still, so the gains and the feedforward are selected on it
 */
-void Motor::track_target(float target_angle) {
+void Motor::track_target(float target_angle, bool smooth, int8_t direction) {
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
-        pbio_servo_track_target(&_servo, target_angle);
+        pbio_servo_track_target(&_servo, target_angle, smooth, direction);
         xSemaphoreGive(_xMutex);
     }
 }
 
+/**
+Return the direction of motion used by the controller at the last update (-1, 0 or 1), zero at standstill
+*/
+int8_t Motor::reference_direction() const {
+    int8_t direction = 0;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        direction = _servo.control.type == PBIO_CONTROL_NONE ? 0 : _servo.control.ref_direction;
+        xSemaphoreGive(_xMutex);
+    }
+    return direction;
+}
+
 /**
 Wait until current movement is completed or fails
+
+The task blocks on the motor events, so it doesn't use CPU while waiting and it wakes up
+in the same servo period that completes the maneuver.
+
+:param cancel_token: Token that stops the motor and ends the wait. A global cancel does the same when it's null
+:param timeout_ms: Maximum wait time (ms). The motor keeps moving when the wait times out
+:return: The servo status at the end of the maneuver, PBIO_ERROR_CANCELED or PBIO_ERROR_TIMEDOUT
 */
-pbio_error_t Motor::wait_for_completion(CancelToken* cancel_token) {
-    bool wait;
-    pbio_error_t status;
+pbio_error_t Motor::wait_for_completion(CancelToken* cancel_token, uint32_t timeout_ms) {
+    pbio_error_t status = PBIO_SUCCESS;
     CancelToken localToken;
     if (cancel_token == nullptr) {
         // If no cancel token is provided, create a local cancel token in order to be able 
@@ -373,23 +454,42 @@ pbio_error_t Motor::wait_for_completion(CancelToken* cancel_token) {
         cancel_token = &localToken;
     }
 
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = timeout_ms == MOTOR_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    cancel_token->subscribe(_events, MOTOR_EVENT_CANCEL);
+
     while (true) {
         IF_CANCELLED(*cancel_token, {
             // If the movement is canceled, stop the motor
+            cancel_token->unsubscribe(_events);
             stop();
             return PBIO_ERROR_CANCELED;
         });
 
-        if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
-            status = _servo_status;
-            wait = _servo_status == PBIO_SUCCESS && !pbio_control_is_done(&_servo.control);
-            xSemaphoreGive(_xMutex);
+        TickType_t remaining = portMAX_DELAY;
+        if (timeout != portMAX_DELAY) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            remaining = elapsed < timeout ? timeout - elapsed : 0;
         }
-            
-        if (wait)
-            delay(PBIO_CONFIG_SERVO_PERIOD_MS + 1);
-        else
+
+        EventBits_t bits = xEventGroupWaitBits(_events, MOTOR_EVENT_DONE | MOTOR_EVENT_ERROR | MOTOR_EVENT_CANCEL, pdFALSE, pdFALSE, remaining);
+        if (bits & (MOTOR_EVENT_DONE | MOTOR_EVENT_ERROR)) {
             break;
+        }
+        if (bits & MOTOR_EVENT_CANCEL) {
+            // Either this token, checked above, or the token of another waiting task
+            xEventGroupClearBits(_events, MOTOR_EVENT_CANCEL);
+            continue;
+        }
+
+        cancel_token->unsubscribe(_events);
+        return PBIO_ERROR_TIMEDOUT;
+    }
+    cancel_token->unsubscribe(_events);
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        status = _servo_status;
+        xSemaphoreGive(_xMutex);
     }
 
     return status;
@@ -401,14 +501,87 @@ pbio_error_t Motor::wait_for_completion(CancelToken* cancel_token) {
  * @return True if the motor has completed its movement, false otherwise.
  */
 bool Motor::is_completion() {
-    bool completed = false;
+    return (xEventGroupGetBits(_events) & MOTOR_EVENT_DONE) != 0;
+}
+
+/**
+ * Check if the motor is stalled during the ongoing command.
+ *
+ * @return True if the motor is stalled, false otherwise.
+ */
+bool Motor::is_stalled() const {
+    return (xEventGroupGetBits(_events) & MOTOR_EVENT_STALLED) != 0;
+}
+
+/**
+ * Check if the servo reported an error during the ongoing command.
+ *
+ * @return True if the servo reported an error, false otherwise.
+ */
+bool Motor::is_failed() const {
+    return (xEventGroupGetBits(_events) & MOTOR_EVENT_ERROR) != 0;
+}
+
+/**
+Return the servo status of the last servo period
+*/
+pbio_error_t Motor::status() const {
+    pbio_error_t status = PBIO_SUCCESS;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        status = _servo_status;
+        xSemaphoreGive(_xMutex);
+    }
+    return status;
+}
+
+/**
+Return how long a run_target maneuver started now from standstill would last
 
+:param speed: Speed of the motor in deg/s
+:param target_angle: Angle that the motor should rotate to in deg
+:param duration_us: Return the maneuver duration (us)
+*/
+pbio_error_t Motor::get_target_duration(float speed, float target_angle, int32_t *duration_us) {
+    pbio_error_t err;
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
-        completed = _servo_status == PBIO_SUCCESS && pbio_control_is_done(&_servo.control);
+        err = pbio_servo_get_target_duration(&_servo, speed, target_angle, duration_us);
         xSemaphoreGive(_xMutex);
     }
+    return err;
+}
+
+/**
+Keep the servo loop off the motor until end_sync(), so maneuvers started on several motors
+begin in the same servo period. Only run_target_synced() can be called in between
+*/
+void Motor::begin_sync() {
+    xSemaphoreTake(_xMutex, portMAX_DELAY);
+}
+
+/**
+Release the motor to the servo loop after begin_sync()
+*/
+void Motor::end_sync() {
+    xSemaphoreGive(_xMutex);
+}
+
+/**
+Runs the motor towards a target angle, scaled in time to finish together with other motors.
+The motor must be taken with begin_sync()
 
-    return completed;
+:param time_start: Start time shared by all the motors (us)
+:param speed: Speed of the motor in deg/s
+:param target_angle: Angle that the motor should rotate to in deg
+:param time_scale: Ratio between the unscaled and the wanted duration of the maneuver (0 to 1)
+:param then: What to do after coming to a standstill
+*/
+pbio_error_t Motor::run_target_synced(int32_t time_start, float speed, float target_angle, float time_scale, pbio_actuation_t then) {
+    start_events();
+    pbio_error_t err = pbio_servo_run_target_scaled(&_servo, time_start, speed, target_angle, time_scale, then);
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::run_target_synced(%f, %f, %f) init failed", speed, target_angle, time_scale);
+    }
+    return err;
 }
 
 float Motor::get_counts_per_unit() const {
@@ -689,36 +862,803 @@ pbio_error_t Motor::set_stall_tolerances(float speed, uint32_t time_ms) {
 }
 
 /**
- * Prints an error message to the serial output.
- * @param [in]  err     The error code
- * @param [in]  format  The format string for the error message
- * @param [in]  ...     Additional arguments for the format string
- */
-void Motor::output_motor_error(pbio_error_t err, const char* format, ...) {
-    if (err != PBIO_SUCCESS) {
-        va_list args;
-        va_start(args, format);
+Return the identified plant model in user units
+
+:param gain_pos: Return steady state speed gain moving in positive direction (deg/s per %)
+:param gain_neg: Return steady state speed gain moving in negative direction (deg/s per %)
+:param time_constant_pos: Return speed time constant moving in positive direction (s)
+:param time_constant_neg: Return speed time constant moving in negative direction (s)
+:param coulomb: Return Coulomb friction (%)
+:param viscous: Return viscous friction (% per deg/s)
+:param gravity: Return gravity offset (%)
+*/
+void Motor::get_model(float *gain_pos, float *gain_neg, float *time_constant_pos, float *time_constant_neg, float *coulomb, float *viscous, float *gravity) const {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_control_settings_get_model(&_servo.control.settings, gain_pos, gain_neg, time_constant_pos, time_constant_neg, coulomb, viscous, gravity);
+        xSemaphoreGive(_xMutex);
+    }
+}
 
-        char buffer[1024];
-        vsnprintf(buffer, sizeof(buffer), format, args);
-        va_end(args);
+/**
+Set the identified plant model in user units
+
+:param gain_pos: Steady state speed gain moving in positive direction (deg/s per %)
+:param gain_neg: Steady state speed gain moving in negative direction (deg/s per %)
+:param time_constant_pos: Speed time constant moving in positive direction (s)
+:param time_constant_neg: Speed time constant moving in negative direction (s)
+:param coulomb: Coulomb friction (%)
+:param viscous: Viscous friction (% per deg/s)
+:param gravity: Gravity offset (%)
+*/
+pbio_error_t Motor::set_model(float gain_pos, float gain_neg, float time_constant_pos, float time_constant_neg, float coulomb, float viscous, float gravity) {
+    pbio_error_t err;
 
-        String err_message = String(_name) +" " + buffer;
-        
-        if (_current_error_output_func) {
-            _current_error_output_func(err, pbio_error_str(err), err_message.c_str());
-        } else {
-            Serial.print("Motor Error: ");
-            Serial.print(pbio_error_str(err));
-            Serial.print(" -> ");
-            Serial.println(err_message.c_str());
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_control_settings_set_model(&_servo.control.settings, gain_pos, gain_neg, time_constant_pos, time_constant_neg, coulomb, viscous, gravity);
+        if (err == PBIO_SUCCESS) {
+            // The state feedback gains are computed from the model
+            pbio_lqr_update_gains(&_servo.control.lqr, &_servo.control.settings);
         }
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_model(%f, %f, %f, %f, %f, %f, %f) set failed", gain_pos, gain_neg, time_constant_pos, time_constant_neg, coulomb, viscous, gravity);
+        return err;
     }
+
+    return PBIO_SUCCESS;
 }
 
-void Motor::update() {
+/**
+Get the position indexed feedforward table
+
+:param table: Return a copy of the table (counts and duty steps)
+*/
+void Motor::get_ff_table(pbio_control_ff_table_t *table) const {
     if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
-        _servo_status = pbio_servo_control_update(&_servo);
+        pbio_control_settings_get_ff_table(&_servo.control.settings, table);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Set the position indexed feedforward table
+
+:param table: Table with positions in counts and duty in duty steps. A zero step disables the table
+*/
+pbio_error_t Motor::set_ff_table(const pbio_control_ff_table_t *table) {
+    pbio_error_t err;
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_control_settings_set_ff_table(&_servo.control.settings, table);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_ff_table(%d, %d) set failed", table->count_start, table->count_step);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Return true when the negative direction gains are used while moving in negative direction
+*/
+bool Motor::get_gain_scheduling() const {
+    bool enabled = false;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        enabled = _servo.control.settings.gain_scheduling;
+        xSemaphoreGive(_xMutex);
+    }
+    return enabled;
+}
+
+/**
+Enable or disable the gains scheduling on the direction of motion
+
+:param enable: True to use the negative direction gains while moving in negative direction
+*/
+void Motor::set_gain_scheduling(bool enable) {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_control_settings_set_gain_scheduling(&_servo.control.settings, enable);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Return the gains used while moving in negative direction
+
+:param kp: Return PID Kp
+:param ki: Return PID Ki
+:param kd: Return PID Kd
+:param acceleration: Return acceleration/deceleration (deg/s^2)
+:param max_windup_factor: Return integrator max windup factor
+*/
+void Motor::get_gains_neg(uint16_t *kp, uint16_t *ki, uint16_t *kd, float *acceleration, float *max_windup_factor) const {
+    int16_t _kp, _ki, _kd;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_control_settings_get_gains_neg(&_servo.control.settings, &_kp, &_ki, &_kd, acceleration, max_windup_factor);
+        xSemaphoreGive(_xMutex);
+    }
+    *kp = (uint16_t)_kp;
+    *ki = (uint16_t)_ki;
+    *kd = (uint16_t)_kd;
+}
+
+/**
+Set the gains used while moving in negative direction
+
+:param kp: PID Kp
+:param ki: PID Ki
+:param kd: PID Kd
+:param acceleration: Acceleration/deceleration (deg/s^2)
+:param max_windup_factor: Integrator max windup factor
+*/
+pbio_error_t Motor::set_gains_neg(uint16_t kp, uint16_t ki, uint16_t kd, float acceleration, float max_windup_factor) {
+    pbio_error_t err;
+
+    if (max_windup_factor > 10.0) {
+        err = PBIO_ERROR_INVALID_ARG;
+        output_motor_error(err, "Motor::set_gains_neg(%u, %u, %u, %f, %f) max_windup_factor greater than 10.0", kp, ki, kd, acceleration, max_windup_factor);
+        return err;
+    }
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_control_settings_set_gains_neg(&_servo.control.settings, kp, ki, kd, acceleration, max_windup_factor);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_gains_neg(%u, %u, %u, %f, %f) set failed", kp, ki, kd, acceleration, max_windup_factor);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Return the collision detector settings
+
+:param enabled: Return true if the detector is enabled
+:param threshold: Return the speed residual that flags an obstruction (deg/s)
+:param ticks: Return the consecutive control periods over the threshold
+:param reaction: Return how the motor is stopped on an obstruction
+*/
+void Motor::get_collision_detection(bool *enabled, float *threshold, uint8_t *ticks, pbio_actuation_t *reaction) const {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_collision_get_settings(&_servo.collision, &_servo.control.settings, enabled, threshold, ticks, reaction);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Set the collision detector settings
+
+The detector compares the speed with the identified model, so it runs only after the model is set.
+
+:param enabled: Enable the detector
+:param threshold: Speed residual that flags an obstruction (deg/s)
+:param ticks: Consecutive control periods over the threshold
+:param reaction: How to stop the motor on an obstruction: coast, brake or hold
+*/
+pbio_error_t Motor::set_collision_detection(bool enabled, float threshold, uint8_t ticks, pbio_actuation_t reaction) {
+    pbio_error_t err;
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_collision_set_settings(&_servo.collision, &_servo.control.settings, enabled, threshold, ticks, reaction);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_collision_detection(%d, %f, %u, %d) set failed", enabled, threshold, ticks, reaction);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Return true if the last maneuver was stopped by an obstruction
+*/
+bool Motor::collision_detected() const {
+    bool detected = false;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        detected = _servo.collision.detected;
+        xSemaphoreGive(_xMutex);
+    }
+    return detected;
+}
+
+/**
+Return the number of obstructions detected since power-up
+*/
+uint32_t Motor::collision_count() const {
+    uint32_t count = 0;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        count = _servo.collision.detections;
+        xSemaphoreGive(_xMutex);
+    }
+    return count;
+}
+
+/**
+Return the speed residual of the last detected obstruction (deg/s)
+*/
+float Motor::collision_residual() const {
+    float residual = 0.0f;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        residual = pbio_control_counts_to_user(&_servo.control.settings, _servo.collision.residual);
+        xSemaphoreGive(_xMutex);
+    }
+    return residual;
+}
+
+/**
+Stop the motor as if it detected an obstruction. Used when the obstruction is detected on a coupled motor
+
+:param residual: Speed residual that flagged the obstruction (deg/s)
+*/
+void Motor::collision_stop(float residual) {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_servo_collision_stop(&_servo, pbio_control_user_to_counts(&_servo.control.settings, residual));
+        _servo_status = PBIO_ERROR_COLLISION;
+        update_events();
         xSemaphoreGive(_xMutex);
     }
+}
+
+/**
+Clear the obstruction latch. Used on a coupled motor that only tracks targets, so it never starts
+the maneuver that would clear it, once the motor it follows starts a new one
+*/
+void Motor::collision_reset() {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_collision_reset(&_servo.collision);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Return true if the software limits are enforced by the servo loop, once the axis is referenced
+*/
+bool Motor::get_envelope() const {
+    bool enabled = false;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        enabled = _servo.envelope.enabled;
+        xSemaphoreGive(_xMutex);
+    }
+    return enabled;
+}
+
+/**
+Enforce the software limits in the servo loop. Any maneuver, open loop included, that would overrun
+a limit is braked at the acceleration limit to stop on it, and a tracked target is kept within
+
+:param enabled: Enforce the limits
+*/
+void Motor::set_envelope(bool enabled) {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        _servo.envelope.enabled = enabled;
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Arm the software limits once the axis is referenced. The homing disarms them when it starts,
+since the reference is searched beyond the limits, and arms them when it succeeds
+
+:param armed: The axis is referenced
+*/
+void Motor::arm_envelope(bool armed) {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_envelope_arm(&_servo.envelope, armed);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Return true if the software limits are armed, the axis is referenced
+*/
+bool Motor::envelope_armed() const {
+    bool armed = false;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        armed = _servo.envelope.armed;
+        xSemaphoreGive(_xMutex);
+    }
+    return armed;
+}
+
+/**
+Return the number of maneuvers braked on a software limit since power-up
+*/
+uint32_t Motor::envelope_violations() const {
+    uint32_t count = 0;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        count = _servo.envelope.violations;
+        xSemaphoreGive(_xMutex);
+    }
+    return count;
+}
+
+/**
+Get the state of the motor when the last maneuver was braked on a software limit
+
+:param angle: Return the angle (deg)
+:param speed: Return the speed (deg/s)
+*/
+void Motor::get_envelope_violation(float *angle, float *speed) const {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        *angle = pbio_control_counts_to_user(&_servo.control.settings, _servo.envelope.violation_count);
+        *speed = pbio_control_counts_to_user(&_servo.control.settings, _servo.envelope.violation_rate);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Pass the software limits to the envelope. Must be called with the mutex held
+*/
+void Motor::update_envelope_limits() {
+    pbio_envelope_set_limits(&_servo.envelope,
+        pbio_control_user_to_counts(&_servo.control.settings, _swLimitM),
+        pbio_control_user_to_counts(&_servo.control.settings, _swLimitP));
+}
+
+/**
+Get the disturbance observer settings
+
+:param enabled: Return true if the observer is enabled
+:param bandwidth: Return the cutoff frequency of the estimate (Hz)
+*/
+void Motor::get_disturbance_observer(bool *enabled, float *bandwidth) const {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_observer_get_settings(&_servo.control.observer, enabled, bandwidth);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Set the disturbance observer settings
+
+The observer inverts the identified model, so it runs only after the model is set.
+
+:param enabled: Estimate the load not covered by the model and cancel it
+:param bandwidth: Cutoff frequency of the estimate (Hz)
+*/
+pbio_error_t Motor::set_disturbance_observer(bool enabled, float bandwidth) {
+    pbio_error_t err;
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_observer_set_settings(&_servo.control.observer, enabled, bandwidth);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_disturbance_observer(%d, %f) set failed", enabled, bandwidth);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Gets the disturbance estimated by the observer, as duty cycle (-100.0 to 100)
+*/
+float Motor::disturbance() const {
+    float disturbance = 0.0f;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        disturbance = _servo.control.observer.disturbance * 100.0f / MOTOR_MAX_CONTROL;
+        xSemaphoreGive(_xMutex);
+    }
+    return disturbance;
+}
+
+/**
+Get the state feedback settings
+
+:param enabled: Return true if the state feedback replaces the PID
+:param position_error: Return the acceptable position error (deg)
+:param speed_error: Return the acceptable speed error (deg/s)
+:param integral_error: Return the acceptable integral of the position error (deg*s)
+*/
+void Motor::get_state_feedback(bool *enabled, float *position_error, float *speed_error, float *integral_error) const {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_lqr_get_settings(&_servo.control.lqr, enabled, position_error, speed_error, integral_error);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Set the state feedback settings
+
+The gains are computed from the identified model, so the PID stays in use until the model is set.
+
+:param enabled: Use the state feedback instead of the PID
+:param position_error: Acceptable position error (deg)
+:param speed_error: Acceptable speed error (deg/s)
+:param integral_error: Acceptable integral of the position error (deg*s)
+*/
+pbio_error_t Motor::set_state_feedback(bool enabled, float position_error, float speed_error, float integral_error) {
+    pbio_error_t err;
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_lqr_set_settings(&_servo.control.lqr, &_servo.control.settings, enabled, position_error, speed_error, integral_error);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_state_feedback(%d, %f, %f, %f) set failed", enabled, position_error, speed_error, integral_error);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Get the state feedback gains of a direction of motion
+
+:param direction: Direction of motion, 1 or -1
+:param k_position: Return the position error gain (% per deg)
+:param k_speed: Return the speed error gain (% per deg/s)
+:param k_integral: Return the integral error gain (% per deg*s)
+:return: False if the gains are not computed
+*/
+bool Motor::get_state_feedback_gains(int8_t direction, float *k_position, float *k_speed, float *k_integral) const {
+    bool valid = false;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_lqr_get_gains(&_servo.control.lqr, &_servo.control.settings, direction, k_position, k_speed, k_integral);
+        valid = _servo.control.lqr.valid;
+        xSemaphoreGive(_xMutex);
+    }
+    return valid;
+}
+
+/**
+Simulate a run_target maneuver on the identified model, with the PID or the state feedback
+
+The simulation runs on a copy of the controller, so the motor is not affected.
+
+:param state_feedback: Simulate the state feedback instead of the PID
+:param speed: Cruise speed (deg/s)
+:param start: Start position (deg)
+:param target: Target position (deg)
+:param result: Return the outcome of the maneuver (counts and us)
+*/
+pbio_error_t Motor::simulate_run_target(bool state_feedback, float speed, float start, float target, pbio_simulation_result_t *result) {
+    pbio_control_t *ctl = (pbio_control_t *)malloc(sizeof(pbio_control_t));
+    if (!ctl) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        *ctl = _servo.control;
+        xSemaphoreGive(_xMutex);
+    }
+
+    pbio_error_t err = PBIO_ERROR_INVALID_OP;
+    ctl->lqr.settings.enabled = state_feedback;
+    if (!state_feedback || ctl->lqr.valid) {
+        err = pbio_simulation_run_target(ctl,
+            pbio_control_user_to_counts(&ctl->settings, start),
+            pbio_control_user_to_counts(&ctl->settings, target),
+            pbio_control_user_to_counts(&ctl->settings, speed),
+            result);
+    }
+    free(ctl);
+
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::simulate_run_target(%d, %f, %f, %f) failed", state_feedback, speed, start, target);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Plan a run_target maneuver from standstill and sample its reference, without moving the motor
+
+The maneuver is planned on a copy of the controller, optionally with other limits, to check
+a change of the settings before applying it.
+
+:param start: Start position (deg)
+:param target: Target position (deg)
+:param speed: Cruise speed (deg/s)
+:param acceleration: Acceleration/deceleration (deg/s^2). Zero to use the acceleration limit
+:param speed_limit: Speed limit to plan with (deg/s). Zero to use the current one
+:param acceleration_limit: Acceleration limit to plan with (deg/s^2). Zero to use the current one
+:param max_samples: Samples to take, evenly spaced over the maneuver
+:param samples: Return the samples (counts and us)
+:param num_samples: Return the number of samples taken
+*/
+pbio_error_t Motor::preview_target(float start, float target, float speed, float acceleration, float speed_limit, float acceleration_limit, uint16_t max_samples, pbio_simulation_sample_t *samples, uint16_t *num_samples) {
+    pbio_control_t *ctl = (pbio_control_t *)malloc(sizeof(pbio_control_t));
+    if (!ctl) {
+        return PBIO_ERROR_FAILED;
+    }
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        *ctl = _servo.control;
+        xSemaphoreGive(_xMutex);
+    }
+
+    pbio_error_t err = PBIO_SUCCESS;
+    if (speed_limit != 0.0f) {
+        err = pbio_control_settings_set_speed_limit(&ctl->settings, speed_limit);
+    }
+    if (err == PBIO_SUCCESS && acceleration_limit != 0.0f) {
+        err = pbio_control_settings_set_acceleration_limit(&ctl->settings, acceleration_limit);
+    }
+    if (err == PBIO_SUCCESS) {
+        err = pbio_simulation_preview_target(ctl,
+            pbio_control_user_to_counts(&ctl->settings, start),
+            pbio_control_user_to_counts(&ctl->settings, target),
+            pbio_control_user_to_counts(&ctl->settings, speed),
+            pbio_control_user_to_counts(&ctl->settings, acceleration),
+            max_samples, samples, num_samples);
+    }
+    free(ctl);
+
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::preview_target(%f, %f, %f, %f) failed", start, target, speed, acceleration);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Get the input shaper settings
+
+:param type: Return the impulse sequence
+:param frequency: Return the frequency of the vibration to suppress (Hz)
+:param damping: Return the damping ratio of the vibration to suppress
+*/
+void Motor::get_input_shaper(pbio_shaper_type_t *type, float *frequency, float *damping) const {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_shaper_get_settings(&_servo.control.shaper, type, frequency, damping);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Set the input shaper settings
+
+:param type: Impulse sequence, PBIO_SHAPER_NONE to follow the trajectory as planned
+:param frequency: Frequency of the vibration to suppress (Hz)
+:param damping: Damping ratio of the vibration to suppress
+*/
+pbio_error_t Motor::set_input_shaper(pbio_shaper_type_t type, float frequency, float damping) {
+    pbio_error_t err;
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_shaper_set_settings(&_servo.control.shaper, type, frequency, damping);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_input_shaper(%d, %f, %f) set failed", type, frequency, damping);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Get the iterative learning settings
+
+:param enabled: Return true if the learning is enabled
+:param gain: Return the learning gain
+:param lead_ms: Return the phase lead (ms)
+*/
+void Motor::get_learning(bool *enabled, float *gain, uint16_t *lead_ms) const {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_ilc_get_settings(&_servo.ilc, enabled, gain, lead_ms);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Set the iterative learning settings
+
+:param enabled: Apply and learn the correction of the armed maneuvers
+:param gain: Fraction of the PD control action on the error learned at each iteration (0 to 1)
+:param lead_ms: Time advance of the error used to learn a control period (ms)
+*/
+pbio_error_t Motor::set_learning(bool enabled, float gain, uint16_t lead_ms) {
+    pbio_error_t err;
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_ilc_set_settings(&_servo.ilc, enabled, gain, lead_ms);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_learning(%d, %f, %u) set failed", enabled, gain, lead_ms);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+Make the next run_target an iteration of the learning
+
+The maneuver must end holding the target, so the settling after the trajectory is learned too.
+*/
+void Motor::arm_learning() {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_ilc_arm(&_servo.ilc);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Update the correction table from the last iteration
+
+:param rms: Return the tracking error RMS of the iteration (deg)
+:param iterations: Return the iterations learned into the table
+:return: PBIO_ERROR_AGAIN if no iteration is waiting, PBIO_ERROR_FAILED if the learning diverged and the table was reset
+*/
+pbio_error_t Motor::learn(float *rms, uint16_t *iterations) {
+    pbio_error_t err = PBIO_ERROR_AGAIN;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_ilc_learn_begin(&_servo.ilc, &_servo.control.settings);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        return err;
+    }
+
+    // Learn the copy without the lock, the servo loop keeps running with the current table
+    err = pbio_ilc_learn(&_servo.ilc.work);
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_ilc_learn_end(&_servo.ilc, err);
+        *rms = _servo.ilc.rms / _servo.control.settings.counts_per_unit;
+        *iterations = _servo.ilc.iterations;
+        xSemaphoreGive(_xMutex);
+    }
+    return err;
+}
+
+/**
+Return true if the learning converged to a table better than the stored one
+*/
+bool Motor::learning_needs_store() const {
+    bool needs_store = false;
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        needs_store = _servo.ilc.needs_store;
+        xSemaphoreGive(_xMutex);
+    }
+    return needs_store;
+}
+
+void Motor::mark_learning_stored() {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_ilc_mark_stored(&_servo.ilc);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Get the learned correction table
+
+:param table: Return a copy of the table (counts and duty steps)
+*/
+void Motor::get_learning_table(pbio_ilc_table_t *table) const {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        pbio_ilc_get_table(&_servo.ilc, table);
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Load a learned correction table
+
+:param table: Table with positions in counts and duty in duty steps. A zero length discards the table
+*/
+pbio_error_t Motor::set_learning_table(const pbio_ilc_table_t *table) {
+    pbio_error_t err;
+
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        err = pbio_ilc_set_table(&_servo.ilc, table);
+        xSemaphoreGive(_xMutex);
+    }
+    if (err != PBIO_SUCCESS) {
+        output_motor_error(err, "Motor::set_learning_table(%u) set failed", table->length);
+        return err;
+    }
+
+    return PBIO_SUCCESS;
+}
+
+/**
+ * Prints an error message to the serial output.
+ * @param [in]  err     The error code
+ * @param [in]  format  The format string for the error message
+ * @param [in]  ...     Additional arguments for the format string
+ */
+void Motor::output_motor_error(pbio_error_t err, const char* format, ...) {
+    if (err != PBIO_SUCCESS) {
+        va_list args;
+        va_start(args, format);
+
+        char buffer[1024];
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+
+        String err_message = String(_name) +" " + buffer;
+        
+        if (_current_error_output_func) {
+            _current_error_output_func(err, pbio_error_str(err), err_message.c_str());
+        } else {
+            Serial.print("Motor Error: ");
+            Serial.print(pbio_error_str(err));
+            Serial.print(" -> ");
+            Serial.println(err_message.c_str());
+        }
+    }
+}
+
+void PBIO_IRAM Motor::update() {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        _servo_status = pbio_servo_control_update(&_servo);
+        update_events();
+
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        _update_cycles_sum += cycles;
+        _update_cycles_max = PIO_MAX(_update_cycles_max, cycles);
+        _update_count++;
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Get the CPU cycles spent in the servo updates, servo loop and events signaling
+
+:param mean: Return the mean cycles of an update, zero if there was no update
+:param max: Return the highest cycles of an update
+:param reset: Restart the measure
+*/
+void Motor::get_update_cycles(uint32_t *mean, uint32_t *max, bool reset) {
+    if (xSemaphoreTake(_xMutex, portMAX_DELAY)) {
+        *mean = _update_count > 0 ? (uint32_t)(_update_cycles_sum / _update_count) : 0;
+        *max = _update_cycles_max;
+        if (reset) {
+            _update_cycles_sum = 0;
+            _update_cycles_max = 0;
+            _update_count = 0;
+        }
+        xSemaphoreGive(_xMutex);
+    }
+}
+
+/**
+Clear the events of the previous maneuver, so a wait doesn't return before the servo loop
+evaluates the new one. Must be called with the mutex held, before starting a maneuver
+*/
+void Motor::start_events() {
+    _servo_status = PBIO_SUCCESS;
+    _events_state = 0;
+    xEventGroupClearBits(_events, MOTOR_EVENT_DONE | MOTOR_EVENT_STALLED | MOTOR_EVENT_ERROR);
+}
+
+/**
+Signal the changes of the servo state to the waiting tasks. Must be called with the mutex held
+*/
+void PBIO_IRAM Motor::update_events() {
+    EventBits_t state = 0;
+    if (_servo_status != PBIO_SUCCESS) {
+        state |= MOTOR_EVENT_ERROR;
+    } else if (pbio_control_is_done(&_servo.control)) {
+        state |= MOTOR_EVENT_DONE;
+    }
+    if (pbio_control_is_stalled(&_servo.control)) {
+        state |= MOTOR_EVENT_STALLED;
+    }
+
+    // Touch the event group only on changes, not at every servo period
+    EventBits_t set = state & ~_events_state;
+    EventBits_t clear = _events_state & ~state;
+    if (clear) {
+        xEventGroupClearBits(_events, clear);
+    }
+    if (set) {
+        xEventGroupSetBits(_events, set);
+    }
+    _events_state = state;
 }
\ No newline at end of file
@@ -10,6 +10,9 @@ pbio_error_t MotorWithReferenceSwitch::run_axis_homing(CancelToken& cancel_token
 
     Logger::instance().logI("Starting " + String(name()) + "-axis homing....");
 
+    // The reference is searched beyond the software limits
+    arm_envelope(false);
+
     while (true)
     {
         IF_CANCELLED(cancel_token, {
@@ -82,6 +85,7 @@ pbio_error_t MotorWithReferenceSwitch::run_axis_homing(CancelToken& cancel_token
     }
 
     _referenced = true;
+    arm_envelope(true);
     
     return PBIO_SUCCESS;
 }
\ No newline at end of file
@@ -10,6 +10,9 @@ pbio_error_t MotorWithStallReference::run_axis_homing(CancelToken& cancel_token)
 
     Logger::instance().logI("Starting " + String(name()) + "-axis homing....");
 
+    // The reference is searched beyond the software limits
+    arm_envelope(false);
+
     while (true)
     {
         IF_CANCELLED(cancel_token, {
@@ -58,6 +61,7 @@ pbio_error_t MotorWithStallReference::run_axis_homing(CancelToken& cancel_token)
     PBIO_RETURN_ON_ERROR(run_target(backward_final_speed, _config.axis_position_after_home, PBIO_ACTUATION_HOLD, true, &cancel_token));
 
     _referenced = true;
+    arm_envelope(true);
     
     return PBIO_SUCCESS;
 }
\ No newline at end of file
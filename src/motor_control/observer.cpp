@@ -0,0 +1,103 @@
+#include "motor_control/observer.hpp"
+#include "motor_control/macros.h"
+#include "motor_control/const.h"
+#include "config.h"
+
+/**
+Initialize the observer, disabled, with the default bandwidth
+ */
+void pbio_observer_setup(pbio_observer_t *obs) {
+    memset(obs, 0, sizeof(pbio_observer_t));
+    obs->settings.enabled = false;
+    obs->settings.bandwidth = PBIO_OBSERVER_DEFAULT_BANDWIDTH;
+}
+
+/**
+Drop the estimate and restart the filters from the next measure
+ */
+void pbio_observer_reset(pbio_observer_t *obs) {
+    obs->primed = false;
+    obs->disturbance = 0.0f;
+}
+
+/**
+Advance the observer by one control period
+
+:param model: Identified plant model
+:param time_now: Current time (us)
+:param rate_now: Measured speed (count/s)
+:return: Duty that cancels the estimated disturbance (duty steps)
+ */
+int32_t PBIO_IRAM pbio_observer_update(pbio_observer_t *obs, const pbio_control_model_t *model, int32_t time_now, int32_t rate_now) {
+    if (!obs->settings.enabled || model->gain[0] <= 0 || model->gain[1] <= 0) {
+        pbio_observer_reset(obs);
+        return 0;
+    }
+
+    // (Re)start after a pause or a missed period, with the filters in agreement with the model
+    uint8_t d = obs->rate_filtered >= 0 ? 0 : 1;
+    int32_t elapsed = time_now - obs->time_prev;
+    obs->time_prev = time_now;
+    if (!obs->primed || elapsed <= 0 || elapsed > 2 * PBIO_CONFIG_SERVO_PERIOD_MS * US_PER_MS) {
+        obs->primed = true;
+        obs->rate_filtered = rate_now;
+        obs->control_filtered = rate_now / model->gain[rate_now >= 0 ? 0 : 1];
+        obs->control_prev = obs->control_filtered;
+        obs->disturbance = 0.0f;
+        return 0;
+    }
+
+    // Friction and gravity are part of the model, so they are taken off the duty in the direction of motion
+    float offset = model->gravity + (d == 0 ? model->coulomb : -model->coulomb);
+    float wc = 2.0f * PI * obs->settings.bandwidth;
+    float a = 1.0f - expf(-wc * elapsed / US_PER_SECOND);
+    obs->control_filtered += a * (obs->control_prev - offset - obs->control_filtered);
+    obs->rate_filtered += a * (rate_now - obs->rate_filtered);
+
+    // The filtered derivative of the speed is wc * (w - Q * w)
+    float acceleration = wc * (rate_now - obs->rate_filtered);
+    obs->disturbance = obs->control_filtered - (model->time_constant[d] * acceleration + obs->rate_filtered) / model->gain[d];
+    return (int32_t)obs->disturbance;
+}
+
+/**
+Record the duty applied in this period, the input of the next update
+
+:param actuation: Actuation type applied in this period
+:param control: Duty applied in this period (duty steps)
+ */
+void PBIO_IRAM pbio_observer_set_control(pbio_observer_t *obs, pbio_actuation_t actuation, int32_t control) {
+    if (actuation != PBIO_ACTUATION_DUTY) {
+        obs->primed = false;
+        return;
+    }
+    obs->control_prev = control;
+}
+
+/**
+Return the observer settings
+
+:param enabled: Return true if the observer is enabled
+:param bandwidth: Return the cutoff frequency of the estimate (Hz)
+ */
+void pbio_observer_get_settings(const pbio_observer_t *obs, bool *enabled, float *bandwidth) {
+    *enabled = obs->settings.enabled;
+    *bandwidth = obs->settings.bandwidth;
+}
+
+/**
+Set the observer settings
+
+:param enabled: Estimate and cancel the disturbance
+:param bandwidth: Cutoff frequency of the estimate (Hz). Higher values react faster but let more speed noise through
+ */
+pbio_error_t pbio_observer_set_settings(pbio_observer_t *obs, bool enabled, float bandwidth) {
+    if (bandwidth < PBIO_OBSERVER_MIN_BANDWIDTH || bandwidth > PBIO_OBSERVER_MAX_BANDWIDTH) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    obs->settings.enabled = enabled;
+    obs->settings.bandwidth = bandwidth;
+    pbio_observer_reset(obs);
+    return PBIO_SUCCESS;
+}
@@ -1,4 +1,5 @@
 #include "motor_control/servo.hpp"
+#include "motor_control/macros.h"
 
 void pbio_servo_setup(pbio_servo_t *srv, DCMotor *dcmotor, Tacho *tacho, PBIOLogger *logger, float counts_per_unit, pbio_control_settings_t *settings) {
     srv->tacho = tacho;
@@ -13,6 +14,13 @@ void pbio_servo_setup(pbio_servo_t *srv, DCMotor *dcmotor, Tacho *tacho, PBIOLog
 
     // For a servo, counts per output unit is counts per degree at the gear train output
     srv->control.settings.counts_per_unit = counts_per_unit;
+
+    pbio_collision_setup(&srv->collision, &srv->control.settings);
+    pbio_envelope_setup(&srv->envelope);
+    pbio_ilc_setup(&srv->ilc);
+    pbio_observer_setup(&srv->control.observer);
+    pbio_lqr_setup(&srv->control.lqr);
+    pbio_shaper_setup(&srv->control.shaper);
 }
 
 /** 
@@ -49,7 +57,7 @@ void pbio_servo_reset_angle(pbio_servo_t *srv, float reset_angle) {
 
     // Set the new target based on the old angle and the old target, after the angle reset
     float new_target = reset_angle + target_old - angle_old;
-    pbio_servo_track_target(srv, new_target);
+    pbio_servo_track_target(srv, new_target, false, 0);
 }
 
 /**
@@ -59,7 +67,7 @@ Get the physical state of a single motor: current time, speed, and position
 :param count_now: Return position (count)
 :param rate_now: Return speed (count/sec)
  */
-static void servo_get_state(pbio_servo_t *srv, int32_t *time_now, int32_t *count_now, int32_t *rate_now) {
+static void PBIO_IRAM servo_get_state(pbio_servo_t *srv, int32_t *time_now, int32_t *count_now, int32_t *rate_now) {
 
     // Read current state of this motor: current time, speed, and position
     *time_now = monotonic_us();
@@ -73,7 +81,7 @@ Actuate a single motor
 :param actuation_type: Type of actuation: coast, brake, hold or duty
 :param control: Target angle in count when actuation is HOLD or PWM duty steps when actuation is DUTY
  */
-static void pbio_servo_actuate(pbio_servo_t *srv, pbio_actuation_t actuation_type, int32_t control) {
+static void PBIO_IRAM pbio_servo_actuate(pbio_servo_t *srv, pbio_actuation_t actuation_type, int32_t control) {
 
     // Apply the calculated actuation, by type
     switch (actuation_type)
@@ -88,7 +96,8 @@ static void pbio_servo_actuate(pbio_servo_t *srv, pbio_actuation_t actuation_typ
         pbio_control_start_hold_control(&srv->control, monotonic_us(), control);
         break;
     case PBIO_ACTUATION_DUTY:
-        srv->dcmotor->set_duty_cycle(control);
+        // The control is the duty at the nominal supply voltage
+        srv->dcmotor->set_duty_cycle(control, pbio_battery_get_duty_scale());
         break;
     }
 }
@@ -102,7 +111,7 @@ Log motor data for a motor that is being actively controlled
 :param actuation: Current servo actuation (pbio_actuation_t)
 :param control: Current actualtion value (duty steps)
 */
-static pbio_error_t pbio_servo_log_update(pbio_servo_t *srv, int32_t time_now, int32_t count_now, int32_t rate_now, pbio_actuation_t actuation, int32_t control) {
+static pbio_error_t PBIO_IRAM pbio_servo_log_update(pbio_servo_t *srv, int32_t time_now, int32_t count_now, int32_t rate_now, pbio_actuation_t actuation, int32_t control) {
 
     int32_t buf[SERVO_LOG_NUM_VALUES];
     memset(buf, 0, sizeof(buf));
@@ -114,6 +123,8 @@ static pbio_error_t pbio_servo_log_update(pbio_servo_t *srv, int32_t time_now, i
     // Log the applied control signal
     buf[3] = actuation; // (pbio_actuation_t)
     buf[4] = control;   // (duty steps)
+    buf[11] = pbio_battery_get_voltage_now(); // (mV)
+    buf[12] = (int32_t)srv->control.observer.disturbance; // (duty steps)
 
     // If control is active, log additional data about the maneuver
     if (srv->control.type != PBIO_CONTROL_NONE) {
@@ -126,7 +137,7 @@ static pbio_error_t pbio_servo_log_update(pbio_servo_t *srv, int32_t time_now, i
 
         // Log reference signals. These values are only meaningful for time based commands
         int32_t count_ref, count_ref_ext, rate_ref, err, err_integral, acceleration_ref;
-        pbio_trajectory_get_reference(&srv->control.trajectory, time_ref, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
+        pbio_control_get_reference(&srv->control, time_ref, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
 
         if (srv->control.type == PBIO_CONTROL_ANGLE) {
             pbio_count_integrator_get_errors(&srv->control.count_integrator, count_now, count_ref, &err, &err_integral);
@@ -144,10 +155,58 @@ static pbio_error_t pbio_servo_log_update(pbio_servo_t *srv, int32_t time_now, i
     return srv->log->update(buf);
 }
 
+/**
+Record the tracking error of a learning iteration and get the learned correction
+
+Ends the iteration when the maneuver is no longer under angle control
+
+:param time_now: Current time(us)
+:param count_now: Current position (count)
+:param rate_now: Current speed (count/sec)
+:return: Duty to add to the control (duty steps)
+ */
+static int32_t PBIO_IRAM pbio_servo_ilc_update(pbio_servo_t *srv, int32_t time_now, int32_t count_now, int32_t rate_now) {
+    if (!srv->ilc.recording) {
+        return 0;
+    }
+    if (srv->control.type != PBIO_CONTROL_ANGLE) {
+        return pbio_ilc_update(&srv->ilc, false, 0, 0, 0, 0);
+    }
+
+    int32_t time_ref = pbio_control_get_ref_time(&srv->control, time_now);
+    int32_t count_ref, count_ref_ext, rate_ref, acceleration_ref;
+    pbio_control_get_reference(&srv->control, time_ref, &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
+    return pbio_ilc_update(&srv->ilc, true, srv->control.trajectory.t0, time_ref, count_ref - count_now, rate_ref - rate_now);
+}
+
+/**
+Replace the maneuver with a trajectory that brakes at the acceleration limit and holds on a software limit
+
+The braking trajectory starts from the physical state, as the braking distance was checked on it.
+Patched to the maneuver in progress, a shaped reference would keep following the replaced trajectory
+with its delayed impulses, past the limit. Without the previous trajectory, the shaped reference stays
+between the current position and the limit.
+
+Not placed in IRAM: it runs only on a violation, and the angle control start it calls is in flash.
+
+:param time_now: Current time(us)
+:param count_now: Current position (count)
+:param rate_now: Current speed (count/sec)
+:param count_limit: Limit to stop on (count)
+ */
+static void servo_envelope_brake(pbio_servo_t *srv, int32_t time_now, int32_t count_now, int32_t rate_now, int32_t count_limit) {
+    int32_t acceleration = pbio_control_settings_get_abs_acceleration(&srv->control.settings, rate_now);
+    pbio_control_stop(&srv->control);
+    pbio_error_t err = pbio_control_start_angle_control(&srv->control, time_now, count_now, count_limit, rate_now, abs(rate_now), acceleration, PBIO_ACTUATION_HOLD);
+    if (err != PBIO_SUCCESS) {
+        pbio_servo_stop(srv, PBIO_ACTUATION_BRAKE);
+    }
+}
+
 /**
 Loop function that control and actuate the motor
  */
-pbio_error_t pbio_servo_control_update(pbio_servo_t *srv) {
+pbio_error_t PBIO_IRAM pbio_servo_control_update(pbio_servo_t *srv) {
 
     // Read the physical state
     int32_t time_now;
@@ -157,10 +216,19 @@ pbio_error_t pbio_servo_control_update(pbio_servo_t *srv) {
     if (srv->tacho->isSequenceError())
         return PBIO_ERROR_TACHO_SEQUENCE;
 
+    // Start braking when the motor wouldn't stop within the software limits anymore
+    int32_t count_limit;
+    if (pbio_envelope_update(&srv->envelope, &srv->control, count_now, rate_now, &count_limit)) {
+        servo_envelope_brake(srv, time_now, count_now, rate_now, count_limit);
+    }
+
     // Control action to be calculated
     pbio_actuation_t actuation;
     int32_t control;
 
+    // Learned correction of the repeated maneuver, evaluated on the trajectory before the control can end it
+    int32_t correction = pbio_servo_ilc_update(srv, time_now, count_now, rate_now);
+
     // Do not service a passive motor
     if (srv->control.type == PBIO_CONTROL_NONE) {
         // No control, but still log state data
@@ -178,17 +246,33 @@ pbio_error_t pbio_servo_control_update(pbio_servo_t *srv) {
                 actuation = PBIO_ACTUATION_DUTY;
                 break;
         };
-        return pbio_servo_log_update(srv, time_now, count_now, rate_now, actuation, control);
+        PBIO_RETURN_ON_ERROR(pbio_servo_log_update(srv, time_now, count_now, rate_now, actuation, control));
+        return srv->collision.detected ? PBIO_ERROR_COLLISION : PBIO_SUCCESS;
     }
 
     // Calculate control signal
     control_update(&srv->control, time_now, count_now, rate_now, &actuation, &control);
+    if (correction != 0 && actuation == PBIO_ACTUATION_DUTY) {
+        int32_t max_control = srv->control.settings.max_control;
+        control = PIO_MAX(-max_control, PIO_MIN(control + correction, max_control));
+    }
 
     // Apply the control type and signal
     pbio_servo_actuate(srv, actuation, control);
+    pbio_observer_set_control(&srv->control.observer, actuation, control);
+
+    // Stop right away if something is blocking the motor. Running until stalled the
+    // obstruction is the expected end of the maneuver, so it's left to the stall detection
+    pbio_actuation_t checked_actuation = srv->control.on_target_type == PBIO_CONTROL_ON_TARGET_STALLED ? PBIO_ACTUATION_COAST : actuation;
+    if (pbio_collision_update(&srv->collision, &srv->control.settings, time_now, rate_now, checked_actuation, control)) {
+        pbio_servo_stop(srv, srv->collision.settings.reaction);
+    }
 
     // Log data if logger enabled
-    return pbio_servo_log_update(srv, time_now, count_now, rate_now, actuation, control);
+    PBIO_RETURN_ON_ERROR(pbio_servo_log_update(srv, time_now, count_now, rate_now, actuation, control));
+
+    // Keep reporting the obstruction until the next maneuver
+    return srv->collision.detected ? PBIO_ERROR_COLLISION : PBIO_SUCCESS;
 }
 
 /**
@@ -198,9 +282,10 @@ pbio_error_t pbio_servo_control_update(pbio_servo_t *srv) {
  */
 void pbio_servo_set_duty_cycle(pbio_servo_t *srv, float duty_steps) {
     pbio_control_stop(&srv->control);
+    pbio_collision_reset(&srv->collision);
 
     int32_t control = (int32_t)(duty_steps * srv->dcmotor->getUserPwmMax() / 100.0);
-    srv->dcmotor->set_duty_cycle(control);
+    srv->dcmotor->set_duty_cycle(control, pbio_battery_get_duty_scale());
 }
 
 /**
@@ -226,6 +311,18 @@ void pbio_servo_stop(pbio_servo_t *srv, pbio_actuation_t after_stop) {
     pbio_servo_actuate(srv, after_stop, control);
 }
 
+/**
+Stops the motor because something is blocking it
+
+The obstruction is latched and reported by pbio_servo_control_update until the next maneuver.
+
+:param residual: Speed residual that flagged the obstruction (count/s)
+ */
+void pbio_servo_collision_stop(pbio_servo_t *srv, int32_t residual) {
+    pbio_collision_flag(&srv->collision, residual);
+    pbio_servo_stop(srv, srv->collision.settings.reaction);
+}
+
 /**
 Runs the motor at a constant speed.
 
@@ -234,6 +331,8 @@ The motor accelerates to the given speed and keeps running at this speed until y
 :param speed: Speed of the motor in deg/s
  */
 pbio_error_t pbio_servo_run(pbio_servo_t *srv, float speed) {
+    pbio_collision_reset(&srv->collision);
+
     // Get target rate in unit of counts
     int32_t target_rate = pbio_control_user_to_counts(&srv->control.settings, speed);
 
@@ -253,7 +352,7 @@ pbio_error_t pbio_servo_run(pbio_servo_t *srv, float speed) {
     }
 
     // Start a timed maneuver, duration forever
-    return pbio_control_start_timed_control(&srv->control, time_now, DURATION_FOREVER, count_now, rate_now, target_rate, srv->control.settings.abs_acceleration, pbio_control_on_target_never, PBIO_ACTUATION_COAST);
+    return pbio_control_start_timed_control(&srv->control, time_now, DURATION_FOREVER, count_now, rate_now, target_rate, pbio_control_settings_get_abs_acceleration(&srv->control.settings, target_rate), PBIO_CONTROL_ON_TARGET_NEVER, PBIO_ACTUATION_COAST);
 }
 
 /**
@@ -266,6 +365,8 @@ The motor accelerates to the given speed, keeps running at this speed, and then
 :param after_stop: What to do after coming to a standstill
  */
 pbio_error_t pbio_servo_run_time(pbio_servo_t *srv, float speed, int32_t duration, pbio_actuation_t after_stop) {
+    pbio_collision_reset(&srv->collision);
+
     // Get target rate in unit of counts
     int32_t target_rate = pbio_control_user_to_counts(&srv->control.settings, speed);
 
@@ -274,7 +375,7 @@ pbio_error_t pbio_servo_run_time(pbio_servo_t *srv, float speed, int32_t duratio
     servo_get_state(srv, &time_now, &count_now, &rate_now);
 
     // Start a timed maneuver, duration finite
-    return pbio_control_start_timed_control(&srv->control, time_now, duration*US_PER_MS, count_now, rate_now, target_rate, srv->control.settings.abs_acceleration, pbio_control_on_target_time, after_stop);
+    return pbio_control_start_timed_control(&srv->control, time_now, duration*US_PER_MS, count_now, rate_now, target_rate, pbio_control_settings_get_abs_acceleration(&srv->control.settings, target_rate), PBIO_CONTROL_ON_TARGET_TIME, after_stop);
 }
 
 /**
@@ -284,6 +385,8 @@ Runs the motor at a constant speed until it stalls
 :param after_stop: What to do after coming to a standstill
  */
 pbio_error_t pbio_servo_run_until_stalled(pbio_servo_t *srv, float speed, pbio_actuation_t after_stop) {
+    pbio_collision_reset(&srv->collision);
+
     // Get target rate in unit of counts
     int32_t target_rate = pbio_control_user_to_counts(&srv->control.settings, speed);
 
@@ -292,7 +395,7 @@ pbio_error_t pbio_servo_run_until_stalled(pbio_servo_t *srv, float speed, pbio_a
     servo_get_state(srv, &time_now, &count_now, &rate_now);
 
     // Start a timed maneuver, duration forever and ending on stall
-    return pbio_control_start_timed_control(&srv->control, time_now, DURATION_FOREVER, count_now, rate_now, target_rate, srv->control.settings.abs_acceleration, pbio_control_on_target_stalled, after_stop);
+    return pbio_control_start_timed_control(&srv->control, time_now, DURATION_FOREVER, count_now, rate_now, target_rate, pbio_control_settings_get_abs_acceleration(&srv->control.settings, target_rate), PBIO_CONTROL_ON_TARGET_STALLED, after_stop);
 }
 
 /**
@@ -303,9 +406,12 @@ if speed is positive or negative.
 
 :param speed: Speed of the motor in deg/s
 :param target: Angle that the motor should rotate to in deg
+:param acceleration: Acceleration/deceleration in deg/s^2, capped by the acceleration limit. Zero to use the limit
 :param after_stop: What to do after coming to a standstill
  */
-pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, float speed, float target, pbio_actuation_t after_stop) {
+pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, float speed, float target, float acceleration, pbio_actuation_t after_stop) {
+    pbio_collision_reset(&srv->collision);
+
     // Get targets in unit of counts
     int32_t target_rate = pbio_control_user_to_counts(&srv->control.settings, speed);
     int32_t target_count = pbio_control_user_to_counts(&srv->control.settings, target);
@@ -314,7 +420,73 @@ pbio_error_t pbio_servo_run_target(pbio_servo_t *srv, float speed, float target,
     int32_t time_now, count_now, rate_now;
     servo_get_state(srv, &time_now, &count_now, &rate_now);
 
-    return pbio_control_start_angle_control(&srv->control, time_now, count_now, target_count, rate_now, target_rate, srv->control.settings.abs_acceleration, after_stop);
+    int32_t abs_acceleration = pbio_control_settings_get_abs_acceleration(&srv->control.settings, target_count - count_now);
+    if (acceleration > 0.0f) {
+        abs_acceleration = PIO_MIN(pbio_control_user_to_counts(&srv->control.settings, acceleration), abs_acceleration);
+    }
+    PBIO_RETURN_ON_ERROR(pbio_control_start_angle_control(&srv->control, time_now, count_now, target_count, rate_now, target_rate, abs_acceleration, after_stop));
+
+    // Make this maneuver an iteration of the learning, if requested
+    if (srv->ilc.armed) {
+        pbio_ilc_key_t key = { srv->control.trajectory.th0, target_count, target_rate, abs_acceleration,
+                               srv->control.shaper.settings, srv->control.settings.gain_scheduling };
+        pbio_ilc_start(&srv->ilc, &srv->control.settings, srv->control.trajectory.t0, srv->control.trajectory.t3 - srv->control.trajectory.t0, &key);
+    }
+    return PBIO_SUCCESS;
+}
+
+/**
+Return the duration of a run_target maneuver started now from standstill
+
+:param speed: Speed of the motor in deg/s
+:param target: Angle that the motor should rotate to in deg
+:param duration: Return the maneuver duration (us)
+ */
+pbio_error_t pbio_servo_get_target_duration(pbio_servo_t *srv, float speed, float target, int32_t *duration) {
+    int32_t target_rate = pbio_control_user_to_counts(&srv->control.settings, speed);
+    int32_t target_count = pbio_control_user_to_counts(&srv->control.settings, target);
+    int32_t count_now = srv->tacho->getCount();
+    int32_t acceleration = pbio_control_settings_get_abs_acceleration(&srv->control.settings, target_count - count_now);
+
+    pbio_trajectory_t trajectory;
+    PBIO_RETURN_ON_ERROR(pbio_trajectory_make_angle_based(&trajectory, 0, count_now, target_count, 0, target_rate, srv->control.settings.max_rate, acceleration, acceleration));
+
+    *duration = trajectory.t3 - trajectory.t0;
+    return PBIO_SUCCESS;
+}
+
+/**
+Runs the motor towards a target angle, slowed down in time to finish together with other motors
+
+Speed and acceleration are limited as in pbio_servo_run_target and then scaled by time_scale and time_scale^2,
+so the maneuver keeps its shape and lasts 1/time_scale as long.
+
+:param time_start: Start time of the maneuver, shared with the other motors (us)
+:param speed: Speed of the motor in deg/s
+:param target: Angle that the motor should rotate to in deg
+:param time_scale: Ratio between the unscaled and the wanted duration of the maneuver (0 to 1)
+:param after_stop: What to do after coming to a standstill
+ */
+pbio_error_t pbio_servo_run_target_scaled(pbio_servo_t *srv, int32_t time_start, float speed, float target, float time_scale, pbio_actuation_t after_stop) {
+    // A rejected command leaves the maneuver in progress untouched
+    if (time_scale <= 0.0f || time_scale > 1.0f) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    pbio_collision_reset(&srv->collision);
+
+    int32_t target_rate = pbio_control_user_to_counts(&srv->control.settings, speed);
+    int32_t target_count = pbio_control_user_to_counts(&srv->control.settings, target);
+    int32_t count_now = srv->tacho->getCount();
+    int32_t rate_now = srv->tacho->getRate();
+    int32_t acceleration = pbio_control_settings_get_abs_acceleration(&srv->control.settings, target_count - count_now);
+
+    // Scale the limited speed and acceleration, at least one count per second (squared)
+    target_rate = PIO_MIN(abs(target_rate), srv->control.settings.max_rate);
+    target_rate = PIO_MAX((int32_t)(target_rate * time_scale), 1);
+    acceleration = PIO_MAX((int32_t)(acceleration * time_scale * time_scale), 1);
+
+    return pbio_control_start_angle_control(&srv->control, time_start, count_now, target_count, rate_now, target_rate, acceleration, after_stop);
 }
 
 /**
@@ -325,6 +497,8 @@ Runs the motor at a constant speed by a given angle (relative)
 :param after_stop: What to do after coming to a standstill
 */
 pbio_error_t pbio_servo_run_angle(pbio_servo_t *srv, float speed, float angle, pbio_actuation_t after_stop) {
+    pbio_collision_reset(&srv->collision);
+
     // Get targets in unit of counts
     int32_t target_rate = pbio_control_user_to_counts(&srv->control.settings, speed);
     int32_t relative_target_count = pbio_control_user_to_counts(&srv->control.settings, angle);
@@ -334,22 +508,38 @@ pbio_error_t pbio_servo_run_angle(pbio_servo_t *srv, float speed, float angle, p
     servo_get_state(srv, &time_now, &count_now, &rate_now);
 
     // Start the relative angle control
-    return pbio_control_start_relative_angle_control(&srv->control, time_now, count_now, relative_target_count, rate_now, target_rate, srv->control.settings.abs_acceleration, after_stop);
+    return pbio_control_start_relative_angle_control(&srv->control, time_now, count_now, relative_target_count, rate_now, target_rate, pbio_control_settings_get_abs_acceleration(&srv->control.settings, pbio_math_sign(target_rate)*relative_target_count), after_stop);
 }
 
 /**
 Tracks a target angle
 
-This is similar to run_target(), but the usual smooth acceleration is skipped: it will move 
-to the target angle as fast as possible. This method is useful if you want to continuously 
-change the target angle
+This is similar to run_target(), but without a planned trajectory. With smoothing, the reference
+follows the target through a speed and acceleration limited filter, so a target changed often, e.g.
+by jogging, gives a smooth motion. Without it, the reference steps to the target and the motor
+moves there as fast as possible. This method is useful if you want to continuously change the
+target angle
 
-:param target: Angle that the motor should rotate to in deg
+:param target: Angle that the motor should rotate to in deg, brought within the software limits when they are enforced
+:param smooth: Filter the reference towards the target
+:param direction: Direction of motion of the axis the target follows, selects the gains and the feedforward without smoothing
 */
-void pbio_servo_track_target(pbio_servo_t *srv, float target) {
+void pbio_servo_track_target(pbio_servo_t *srv, float target, bool smooth, int8_t direction) {
     // Get the intitial state, either based on physical motor state or ongoing maneuver
-    int32_t time_start = monotonic_us();
-    int32_t target_count = pbio_control_user_to_counts(&srv->control.settings, target);
+    int32_t time_start, count_now, rate_now;
+    servo_get_state(srv, &time_start, &count_now, &rate_now);
+    int32_t target_count = pbio_envelope_clamp(&srv->envelope, pbio_control_user_to_counts(&srv->control.settings, target));
+
+    // Tracking from a passive state is a new maneuver
+    if (srv->control.type == PBIO_CONTROL_NONE) {
+        pbio_collision_reset(&srv->collision);
+    }
 
-    pbio_control_start_hold_control(&srv->control, time_start, target_count);
+    if (smooth) {
+        pbio_control_start_track_control(&srv->control, time_start, count_now, rate_now, target_count);
+    }
+    else {
+        pbio_control_start_hold_control(&srv->control, time_start, target_count);
+        srv->control.lead_direction = direction;
+    }
 }
\ No newline at end of file
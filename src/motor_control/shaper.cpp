@@ -0,0 +1,163 @@
+#include "motor_control/shaper.hpp"
+#include "motor_control/macros.h"
+#include "motor_control/const.h"
+#include "config.h"
+
+/**
+Compute the impulse sequence from the settings
+ */
+static void shaper_update_impulses(pbio_shaper_t *shaper) {
+    if (shaper->settings.type == PBIO_SHAPER_NONE) {
+        shaper->impulses = 0;
+        return;
+    }
+
+    float zeta = shaper->settings.damping;
+    float root = sqrtf(1.0f - zeta * zeta);
+    float K = expf(-zeta * PI / root);
+    float half_period = 0.5f / (shaper->settings.frequency * root);
+
+    float amplitude[PBIO_SHAPER_MAX_IMPULSES];
+    if (shaper->settings.type == PBIO_SHAPER_ZV) {
+        shaper->impulses = 2;
+        amplitude[0] = 1.0f / (1.0f + K);
+        amplitude[1] = K / (1.0f + K);
+    }
+    else {
+        shaper->impulses = 3;
+        float norm = (1.0f + K) * (1.0f + K);
+        amplitude[0] = 1.0f / norm;
+        amplitude[1] = 2.0f * K / norm;
+        amplitude[2] = K * K / norm;
+    }
+
+    // The first impulse takes the round off, so the amplitudes add up to one exactly
+    int32_t sum = 0;
+    for (uint8_t i = 0; i < shaper->impulses; i++) {
+        shaper->delay[i] = (int32_t)(i * half_period * US_PER_SECOND);
+        shaper->amplitude[i] = (int32_t)roundf(amplitude[i] * (1 << PBIO_SHAPER_AMPLITUDE_SHIFT));
+        if (i > 0) {
+            sum += shaper->amplitude[i];
+        }
+    }
+    shaper->amplitude[0] = (1 << PBIO_SHAPER_AMPLITUDE_SHIFT) - sum;
+}
+
+/**
+Initialize the shaper, not shaping, with the default tuning
+ */
+void pbio_shaper_setup(pbio_shaper_t *shaper) {
+    memset(shaper, 0, sizeof(pbio_shaper_t));
+    shaper->settings.type = PBIO_SHAPER_NONE;
+    shaper->settings.frequency = PBIO_SHAPER_DEFAULT_FREQUENCY;
+    shaper->settings.damping = PBIO_SHAPER_DEFAULT_DAMPING;
+    shaper_update_impulses(shaper);
+}
+
+/**
+Forget the previous trajectory, when a move starts from the physical state
+ */
+void pbio_shaper_reset(pbio_shaper_t *shaper) {
+    shaper->has_previous = false;
+}
+
+/**
+Keep the trajectory about to be replaced by a new command, for the delayed impulses
+
+:param previous: Trajectory in use until now
+:param time_ref: Reference time at which the new trajectory takes over (us)
+ */
+void pbio_shaper_replace(pbio_shaper_t *shaper, const pbio_trajectory_t *previous, int32_t time_ref) {
+    if (shaper->impulses == 0) {
+        shaper->has_previous = false;
+        return;
+    }
+    shaper->previous = *previous;
+    shaper->time_switch = time_ref;
+    shaper->has_previous = true;
+}
+
+/**
+Evaluate the shaped reference
+
+The impulses are evaluated from the most delayed to the undelayed one, so the rebase of the
+trajectory done by the last evaluation can't affect the others. A trajectory is held at its
+start before its start time.
+
+:param trajectory: Trajectory in use
+:param time_ref: Time of reference evaluation (us)
+:param count_ref: Return the shaped position (count)
+:param count_ref_ext: Return the shaped position decimals (millicount)
+:param rate_ref: Return the shaped speed (count/s)
+:param acceleration_ref: Return the shaped acceleration (count/s^2)
+ */
+void PBIO_IRAM pbio_shaper_get_reference(pbio_shaper_t *shaper, pbio_trajectory_t *trajectory, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref) {
+    if (shaper->impulses == 0) {
+        pbio_trajectory_get_reference(trajectory, time_ref, count_ref, count_ref_ext, rate_ref, acceleration_ref);
+        return;
+    }
+
+    // The previous trajectory is no longer reached by the most delayed impulse
+    if (shaper->has_previous && time_ref - shaper->time_switch >= pbio_shaper_get_duration(shaper)) {
+        shaper->has_previous = false;
+    }
+
+    int64_t mcount = 0;
+    int64_t rate = 0;
+    int64_t acceleration = 0;
+    for (int8_t i = shaper->impulses - 1; i >= 0; i--) {
+        int32_t time = time_ref - shaper->delay[i];
+        pbio_trajectory_t *source = shaper->has_previous && time - shaper->time_switch < 0 ? &shaper->previous : trajectory;
+        if (time - source->t0 < 0) {
+            time = source->t0;
+        }
+
+        int32_t count_i, count_ext_i, rate_i, acceleration_i;
+        pbio_trajectory_get_reference(source, time, &count_i, &count_ext_i, &rate_i, &acceleration_i);
+        int32_t amplitude = shaper->amplitude[i];
+        mcount += amplitude * (((int64_t)count_i) * 1000 + count_ext_i);
+        rate += (int64_t)amplitude * rate_i;
+        acceleration += (int64_t)amplitude * acceleration_i;
+    }
+
+    mcount >>= PBIO_SHAPER_AMPLITUDE_SHIFT;
+    *count_ref = (int32_t)(mcount / 1000);
+    *count_ref_ext = (int32_t)(mcount - ((int64_t)*count_ref) * 1000);
+    *rate_ref = (int32_t)(rate >> PBIO_SHAPER_AMPLITUDE_SHIFT);
+    *acceleration_ref = (int32_t)(acceleration >> PBIO_SHAPER_AMPLITUDE_SHIFT);
+}
+
+/**
+Return the shaper settings
+
+:param type: Return the impulse sequence
+:param frequency: Return the frequency of the vibration to suppress (Hz)
+:param damping: Return the damping ratio of the vibration to suppress
+ */
+void pbio_shaper_get_settings(const pbio_shaper_t *shaper, pbio_shaper_type_t *type, float *frequency, float *damping) {
+    *type = shaper->settings.type;
+    *frequency = shaper->settings.frequency;
+    *damping = shaper->settings.damping;
+}
+
+/**
+Set the shaper settings. Change them while standing still, a change during a move makes the reference jump
+
+:param type: Impulse sequence
+:param frequency: Frequency of the vibration to suppress (Hz)
+:param damping: Damping ratio of the vibration to suppress (0 to 0.9)
+ */
+pbio_error_t pbio_shaper_set_settings(pbio_shaper_t *shaper, pbio_shaper_type_t type, float frequency, float damping) {
+    if (type > PBIO_SHAPER_ZVD ||
+        frequency < PBIO_SHAPER_MIN_FREQUENCY || frequency > PBIO_SHAPER_MAX_FREQUENCY ||
+        damping < 0.0f || damping > PBIO_SHAPER_MAX_DAMPING) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    shaper->settings.type = type;
+    shaper->settings.frequency = frequency;
+    shaper->settings.damping = damping;
+    shaper_update_impulses(shaper);
+    shaper->has_previous = false;
+    return PBIO_SUCCESS;
+}
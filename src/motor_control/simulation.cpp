@@ -0,0 +1,170 @@
+#include "motor_control/simulation.hpp"
+#include "motor_control/const.h"
+#include "motor_control/macros.h"
+#include "config.h"
+#include "esp_cpu.h"
+
+#define SIMULATION_TICK_US (PBIO_CONFIG_SERVO_PERIOD_MS * US_PER_MS)
+
+/**
+Advance the identified model by one control period, with the duty held over the period
+
+The speed follows the first order response to the duty net of gravity and Coulomb friction. While
+standing still the motor doesn't move until the duty overcomes the friction.
+
+:param model: Identified plant model
+:param control: Duty applied over the period (duty steps)
+:param count: Position, updated (count)
+:param rate: Speed, updated (count/s)
+ */
+static void simulation_step(const pbio_control_model_t *model, int32_t control, float *count, float *rate) {
+    float drive = control - model->gravity;
+    int8_t direction = *rate > 0 ? 1 : (*rate < 0 ? -1 : (drive > 0 ? 1 : -1));
+    bool sticking = fabsf(drive) <= model->coulomb;
+    if (*rate == 0.0f && sticking) {
+        return;
+    }
+
+    uint8_t d = direction > 0 ? 0 : 1;
+    float rate_ss = model->gain[d] * (drive - direction * model->coulomb);
+    float T = SIMULATION_TICK_US / (float)US_PER_SECOND;
+    float tau = model->time_constant[d];
+    float a = expf(-T / tau);
+    float rate_next = a * *rate + (1.0f - a) * rate_ss;
+
+    // Friction stops the motor when the speed crosses zero
+    if (sticking && rate_next * direction < 0) {
+        rate_next = 0.0f;
+    }
+    *count += rate_ss * T + tau * (1.0f - a) * (*rate - rate_ss);
+    *rate = rate_next;
+}
+
+/**
+Simulate a run_target maneuver from standstill with the control laws of the given controller, on
+its identified model, and measure the cost of the control updates
+
+:param ctl: Scratch copy of a controller, with the settings and the control law to simulate. Its state is overwritten
+:param count_start: Start position (count)
+:param count_target: Target position (count)
+:param target_rate: Cruise speed (count/s)
+:param result: Return the outcome of the maneuver
+:return: PBIO_ERROR_INVALID_OP if the model is not identified, PBIO_ERROR_INVALID_ARG if the maneuver is too long
+ */
+pbio_error_t pbio_simulation_run_target(pbio_control_t *ctl, int32_t count_start, int32_t count_target, int32_t target_rate, pbio_simulation_result_t *result) {
+    if (!pbio_control_settings_has_model(&ctl->settings)) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    pbio_control_stop(ctl);
+    pbio_observer_reset(&ctl->observer);
+    ctl->gains_direction = 0;
+
+    int32_t time_now = SIMULATION_TICK_US;
+    int32_t acceleration = pbio_control_settings_get_abs_acceleration(&ctl->settings, count_target - count_start);
+    PBIO_RETURN_ON_ERROR(pbio_control_start_angle_control(ctl, time_now, count_start, count_target, 0, target_rate, acceleration, PBIO_ACTUATION_HOLD));
+
+    int32_t t0 = ctl->trajectory.t0;
+    int32_t duration = ctl->trajectory.t3 - t0;
+    if (duration > PBIO_SIMULATION_MAX_MS * US_PER_MS) {
+        pbio_control_stop(ctl);
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    int8_t sign = count_target >= count_start ? 1 : -1;
+    int32_t time_end = t0 + duration + pbio_shaper_get_duration(&ctl->shaper) + PBIO_SIMULATION_TAIL_MS * US_PER_MS;
+    float count = count_start;
+    float rate = 0.0f;
+    float sum = 0.0f;
+    uint64_t cycles = 0;
+    uint32_t ticks = 0;
+    result->settle_time = -1;
+    result->overshoot = 0;
+
+    for (; time_now <= time_end; time_now += SIMULATION_TICK_US) {
+        int32_t count_now = (int32_t)lroundf(count);
+        int32_t rate_now = (int32_t)rate;
+
+        pbio_actuation_t actuation;
+        int32_t control;
+        esp_cpu_cycle_count_t start = esp_cpu_get_cycle_count();
+        control_update(ctl, time_now, count_now, rate_now, &actuation, &control);
+        cycles += esp_cpu_get_cycle_count() - start;
+        ticks++;
+
+        if (actuation != PBIO_ACTUATION_DUTY) {
+            control = 0;
+        }
+        pbio_observer_set_control(&ctl->observer, actuation, control);
+
+        // Tracking error against the reference the control is following
+        int32_t count_ref, count_ref_ext, rate_ref, acceleration_ref;
+        pbio_control_get_reference(ctl, pbio_control_get_ref_time(ctl, time_now), &count_ref, &count_ref_ext, &rate_ref, &acceleration_ref);
+        float err = count_ref - count_now;
+        sum += err * err;
+
+        result->overshoot = PIO_MAX(result->overshoot, sign * (count_now - count_target));
+        if (abs(count_target - count_now) > ctl->settings.count_tolerance) {
+            result->settle_time = -1;
+        }
+        else if (result->settle_time < 0) {
+            result->settle_time = time_now - t0;
+        }
+
+        simulation_step(&ctl->settings.model, control, &count, &rate);
+    }
+
+    pbio_control_stop(ctl);
+    result->rms = sqrtf(sum / ticks);
+    result->cycles = (uint32_t)(cycles / ticks);
+    return PBIO_SUCCESS;
+}
+
+/**
+Plan a run_target maneuver from standstill without running it, and sample its reference, as the
+control would follow it, shaper included
+
+:param ctl: Scratch copy of a controller, with the settings to plan with. Its state is overwritten
+:param count_start: Start position (count)
+:param count_target: Target position (count)
+:param target_rate: Cruise speed (count/s)
+:param acceleration: Acceleration/deceleration (count/s^2), capped by the acceleration limit. Zero to use the limit
+:param max_samples: Samples to take, evenly spaced from the start to the end of the reference, at most one per control period
+:param samples: Return the samples
+:param num_samples: Return the number of samples taken
+:return: PBIO_ERROR_INVALID_ARG if the maneuver can't be planned or is too long
+ */
+pbio_error_t pbio_simulation_preview_target(pbio_control_t *ctl, int32_t count_start, int32_t count_target, int32_t target_rate, int32_t acceleration, uint16_t max_samples, pbio_simulation_sample_t *samples, uint16_t *num_samples) {
+    *num_samples = 0;
+    if (max_samples < 2) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    // Same acceleration as pbio_servo_run_target
+    int32_t abs_acceleration = pbio_control_settings_get_abs_acceleration(&ctl->settings, count_target - count_start);
+    if (acceleration > 0) {
+        abs_acceleration = PIO_MIN(acceleration, abs_acceleration);
+    }
+
+    pbio_control_stop(ctl);
+    int32_t time_start = SIMULATION_TICK_US;
+    PBIO_RETURN_ON_ERROR(pbio_control_start_angle_control(ctl, time_start, count_start, count_target, 0, target_rate, abs_acceleration, PBIO_ACTUATION_HOLD));
+
+    int32_t duration = ctl->trajectory.t3 - ctl->trajectory.t0 + pbio_shaper_get_duration(&ctl->shaper);
+    if (duration > DURATION_MAX_S * US_PER_SECOND) {
+        pbio_control_stop(ctl);
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    uint16_t n = (uint16_t)PIO_MIN((int32_t)max_samples, duration / SIMULATION_TICK_US + 1);
+    n = PIO_MAX(n, 2);
+    for (uint16_t i = 0; i < n; i++) {
+        pbio_simulation_sample_t *sample = &samples[i];
+        sample->time = (int32_t)((int64_t)duration * i / (n - 1));
+        pbio_control_get_reference(ctl, ctl->trajectory.t0 + sample->time, &sample->count, &sample->count_ext, &sample->rate, &sample->acceleration);
+    }
+
+    pbio_control_stop(ctl);
+    *num_samples = n;
+    return PBIO_SUCCESS;
+}
@@ -0,0 +1,142 @@
+#include "motor_control/spectrum.hpp"
+#include "motor_control/const.h"
+#include "esp_heap_caps.h"
+#include "esp_dsp.h"
+
+static bool fft_initialized = false;
+
+/**
+Insert a peak in the list sorted by decreasing amplitude, dropping the smallest one when full
+ */
+static void spectrum_insert_peak(pbio_spectrum_t *spectrum, uint8_t max_peaks, float frequency, float amplitude) {
+    uint8_t pos = spectrum->num_peaks;
+    while (pos > 0 && spectrum->peaks[pos - 1].amplitude < amplitude) {
+        pos--;
+    }
+    if (pos >= max_peaks) {
+        return;
+    }
+
+    uint8_t last = spectrum->num_peaks < max_peaks ? spectrum->num_peaks : max_peaks - 1;
+    for (uint8_t i = last; i > pos; i--) {
+        spectrum->peaks[i] = spectrum->peaks[i - 1];
+    }
+    spectrum->peaks[pos].frequency = frequency;
+    spectrum->peaks[pos].amplitude = amplitude;
+    if (spectrum->num_peaks < max_peaks) {
+        spectrum->num_peaks++;
+    }
+}
+
+/**
+Compute the amplitude spectrum of a logger column and find its dominant frequencies
+
+The FFT length is the largest power of two that fits in the log from the start row. The
+column mean is removed and a Hann window is applied before the FFT. The sample rate is
+derived from the log time column, so the sample division of the log is accounted for.
+
+:param log: Logger with the captured data
+:param col: Logger column to analyze
+:param start_row: First log row to analyze
+:param max_peaks: Maximum number of peaks to return
+:param spectrum: Return the sample rate, resolution and the found peaks
+ */
+pbio_error_t pbio_spectrum_analyze(PBIOLogger *log, uint8_t col, uint32_t start_row, uint8_t max_peaks, pbio_spectrum_t *spectrum) {
+    if (col >= log->cols() || max_peaks == 0 || max_peaks > PBIO_SPECTRUM_MAX_PEAKS) {
+        return PBIO_ERROR_INVALID_ARG;
+    }
+
+    uint32_t rows = log->rows();
+    if (start_row >= rows || rows - start_row < PBIO_SPECTRUM_MIN_LEN) {
+        return PBIO_ERROR_INVALID_OP;
+    }
+
+    uint32_t len = PBIO_SPECTRUM_MAX_LEN;
+    while (len > rows - start_row) {
+        len >>= 1;
+    }
+
+    if (!fft_initialized) {
+        if (dsps_fft2r_init_fc32(NULL, PBIO_SPECTRUM_MAX_LEN) != ESP_OK) {
+            return PBIO_ERROR_FAILED;
+        }
+        fft_initialized = true;
+    }
+
+    // The SIMD kernels need 16 byte aligned buffers in internal RAM
+    float *signal = (float *)heap_caps_aligned_alloc(16, len * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    float *window = (float *)heap_caps_aligned_alloc(16, len * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    float *data = (float *)heap_caps_aligned_alloc(16, 2 * len * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!signal || !window || !data) {
+        heap_caps_free(signal);
+        heap_caps_free(window);
+        heap_caps_free(data);
+        return PBIO_ERROR_FAILED;
+    }
+
+    // Read the column and the sample times
+    int32_t row[PBIO_MAX_LOG_VALUES + PBIO_NUM_DEFAULT_LOG_VALUES];
+    int32_t time_start = 0;
+    int32_t time_end = 0;
+    float mean = 0.0f;
+    for (uint32_t i = 0; i < len; i++) {
+        if (log->read(start_row + i, row) != PBIO_SUCCESS) {
+            heap_caps_free(signal);
+            heap_caps_free(window);
+            heap_caps_free(data);
+            return PBIO_ERROR_FAILED;
+        }
+        if (i == 0) {
+            time_start = row[0];
+        }
+        time_end = row[0];
+        signal[i] = (float)row[col];
+        mean += signal[i];
+    }
+    mean /= len;
+
+    // Remove the mean and apply the window on the real part of the FFT input
+    dsps_wind_hann_f32(window, len);
+    dsps_addc_f32(signal, signal, len, -mean, 1, 1);
+    memset(data, 0, 2 * len * sizeof(float));
+    dsps_mul_f32(signal, window, data, len, 1, 1, 2);
+
+    dsps_fft2r_fc32(data, len);
+    dsps_bit_rev_fc32(data, len);
+
+    // Single sided amplitude spectrum, corrected for the window gain
+    float window_sum = 0.0f;
+    for (uint32_t i = 0; i < len; i++) {
+        window_sum += window[i];
+    }
+    float *amplitude = signal;
+    for (uint32_t k = 0; k <= len / 2; k++) {
+        float re = data[2 * k];
+        float im = data[2 * k + 1];
+        amplitude[k] = 2.0f * sqrtf(re * re + im * im) / window_sum;
+    }
+
+    spectrum->samples = len;
+    spectrum->sample_rate = time_end > time_start ? (float)(len - 1) * MS_PER_SECOND / (time_end - time_start) : 0.0f;
+    spectrum->resolution = spectrum->sample_rate / len;
+    spectrum->num_peaks = 0;
+
+    // Local maxima, with the frequency refined by parabolic interpolation. The DC bin and
+    // its neighbour are skipped, they only hold the window leakage of the removed mean
+    for (uint32_t k = 2; k < len / 2; k++) {
+        float a = amplitude[k - 1];
+        float b = amplitude[k];
+        float c = amplitude[k + 1];
+        if (b <= a || b < c || b <= 0.0f) {
+            continue;
+        }
+        float denominator = a - 2.0f * b + c;
+        float delta = denominator != 0.0f ? 0.5f * (a - c) / denominator : 0.0f;
+        spectrum_insert_peak(spectrum, max_peaks, (k + delta) * spectrum->resolution, b - 0.25f * (a - c) * delta);
+    }
+
+    heap_caps_free(signal);
+    heap_caps_free(window);
+    heap_caps_free(data);
+    return PBIO_SUCCESS;
+}
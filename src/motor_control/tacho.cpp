@@ -1,4 +1,5 @@
 #include "motor_control/tacho.hpp"
+#include "motor_control/macros.h"
 
 Tacho::Tacho() {
 }
@@ -87,7 +88,7 @@ void IRAM_ATTR Tacho::ISR_read_encoder() {
     portEXIT_CRITICAL( &mux );
 }
 
-int32_t Tacho::getCount() const {
+int32_t PBIO_IRAM Tacho::getCount() const {
     portENTER_CRITICAL( &mux );
     int32_t value = _last_count + _offset;
     portEXIT_CRITICAL( &mux );    
@@ -98,7 +99,7 @@ float Tacho::getAngle() const {
     return getCount() / _gear_ratio;
 }
 
-int32_t Tacho::getRate() const {
+int32_t PBIO_IRAM Tacho::getRate() const {
     portENTER_CRITICAL( &mux );
 
     // head can be updated in interrupt, so only read it once
@@ -178,7 +179,7 @@ void Tacho::resetAngle(float angle) {
     portEXIT_CRITICAL( &mux );
 }
 
-bool Tacho::isSequenceError() {
+bool PBIO_IRAM Tacho::isSequenceError() {
     portENTER_CRITICAL( &mux );
     bool value = _sequence_error;
     portEXIT_CRITICAL( &mux );
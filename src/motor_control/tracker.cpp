@@ -0,0 +1,88 @@
+#include "motor_control/tracker.hpp"
+#include "motor_control/control.hpp"
+#include "motor_control/const.h"
+#include "motor_control/macros.h"
+#include "config.h"
+
+// Longest step of the filter. A longer gap, e.g. a late control task, is not made up in one step
+#define TRACKER_MAX_STEP_US (10 * PBIO_CONFIG_SERVO_PERIOD_MS * US_PER_MS)
+
+/**
+Start filtering towards a target from the given state
+
+:param time_now: Current time (us)
+:param count: Initial position, the physical one or the reference in use (count)
+:param rate: Initial speed (count/s)
+:param target: Target to track (count)
+ */
+void pbio_tracker_start(pbio_tracker_t *tracker, int32_t time_now, int32_t count, int32_t rate, int32_t target) {
+    tracker->active = true;
+    tracker->target = target;
+    tracker->time_prev = time_now;
+    tracker->count = count;
+    tracker->rate = rate;
+    tracker->acceleration = 0.0f;
+}
+
+/**
+Stop filtering, when a maneuver or a plain hold takes over the reference
+ */
+void pbio_tracker_stop(pbio_tracker_t *tracker) {
+    tracker->active = false;
+}
+
+/**
+Advance the filter by one control period
+
+:param s: Control settings, for the speed and acceleration limits
+:param time_now: Time of reference evaluation (us)
+ */
+void PBIO_IRAM pbio_tracker_update(pbio_tracker_t *tracker, const pbio_control_settings_t *s, int32_t time_now) {
+    int32_t elapsed = time_now - tracker->time_prev;
+    if (elapsed <= 0) {
+        return;
+    }
+    tracker->time_prev = time_now;
+
+    float dt = PIO_MIN(elapsed, TRACKER_MAX_STEP_US) / (float)US_PER_SECOND;
+    float err = tracker->target - tracker->count;
+    float sign = err >= 0.0f ? 1.0f : -1.0f;
+    float direction = tracker->rate != 0.0f ? tracker->rate : err;
+    float a = pbio_control_settings_get_abs_acceleration(s, direction >= 0.0f ? 1 : -1);
+
+    // Settled on the target
+    if (fabsf(err) <= 0.5f * a * dt * dt && fabsf(tracker->rate) <= a * dt) {
+        tracker->count = tracker->target;
+        tracker->rate = 0.0f;
+        tracker->acceleration = 0.0f;
+        return;
+    }
+
+    // Highest speed from which the reference still stops on the target after this step
+    float half = 0.5f * a * dt;
+    float room = fmaxf(fabsf(err) - sign * tracker->rate * dt * 0.5f, 0.0f);
+    float rate_stop = sqrtf(half * half + 2.0f * a * room) - half;
+    float rate_wanted = sign * fminf(s->max_rate, rate_stop);
+
+    float step = fmaxf(-a * dt, fminf(rate_wanted - tracker->rate, a * dt));
+    float rate_next = tracker->rate + step;
+    tracker->count += 0.5f * (tracker->rate + rate_next) * dt;
+    tracker->acceleration = step / dt;
+    tracker->rate = rate_next;
+}
+
+/**
+Get the filtered reference
+
+:param count_ref: Return the reference position (count)
+:param count_ref_ext: Return the reference position decimals (millicount)
+:param rate_ref: Return the reference speed (count/s)
+:param acceleration_ref: Return the reference acceleration (count/s^2)
+ */
+void PBIO_IRAM pbio_tracker_get_reference(const pbio_tracker_t *tracker, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref) {
+    int64_t mcount = llroundf(tracker->count * 1000.0f);
+    *count_ref = (int32_t)(mcount / 1000);
+    *count_ref_ext = (int32_t)(mcount - ((int64_t)*count_ref) * 1000);
+    *rate_ref = (int32_t)tracker->rate;
+    *acceleration_ref = (int32_t)tracker->acceleration;
+}
@@ -2,6 +2,8 @@
 // Copyright (c) 2018-2020 The Pybricks Authors
 
 #include "motor_control/trajectory.hpp"
+#include "motor_control/macros.h"
+#include "config.h"
 
 /**
 Sum the integet part and the decimal part of encoder counts
@@ -10,7 +12,7 @@ Sum the integet part and the decimal part of encoder counts
 :param count_ext: Encoder counts decimal part in millicounts
 :return: Sum of integer and decimal encoder counts (millicounts)
  */
-static int64_t as_mcount(int32_t count, int32_t count_ext) {
+static int64_t PBIO_IRAM as_mcount(int32_t count, int32_t count_ext) {
     return ((int64_t) count)*1000 + count_ext;
 }
 
@@ -21,7 +23,7 @@ Split encoder counts in millicounts into integer and decimal part
 :return: A tuple with the following informations: Encoder count integer part (count), encoder count decimal part (millicount)
 */
 
-static void as_count(int64_t mcount, int32_t *count, int32_t *count_ext) {
+static void PBIO_IRAM as_count(int64_t mcount, int32_t *count, int32_t *count_ext) {
     *count = (int32_t) (mcount/1000);
     *count_ext = mcount - ((int64_t) *count)*1000;
 }
@@ -59,7 +61,7 @@ void reverse_trajectory(pbio_trajectory_t *ref) {
     :param t: Time in us
     :return: Encoder counts in millicounts
  */
-static int64_t x_time(int32_t b, int32_t t) {
+static int64_t PBIO_IRAM x_time(int32_t b, int32_t t) {
     return (((int64_t) b) * ((int64_t) t))/US_PER_MS;
 }
 
@@ -70,7 +72,7 @@ static int64_t x_time(int32_t b, int32_t t) {
     :param t: Time in us
     :return: Encoder counts in millicounts
  */
-static int64_t x_time2(int32_t b, int32_t t) {
+static int64_t PBIO_IRAM x_time2(int32_t b, int32_t t) {
     return x_time(x_time(b, t), t)/(2*US_PER_MS);
 }
 
@@ -353,7 +355,7 @@ pbio_error_t pbio_trajectory_make_angle_based(pbio_trajectory_t *ref, int32_t t0
 }
 
 /**
-Return the status of a trajectory (position, speed, acceleration) at the given time
+Evaluate a trajectory with the int64 millicount math
 
 :param time_ref: Time instant where calculate the trajectory status (us)
 :param count_ref: Return position integer part (count), 
@@ -361,7 +363,7 @@ Return the status of a trajectory (position, speed, acceleration) at the given t
 :param rate_ref: Return speed (enc count/s)
 :param acceleration_ref: Return acceleration (enc count/sec^2)
 */
-void pbio_trajectory_get_reference(pbio_trajectory_t *traject, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref) {
+void PBIO_IRAM pbio_trajectory_eval_int64(const pbio_trajectory_t *traject, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref) {
 
     int64_t mcount_ref;
 
@@ -392,6 +394,99 @@ void pbio_trajectory_get_reference(pbio_trajectory_t *traject, int32_t time_ref,
 
     // Split high res angle into counts and millicounts
     as_count(mcount_ref, count_ref, count_ref_ext);
+}
+
+/**
+Add the distance travelled from a phase start to its position, with int32 and float math
+
+The terms of the whole seconds are exact in int32. A whole second of acceleration is within the
+speed range, so they don't overflow over a phase. The terms of the remaining fraction of a second
+are below the speed, so float keeps them within a few millicounts.
+
+:param th: Encoder count at start of the phase (integer part)
+:param th_ext: Encoder count at start of the phase (decimal part only) in millicounts
+:param w: Speed at start of the phase in enc count/sec
+:param a: Acceleration of the phase in enc count/sec^2
+:param t: Time since the start of the phase in us
+:param count: Return position integer part (count)
+:param count_ext: Return position decimal part (millicount)
+*/
+static void PBIO_IRAM advance_float(int32_t th, int32_t th_ext, int32_t w, int32_t a, int32_t t, int32_t *count, int32_t *count_ext) {
+    // d = w*t + a*t^2/2, with t = s + r:  w*s + a*s^2/2  +  (w + a*s)*r + a*r^2/2
+    int32_t seconds = t / US_PER_SECOND;
+    float rest = (t - seconds * US_PER_SECOND) * (1.0f / US_PER_SECOND);
+    int32_t as2 = a * seconds * seconds;
+    float distance = (w + a * seconds) * rest + 0.5f * a * rest * rest + 0.5f * (as2 % 2);
+    int32_t whole = (int32_t)floorf(distance);
+
+    // Same sign convention as as_count: both parts truncated towards zero
+    int32_t c = th + w * seconds + as2 / 2 + whole;
+    int32_t ext = th_ext + (int32_t)lroundf((distance - whole) * 1000.0f);
+    c += ext / 1000;
+    ext %= 1000;
+    if (c > 0 && ext < 0) {
+        c--;
+        ext += 1000;
+    }
+    else if (c < 0 && ext > 0) {
+        c++;
+        ext -= 1000;
+    }
+    *count = c;
+    *count_ext = ext;
+}
+
+/**
+Evaluate a trajectory with int32 and float math, without the int64 millicount math
+
+:param time_ref: Time instant where calculate the trajectory status (us)
+:param count_ref: Return position integer part (count), 
+:param count_ref_ext: Return position decimal part (millicount)
+:param rate_ref: Return speed (enc count/s)
+:param acceleration_ref: Return acceleration (enc count/sec^2)
+*/
+void PBIO_IRAM pbio_trajectory_eval_float(const pbio_trajectory_t *traject, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref) {
+    if (time_ref - traject->t1 < 0) {
+        *rate_ref = traject->w0 + timest(traject->a0, time_ref-traject->t0);
+        advance_float(traject->th0, traject->th0_ext, traject->w0, traject->a0, time_ref-traject->t0, count_ref, count_ref_ext);
+        *acceleration_ref = traject->a0;
+    }
+    else if (traject->forever || time_ref - traject->t2 <= 0) {
+        *rate_ref = traject->w1;
+        advance_float(traject->th1, traject->th1_ext, traject->w1, 0, time_ref-traject->t1, count_ref, count_ref_ext);
+        *acceleration_ref = 0;
+    }
+    else if (time_ref - traject->t3 <= 0) {
+        *rate_ref = traject->w1 + timest(traject->a2, time_ref-traject->t2);
+        advance_float(traject->th2, traject->th2_ext, traject->w1, traject->a2, time_ref-traject->t2, count_ref, count_ref_ext);
+        *acceleration_ref = traject->a2;
+    }
+    else {
+        *rate_ref = 0;
+        *count_ref = traject->th3;
+        *count_ref_ext = traject->th3_ext;
+        *acceleration_ref = 0;
+    }
+}
+
+/**
+Return the status of a trajectory (position, speed, acceleration) at the given time
+
+The position is evaluated with the math selected by PBIO_CONFIG_TRAJECTORY_FLOAT.
+
+:param time_ref: Time instant where calculate the trajectory status (us)
+:param count_ref: Return position integer part (count), 
+:param count_ref_ext: Return position decimal part (millicount)
+:param rate_ref: Return speed (enc count/s)
+:param acceleration_ref: Return acceleration (enc count/sec^2)
+*/
+void PBIO_IRAM pbio_trajectory_get_reference(pbio_trajectory_t *traject, int32_t time_ref, int32_t *count_ref, int32_t *count_ref_ext, int32_t *rate_ref, int32_t *acceleration_ref) {
+
+#if PBIO_CONFIG_TRAJECTORY_FLOAT
+    pbio_trajectory_eval_float(traject, time_ref, count_ref, count_ref_ext, rate_ref, acceleration_ref);
+#else
+    pbio_trajectory_eval_int64(traject, time_ref, count_ref, count_ref_ext, rate_ref, acceleration_ref);
+#endif
 
     // Rebase the reference before it overflows after 35 minutes
     if (time_ref - traject->t0 > (DURATION_MAX_S+120)*MS_PER_SECOND*US_PER_MS) {
@@ -0,0 +1,19 @@
+#include "settings/axis_model/settings_axis_model_group.hpp"
+
+SettingsAxisModelGroup::SettingsAxisModelGroup(const char* name, const char* title, Motor& motor1, Motor& motor2) : _motor1(motor1), _motor2(motor2) 
+{ 
+    _name = name;
+    _title = title;
+}
+
+const char* SettingsAxisModelGroup::getName() const {
+    return _name;
+}
+
+const char* SettingsAxisModelGroup::getTitle() const {
+    return _title;
+}
+
+ISetting** SettingsAxisModelGroup::getSettings() {
+    return _settings;
+}
\ No newline at end of file
@@ -1,6 +1,6 @@
 #include "settings/axis_stall_homing/settings_axis_stall_homing_group.hpp"
 
-SettingsAxisStallHomingGroup::SettingsAxisStallHomingGroup(const char* name, const char* description,  MotorWithStallReference& motor) : _motor(motor) 
+SettingsAxisStallHomingGroup::SettingsAxisStallHomingGroup(const char* name, const char* description,  stall_homing_config_t& config) : _config(config) 
 { 
     _name = name;
     _description = description;
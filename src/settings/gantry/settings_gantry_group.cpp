@@ -0,0 +1,19 @@
+#include "settings/gantry/settings_gantry_group.hpp"
+
+SettingsGantryGroup::SettingsGantryGroup(const char* name, const char* title, GantryMotor& motor) : _motor(motor) 
+{ 
+    _name = name;
+    _title = title;
+}
+
+const char* SettingsGantryGroup::getName() const {
+    return _name;
+}
+
+const char* SettingsGantryGroup::getTitle() const {
+    return _title;
+}
+
+ISetting** SettingsGantryGroup::getSettings() {
+    return _settings;
+}
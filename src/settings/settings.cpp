@@ -83,6 +83,28 @@ void Settings::storeInNVS() {
     }
 }
 
+void Settings::storeInNVS(const char* groupName) {
+    SettingsGroup* group = getGroup(groupName);
+    if (!group) {
+        String errorMsg = "Failed to store " + String(groupName) + " group in NVS. Unknown group";
+        Logger::instance().logW(errorMsg.c_str());
+        return;
+    }
+
+    // Open a writable preference for the group
+    Preferences preferences;
+    if (!preferences.begin(group->getName(), false)) {
+        String errorMsg = "Failed to open NVS to store " + String(group->getName()) + " group!!";
+        Logger::instance().logW(errorMsg.c_str());
+        return;
+    }
+
+    storeGroupInNVS(preferences, *group);
+
+    // Close the preference
+    preferences.end();
+}
+
 void readGroupFromNVS(Preferences& preferences, SettingsGroup& group) {
     ISetting** settings = group.getSettings();
     uint16_t settingsCount = group.getSettingsCount();
@@ -144,5 +166,86 @@ void Settings::restoreFromNVS() {
         // Close the preference
         preferences.end();
     }
+
+    restoreTablesFromNVS();
+}
+
+
+
+void Settings::storeFeedforwardInNVS() {
+    Preferences preferences;
+
+    // Open a writable preference for the tables
+    if (!preferences.begin("x_tables", false)) {
+        Logger::instance().logW("Failed to open NVS to store the feedforward tables!!");
+        return;
+    }
+
+    // Feedforward tables are stored as binary blobs, only once calibrated
+    pbio_control_ff_table_t table;
+    _X1Motor.get_ff_table(&table);
+    if (table.count_step > 0) {
+        preferences.putBytes("x1_ff", &table, sizeof(table));
+    }
+    _X2Motor.get_ff_table(&table);
+    if (table.count_step > 0) {
+        preferences.putBytes("x2_ff", &table, sizeof(table));
+    }
+
+    // Close the preference
+    preferences.end();
 }
 
+void Settings::storeLearningInNVS() {
+    Preferences preferences;
+
+    // Open a writable preference for the tables
+    if (!preferences.begin("x_tables", false)) {
+        Logger::instance().logW("Failed to open NVS to store the drop correction!!");
+        return;
+    }
+
+    // Learned drop correction of the lead motor, too large for the stack. Motor 2 follows it and never learns
+    pbio_ilc_table_t* ilc_table = (pbio_ilc_table_t*)malloc(sizeof(pbio_ilc_table_t));
+    if (ilc_table) {
+        _X1Motor.get_learning_table(ilc_table);
+        if (ilc_table->length > 0) {
+            preferences.putBytes("x1_ilc", ilc_table, sizeof(pbio_ilc_table_t));
+        }
+        free(ilc_table);
+    }
+    preferences.remove("x2_ilc");
+
+    // Close the preference
+    preferences.end();
+}
+
+void Settings::restoreTablesFromNVS() {
+    Preferences preferences;
+
+    // Open a readonly preference for the tables
+    if (!preferences.begin("x_tables", true)) {
+        Logger::instance().logW("Failed to open NVS to read the axis tables!!");
+        return;
+    }
+
+    // Skip tables stored with a different layout
+    pbio_control_ff_table_t table;
+    if (preferences.getBytesLength("x1_ff") == sizeof(table) && preferences.getBytes("x1_ff", &table, sizeof(table)) == sizeof(table)) {
+        _X1Motor.set_ff_table(&table);
+    }
+    if (preferences.getBytesLength("x2_ff") == sizeof(table) && preferences.getBytes("x2_ff", &table, sizeof(table)) == sizeof(table)) {
+        _X2Motor.set_ff_table(&table);
+    }
+
+    pbio_ilc_table_t* ilc_table = (pbio_ilc_table_t*)malloc(sizeof(pbio_ilc_table_t));
+    if (ilc_table) {
+        if (preferences.getBytesLength("x1_ilc") == sizeof(pbio_ilc_table_t) && preferences.getBytes("x1_ilc", ilc_table, sizeof(pbio_ilc_table_t)) == sizeof(pbio_ilc_table_t) && ilc_table->length > 0) {
+            _X1Motor.set_learning_table(ilc_table);
+        }
+        free(ilc_table);
+    }
+
+    // Close the preference
+    preferences.end();
+}
\ No newline at end of file
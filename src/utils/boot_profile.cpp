@@ -0,0 +1,29 @@
+#include "utils/boot_profile.hpp"
+#include "monotonic.h"
+
+void BootProfile::start(BootPhase phase) {
+    _start[(uint8_t)phase] = (uint32_t)monotonic_us();
+}
+
+void BootProfile::end(BootPhase phase) {
+    _end[(uint8_t)phase] = (uint32_t)monotonic_us();
+}
+
+void BootProfile::ready() {
+    _ready = (uint32_t)monotonic_us();
+}
+
+const char* BootProfile::name(BootPhase phase) {
+    switch (phase) {
+        case BootPhase::Io:         return "io";
+        case BootPhase::I2C:        return "i2c";
+        case BootPhase::Motors:     return "motors";
+        case BootPhase::Settings:   return "settings";
+        case BootPhase::MotorTask:  return "motor_task";
+        case BootPhase::WiFi:       return "wifi";
+        case BootPhase::LittleFS:   return "littlefs";
+        case BootPhase::Server:     return "server";
+        case BootPhase::Homing:     return "homing";
+        default:                    return "";
+    }
+}
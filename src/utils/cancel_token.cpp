@@ -24,6 +24,7 @@ bool CancelToken::isCancelled() const {
 void CancelToken::cancel() {
     std::lock_guard<std::mutex> lock(instancesMutex);
     cancelled = true;
+    notify();
 }
 
 void CancelToken::cancelAll() {
@@ -31,6 +32,30 @@ void CancelToken::cancelAll() {
     for (auto* token : instances) {
         if (token) {
             token->cancelled = true;
+            token->notify();
         }
     }
+}
+
+void CancelToken::subscribe(EventGroupHandle_t group, EventBits_t bits) {
+    std::lock_guard<std::mutex> lock(instancesMutex);
+    subscribers.push_back(std::make_pair(group, bits));
+    if (cancelled) {
+        xEventGroupSetBits(group, bits);
+    }
+}
+
+void CancelToken::unsubscribe(EventGroupHandle_t group) {
+    std::lock_guard<std::mutex> lock(instancesMutex);
+    subscribers.erase(
+        std::remove_if(subscribers.begin(), subscribers.end(),
+            [group](const std::pair<EventGroupHandle_t, EventBits_t>& s) { return s.first == group; }),
+        subscribers.end());
+}
+
+// Must be called with instancesMutex held
+void CancelToken::notify() {
+    for (auto& s : subscribers) {
+        xEventGroupSetBits(s.first, s.second);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include <stddef.h>
+#include "esp_rom_crc.h"
+#include "esp_app_desc.h"
+#include "warm_boot.hpp"
+#include "motor_control/macros.h"
+#include "utils/logger.hpp"
+
+// Survive the soft resets, not the power cycles
+RTC_NOINIT_ATTR static warm_boot_snapshot_t rtc_snapshot;
+RTC_NOINIT_ATTR static uint32_t rtc_restores;
+RTC_NOINIT_ATTR static uint32_t rtc_restores_check;
+
+static uint32_t snapshot_crc(const warm_boot_snapshot_t* snapshot) {
+    return esp_rom_crc32_le(0, (const uint8_t*)snapshot, offsetof(warm_boot_snapshot_t, crc));
+}
+
+static bool snapshot_valid(const warm_boot_snapshot_t* snapshot) {
+    return snapshot->magic == WARM_BOOT_MAGIC &&
+        memcmp(snapshot->firmware, esp_app_get_description()->app_elf_sha256, WARM_BOOT_FIRMWARE_BYTES) == 0 &&
+        snapshot->crc == snapshot_crc(snapshot);
+}
+
+/**
+Reads the snapshot saved before the reset. Must be called after the motors begin and before the
+motor loop starts, which drops the RTC snapshot until the axis is referenced again
+*/
+void WarmBoot::begin() {
+    _reset_reason = esp_reset_reason();
+    _begin_time = millis();
+    _boot_count1 = _motor.motor1().motor_count();
+    _boot_count2 = _motor.motor2().motor_count();
+
+    // A power cycle leaves random data in the RTC memory
+    _boot_valid = snapshot_valid(&rtc_snapshot);
+    if (_reset_reason == ESP_RST_POWERON || rtc_restores_check != ~rtc_restores) {
+        rtc_restores = 0;
+        rtc_restores_check = ~rtc_restores;
+    }
+}
+
+/**
+Checks that the position saved before the reset can be trusted
+
+:return: Why the position can't be restored, nullptr if it can
+*/
+const char* WarmBoot::check() {
+    if (!WARM_BOOT_RESTORE) {
+        return "restore disabled";
+    }
+
+    // After a panic, a watchdog or a brownout the axis could have been moving or pushed
+    if (_reset_reason != ESP_RST_SW) {
+        return "not a software reset";
+    }
+
+    if (!_boot_valid) {
+        return "no saved position";
+    }
+
+    // A loaded axis can drop while the motors coast through the reset, before the encoders are read
+    if (_boot.hold_duty > WARM_BOOT_MAX_HOLD_DUTY) {
+        return "axis held against a load";
+    }
+
+    if (rtc_restores >= WARM_BOOT_MAX_RESTORES) {
+        return "too many restores without homing";
+    }
+
+    // The motors coast since the reset, so the axis must not move while the firmware starts
+    uint32_t elapsed = millis() - _begin_time;
+    if (elapsed < WARM_BOOT_STILL_MS) {
+        delay(WARM_BOOT_STILL_MS - elapsed);
+    }
+    if (fabsf(_motor.motor1().motor_count() - _boot_count1) > WARM_BOOT_MOTION_TOLERANCE ||
+        fabsf(_motor.motor2().motor_count() - _boot_count2) > WARM_BOOT_MOTION_TOLERANCE) {
+        return "axis moved during boot";
+    }
+
+    float angle = (_boot.angle1 + _boot.angle2 - _boot.skew_compensation) / 2.0f;
+    if (angle < _motor.getSwLimitMinus() - WARM_BOOT_LIMIT_MARGIN || angle > _motor.getSwLimitPlus() + WARM_BOOT_LIMIT_MARGIN) {
+        return "position beyond the software limits";
+    }
+
+    if (fabsf(_boot.angle2 - _boot.angle1 - _boot.skew_compensation) > _motor.getSkewAlarmThreshold()) {
+        return "gantry skew beyond the alarm threshold";
+    }
+
+    return nullptr;
+}
+
+/**
+Restores the position saved before the reset, if it can be trusted, and holds the axis there.
+
+:return: True if the axis is referenced and doesn't need homing
+*/
+bool WarmBoot::restore() {
+    const char* reason = check();
+    if (reason != nullptr) {
+        Logger::instance().logI("Position not restored: " + String(reason));
+        return false;
+    }
+
+    _motor.restore_angles(_boot.angle1, _boot.angle2, _boot.skew_compensation);
+    _motor.hold();
+    _motor.armEnvelope(true);
+
+    rtc_restores++;
+    rtc_restores_check = ~rtc_restores;
+    _restored = true;
+
+    Logger::instance().logI("Position restored after reset " + String((int)_reset_reason) +
+        ": " + String(_motor.angle(), 1) + " deg");
+    return true;
+}
+
+/**
+Marks the axis as homed, so the next resets can restore the position again
+*/
+void WarmBoot::homed() {
+    rtc_restores = 0;
+    rtc_restores_check = ~rtc_restores;
+}
+
+/**
+True when the axis is referenced and holds its position
+*/
+bool WarmBoot::isStill() {
+    Motor& motor1 = _motor.motor1();
+    return _motor.referenced() &&
+        motor1.getActuationStatus() == PBIO_CONTROL_ANGLE && motor1.is_completion() &&
+        fabsf(motor1.speed()) < WARM_BOOT_STILL_SPEED && fabsf(_motor.motor2().speed()) < WARM_BOOT_STILL_SPEED;
+}
+
+void WarmBoot::take(warm_boot_snapshot_t* snapshot) {
+    snapshot->magic = WARM_BOOT_MAGIC;
+    memcpy(snapshot->firmware, esp_app_get_description()->app_elf_sha256, WARM_BOOT_FIRMWARE_BYTES);
+    snapshot->angle1 = _motor.motor1().angle();
+    snapshot->angle2 = _motor.motor2().angle();
+    snapshot->skew_compensation = _motor.getSkewCompensation();
+    snapshot->hold_duty = PIO_MAX(fabsf(_motor.motor1().duty()), fabsf(_motor.motor2().duty()));
+    snapshot->crc = snapshot_crc(snapshot);
+}
+
+/**
+Keeps the RTC snapshot up to date. Called by the motor loop after the axes update.
+
+The snapshot is marked as moving in the first control period the axis moves, and saved again
+once it has held still for a while.
+*/
+void WarmBoot::update() {
+    if (!isStill()) {
+        _still_ticks = 0;
+        if (rtc_snapshot.magic != WARM_BOOT_MOVING) {
+            taskENTER_CRITICAL(&_mux);
+            rtc_snapshot.magic = WARM_BOOT_MOVING;
+            taskEXIT_CRITICAL(&_mux);
+        }
+        return;
+    }
+
+    _still_ticks++;
+    if (_still_ticks < WARM_BOOT_STILL_TICKS || (_still_ticks - WARM_BOOT_STILL_TICKS) % WARM_BOOT_REFRESH_TICKS != 0) {
+        return;
+    }
+
+    warm_boot_snapshot_t snapshot;
+    take(&snapshot);
+    taskENTER_CRITICAL(&_mux);
+    rtc_snapshot = snapshot;
+    taskEXIT_CRITICAL(&_mux);
+}
@@ -0,0 +1,281 @@
+#include "web_functions/axis/web_function_axis_autotune.hpp"
+
+const char* WebFunctionAxisAutoTune::getName() const {
+    return "axis_autotune";
+}
+
+const char* WebFunctionAxisAutoTune::getTitle() const {
+    return "Axis PID Auto-Tuning";
+}
+
+const char* WebFunctionAxisAutoTune::getDescription() const {
+    return "Make the axis oscillate around the middle of the travel with a relay feedback and compute the suggested PID gains";
+}
+
+uint16_t WebFunctionAxisAutoTune::getPrerequisitesCount() const {
+    return 1;
+}
+
+const char* WebFunctionAxisAutoTune::getPrerequisiteDescription(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "Axis must be homed";
+    default: return nullptr;
+    }
+}
+
+void WebFunctionAxisAutoTune::arePrerequisitesMet(bool* results) const {
+    results[0] = _axis.referenced();
+}
+
+const char* WebFunctionAxisAutoTune::getResultName(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "pid_kp";
+    case 1: return "pid_ki";
+    case 2: return "pid_kd";
+    case 3: return "integral_range";
+    case 4: return "integral_rate";
+    default: return nullptr;
+    }
+}
+
+const char* WebFunctionAxisAutoTune::getResultUnit(uint16_t index) const {
+    switch (index)
+    {
+    case 3: return "deg";
+    case 4: return "deg/s";
+    default: return "";
+    }
+}
+
+float WebFunctionAxisAutoTune::getResultValue(uint16_t index) const {
+    if (index >= AUTOTUNE_RESULTS_COUNT)
+        return 0.0f;
+
+    return _results[index];
+}
+
+bool WebFunctionAxisAutoTune::saveResult() {
+    if (!_hasResult)
+        return false;
+
+    Motor* motors[2] = { &_axis.motor1(), &_axis.motor2() };
+    for (uint8_t i = 0; i < 2; i++) {
+        uint16_t kp, ki, kd;
+        float integral_range, integral_rate, max_windup_factor;
+        motors[i]->get_pid(&kp, &ki, &kd, &integral_range, &integral_rate, &max_windup_factor);
+        motors[i]->set_pid(
+            (uint16_t)_results[0], (uint16_t)_results[1], (uint16_t)_results[2],
+            _results[3], _results[4], max_windup_factor);
+    }
+
+    _hasResult = false;
+    return true;
+}
+
+void WebFunctionAxisAutoTune::discardResult() {
+    _hasResult = false;
+}
+
+/**
+Drives the axis with a relay feedback around the center position until it oscillates steadily.
+
+The relay is applied around the duty cycle needed to hold the axis, so gravity doesn't bias the oscillation.
+
+:param center: Position around which the axis oscillates (deg)
+:param amplitude: Returns the mean oscillation amplitude (deg)
+:param period: Returns the mean oscillation period (s)
+:return: nullptr on success, otherwise the failure description
+*/
+const char* WebFunctionAxisAutoTune::runRelayExperiment(float center, float* amplitude, float* period, CancelToken& cancel_token) {
+    // Measure the duty cycle needed to hold the axis at the center position
+    float bias = 0.0f;
+    const int32_t bias_samples = 50;
+    for (int32_t i = 0; i < bias_samples; i++) {
+        bias += _axis.motor1().duty();
+        delay(PBIO_CONFIG_SERVO_PERIOD_MS);
+    }
+    bias /= bias_samples;
+
+    // Stop the experiment if the oscillation becomes too large for the axis travel
+    float max_deviation = min(center - _axis.getSwLimitMinus(), _axis.getSwLimitPlus() - center) * 0.8f;
+
+    int8_t relay = 1;
+    _axis.dc(bias + AUTOTUNE_RELAY_DUTY);
+
+    unsigned long start_time = millis();
+    unsigned long last_rise_time = 0;
+    uint16_t cycles = 0;
+    uint16_t measured_cycles = 0;
+    float max_angle = center;
+    float min_angle = center;
+    float amplitude_sum = 0.0f;
+    float period_sum = 0.0f;
+    while (measured_cycles < AUTOTUNE_MEASURE_CYCLES) {
+        IF_CANCELLED(cancel_token, {
+            return nullptr;
+        });
+
+        if ((millis() - start_time) > AUTOTUNE_TIMEOUT_MS) {
+            return "The axis didn't oscillate steadily. Check the mechanics or increase the integral gain";
+        }
+
+        float angle = _axis.angle();
+        float error = angle - center;
+        if (fabs(error) > max_deviation) {
+            return "The oscillation exceeded the axis travel";
+        }
+
+        max_angle = max(max_angle, angle);
+        min_angle = min(min_angle, angle);
+
+        if (relay > 0 && error > AUTOTUNE_RELAY_HYSTERESIS) {
+            relay = -1;
+            _axis.dc(bias - AUTOTUNE_RELAY_DUTY);
+        } else if (relay < 0 && error < -AUTOTUNE_RELAY_HYSTERESIS) {
+            relay = 1;
+            _axis.dc(bias + AUTOTUNE_RELAY_DUTY);
+
+            // A full oscillation is completed on each rising switch
+            unsigned long now = millis();
+            if (last_rise_time != 0) {
+                cycles++;
+                if (cycles > AUTOTUNE_WARMUP_CYCLES) {
+                    amplitude_sum += (max_angle - min_angle) / 2.0f;
+                    period_sum += (float)(now - last_rise_time) / 1000.0f;
+                    measured_cycles++;
+                }
+            }
+            last_rise_time = now;
+            max_angle = angle;
+            min_angle = angle;
+        }
+
+        delay(PBIO_CONFIG_SERVO_PERIOD_MS);
+    }
+
+    *amplitude = amplitude_sum / measured_cycles;
+    *period = period_sum / measured_cycles;
+    return nullptr;
+}
+
+/**
+Computes the suggested gains from the relay oscillation.
+
+The ultimate gain comes from the describing function of a relay with hysteresis. The
+Ziegler-Nichols "no overshoot" rule is used, because the barrier must not overshoot its
+end positions.
+
+:param amplitude: Oscillation amplitude (deg)
+:param period: Oscillation period (s)
+*/
+void WebFunctionAxisAutoTune::computeGains(float amplitude, float period) {
+    float counts_per_unit = _axis.get_counts_per_unit();
+    float amplitude_counts = amplitude * counts_per_unit;
+    float hysteresis_counts = AUTOTUNE_RELAY_HYSTERESIS * counts_per_unit;
+    float relay_duty = AUTOTUNE_RELAY_DUTY * MOTOR_MAX_CONTROL / 100.0f;
+    float amplitude_net = sqrtf(max(amplitude_counts * amplitude_counts - hysteresis_counts * hysteresis_counts, 1.0f));
+
+    // Ultimate gain (duty steps / count) and period (s)
+    float ku = 4.0f * relay_duty / (PI * amplitude_net);
+    float tu = period;
+
+    float kp = 0.2f * ku;
+    float ti = 0.5f * tu;
+    float td = tu / 3.0f;
+
+    _results[0] = constrain(roundf(kp), 0.0f, 2000.0f);
+    _results[1] = constrain(roundf(kp / ti), 0.0f, 4000.0f);
+    _results[2] = constrain(roundf(kp * td), 0.0f, 1000.0f);
+
+    // Accumulate integral errors only within the oscillation band and at the oscillation error rate
+    _results[3] = constrain(2.0f * amplitude, 0.1f, 10.0f);
+    _results[4] = constrain(amplitude / tu, 0.01f, 10.0f);
+
+    Logger::instance().logI("Auto-tuning of " + String(_axis.name()) + "-axis: Ku=" + String(ku, 2) + " Tu=" + String(tu, 3) + "s" +
+        " Kp=" + String(_results[0], 0) + " Ki=" + String(_results[1], 0) + " Kd=" + String(_results[2], 0));
+}
+
+WebFunctionExecutionStatus WebFunctionAxisAutoTune::start() {
+    WebFunction::start(); // Call the base class start to initialize failure description and IO board
+    if (_status == WebFunctionExecutionStatus::Failed) {
+        return _status;
+    }
+
+    _status = WebFunctionExecutionStatus::InProgress;
+    _hasResult = false;
+
+    // Run the auto-tuning asynchronously
+    _taskRunner.runAsync([](void* context) {
+        WebFunctionAxisAutoTune* self = static_cast<WebFunctionAxisAutoTune*>(context);
+
+        // Create a cancel token for this operation
+        CancelToken cancel_token;
+        self->_cancelToken = &cancel_token;
+
+        float center = (self->_axis.getSwLimitPlus() + self->_axis.getSwLimitMinus()) / 2.0f;
+
+        // Move the axis at the middle of the travel
+        pbio_error_t err = self->_axis.run_target(
+            self->_axis.get_speed_limit() / 4.0, // Use 1/4 of max speed
+            center,
+            PBIO_ACTUATION_HOLD,
+            true,
+            &cancel_token);
+
+        IF_CANCELLED(cancel_token, {
+            self->_status = WebFunctionExecutionStatus::Done;
+            self->_cancelToken = nullptr;
+            return;
+        });
+
+        if (err != PBIO_SUCCESS) {
+            Logger::instance().logE("Error during " + String(self->_axis.name()) + "-axis auto-tuning: " + String(pbio_error_str(err)));
+            self->_failureDescription = "Failed to reach the middle of the travel";
+            self->_status = WebFunctionExecutionStatus::Failed;
+            self->_cancelToken = nullptr;
+            return;
+        }
+
+        delay(AUTOTUNE_SETTLE_TIME_MS); // Let the axis settle
+
+        // Log the experiment to allow to check it with the axis log
+        self->_axis.get_logger()->start(AUTOTUNE_LOG_DURATION_MS, 1);
+        float amplitude, period;
+        const char* failure = self->runRelayExperiment(center, &amplitude, &period, cancel_token);
+        self->_axis.hold();
+        self->_axis.get_logger()->stop();
+
+        IF_CANCELLED(cancel_token, {
+            self->_status = WebFunctionExecutionStatus::Done;
+            self->_cancelToken = nullptr;
+            return;
+        });
+
+        if (failure) {
+            Logger::instance().logE("Auto-tuning of " + String(self->_axis.name()) + "-axis failed: " + String(failure));
+            self->_failureDescription = failure;
+            self->_status = WebFunctionExecutionStatus::Failed;
+            self->_cancelToken = nullptr;
+            return;
+        }
+
+        self->computeGains(amplitude, period);
+        self->_hasResult = true;
+
+        // Bring back the axis at the middle of the travel
+        self->_axis.run_target(self->_axis.get_speed_limit() / 4.0, center, PBIO_ACTUATION_HOLD, true, &cancel_token);
+
+        self->_status = WebFunctionExecutionStatus::Done;
+        self->_cancelToken = nullptr;
+    }, this);
+
+    return _status;
+}
+
+void WebFunctionAxisAutoTune::stop() {
+    if (_cancelToken) {
+        _cancelToken->cancel();
+    }
+}
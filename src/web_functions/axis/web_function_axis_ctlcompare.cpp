@@ -0,0 +1,156 @@
+#include "web_functions/axis/web_function_axis_ctlcompare.hpp"
+
+const char* WebFunctionAxisControlCompare::getName() const {
+    return "axis_ctlcompare";
+}
+
+const char* WebFunctionAxisControlCompare::getTitle() const {
+    return "Axis Control Law Comparison";
+}
+
+const char* WebFunctionAxisControlCompare::getDescription() const {
+    return "Simulate a move over the whole travel on the identified model with the PID and with the state feedback, and compare settling, tracking and CPU time of the control update. Saving enables the state feedback";
+}
+
+uint16_t WebFunctionAxisControlCompare::getPrerequisitesCount() const {
+    return 1;
+}
+
+const char* WebFunctionAxisControlCompare::getPrerequisiteDescription(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "Axis model must be identified";
+    default: return nullptr;
+    }
+}
+
+void WebFunctionAxisControlCompare::arePrerequisitesMet(bool* results) const {
+    float k_position, k_speed, k_integral;
+    results[0] = _axis.motor1().get_state_feedback_gains(1, &k_position, &k_speed, &k_integral);
+}
+
+const char* WebFunctionAxisControlCompare::getResultName(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "pid_settle_time";
+    case 1: return "pid_overshoot";
+    case 2: return "pid_tracking_rms";
+    case 3: return "pid_update_time";
+    case 4: return "lqr_settle_time";
+    case 5: return "lqr_overshoot";
+    case 6: return "lqr_tracking_rms";
+    case 7: return "lqr_update_time";
+    case 8: return "lqr_k_position";
+    case 9: return "lqr_k_speed";
+    case 10: return "lqr_k_integral";
+    default: return nullptr;
+    }
+}
+
+const char* WebFunctionAxisControlCompare::getResultUnit(uint16_t index) const {
+    switch (index)
+    {
+    case 0:
+    case 4: return "ms";
+    case 1:
+    case 2:
+    case 5:
+    case 6: return "deg";
+    case 3:
+    case 7: return "us";
+    case 8: return "%/deg";
+    case 9: return "%/(deg/s)";
+    case 10: return "%/(deg*s)";
+    default: return "";
+    }
+}
+
+float WebFunctionAxisControlCompare::getResultValue(uint16_t index) const {
+    if (index >= CTLCOMPARE_RESULTS_COUNT)
+        return 0.0f;
+
+    return _results[index];
+}
+
+bool WebFunctionAxisControlCompare::saveResult() {
+    if (!_hasResult)
+        return false;
+
+    for (Motor* motor : { &_axis.motor1(), &_axis.motor2() }) {
+        bool enabled;
+        float position_error, speed_error, integral_error;
+        motor->get_state_feedback(&enabled, &position_error, &speed_error, &integral_error);
+        motor->set_state_feedback(true, position_error, speed_error, integral_error);
+    }
+
+    _hasResult = false;
+    return true;
+}
+
+void WebFunctionAxisControlCompare::discardResult() {
+    _hasResult = false;
+}
+
+/**
+Store the results of a simulated maneuver in user units
+
+:param offset: Index of the first result of the control law
+:param result: Simulated maneuver (counts and us)
+:param counts_per_unit: Conversion of the positions (counts/deg)
+*/
+void WebFunctionAxisControlCompare::storeResults(uint8_t offset, const pbio_simulation_result_t& result, float counts_per_unit) {
+    _results[offset] = result.settle_time < 0 ? -1.0f : result.settle_time / (float)US_PER_MS;
+    _results[offset + 1] = result.overshoot / counts_per_unit;
+    _results[offset + 2] = result.rms / counts_per_unit;
+    _results[offset + 3] = result.cycles / (float)getCpuFrequencyMhz();
+}
+
+WebFunctionExecutionStatus WebFunctionAxisControlCompare::start() {
+    WebFunction::start(); // Call the base class start to initialize failure description and IO board
+    if (_status == WebFunctionExecutionStatus::Failed) {
+        return _status;
+    }
+
+    _status = WebFunctionExecutionStatus::InProgress;
+    _hasResult = false;
+
+    // Run the simulations asynchronously, they take a few hundred milliseconds
+    _taskRunner.runAsync([](void* context) {
+        WebFunctionAxisControlCompare* self = static_cast<WebFunctionAxisControlCompare*>(context);
+        Motor& motor = self->_axis.motor1();
+
+        float speed = self->_axis.get_speed_limit();
+        float start = self->_axis.getSwLimitPlus();
+        float target = self->_axis.getSwLimitMinus();
+        float counts_per_unit = motor.get_counts_per_unit();
+
+        pbio_simulation_result_t pid, lqr;
+        pbio_error_t err = motor.simulate_run_target(false, speed, start, target, &pid);
+        if (err == PBIO_SUCCESS) {
+            err = motor.simulate_run_target(true, speed, start, target, &lqr);
+        }
+        if (err != PBIO_SUCCESS) {
+            Logger::instance().logE("Control law comparison of " + String(self->_axis.name()) + "-axis failed: " + String(pbio_error_str(err)));
+            self->_failureDescription = "Failed to simulate the move. Check the model and the travel";
+            self->_status = WebFunctionExecutionStatus::Failed;
+            return;
+        }
+
+        self->storeResults(0, pid, counts_per_unit);
+        self->storeResults(4, lqr, counts_per_unit);
+        motor.get_state_feedback_gains(-1, &self->_results[8], &self->_results[9], &self->_results[10]);
+
+        Logger::instance().logI("Control law comparison of " + String(self->_axis.name()) + "-axis: settling " +
+            String(self->_results[0], 0) + " ms with PID, " + String(self->_results[4], 0) + " ms with state feedback, update " +
+            String(self->_results[3], 1) + " us and " + String(self->_results[7], 1) + " us");
+
+        self->_hasResult = true;
+        self->_status = WebFunctionExecutionStatus::Done;
+    }, this);
+
+    return _status;
+}
+
+void WebFunctionAxisControlCompare::stop() {
+    // The simulations are short and not interruptible
+}
@@ -0,0 +1,299 @@
+#include "web_functions/axis/web_function_axis_ffcal.hpp"
+
+const char* WebFunctionAxisFeedforwardCal::getName() const {
+    return "axis_ffcal";
+}
+
+const char* WebFunctionAxisFeedforwardCal::getTitle() const {
+    return "Axis Feedforward Calibration";
+}
+
+const char* WebFunctionAxisFeedforwardCal::getDescription() const {
+    return "Sweep slowly the axis in both directions and build the table of the duty cycle needed to move through each position, to compensate gravity and friction";
+}
+
+uint16_t WebFunctionAxisFeedforwardCal::getPrerequisitesCount() const {
+    return 1;
+}
+
+const char* WebFunctionAxisFeedforwardCal::getPrerequisiteDescription(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "Axis must be homed";
+    default: return nullptr;
+    }
+}
+
+void WebFunctionAxisFeedforwardCal::arePrerequisitesMet(bool* results) const {
+    results[0] = _axis.referenced();
+}
+
+const char* WebFunctionAxisFeedforwardCal::getResultName(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "points";
+    case 1: return "hold_duty_min";
+    case 2: return "hold_duty_max";
+    case 3: return "friction_mean";
+    default: return nullptr;
+    }
+}
+
+const char* WebFunctionAxisFeedforwardCal::getResultUnit(uint16_t index) const {
+    switch (index)
+    {
+    case 1:
+    case 2:
+    case 3: return "%";
+    default: return "";
+    }
+}
+
+float WebFunctionAxisFeedforwardCal::getResultValue(uint16_t index) const {
+    if (index >= FFCAL_RESULTS_COUNT)
+        return 0.0f;
+
+    return _results[index];
+}
+
+bool WebFunctionAxisFeedforwardCal::saveResult() {
+    if (!_hasResult)
+        return false;
+
+    for (uint8_t m = 0; m < 2; m++) {
+        motor(m).set_ff_table(&_tables[m]);
+    }
+
+    _hasResult = false;
+    return true;
+}
+
+void WebFunctionAxisFeedforwardCal::discardResult() {
+    if (_hasResult) {
+        restoreTables();
+    }
+    _hasResult = false;
+}
+
+void WebFunctionAxisFeedforwardCal::restoreTables() {
+    for (uint8_t m = 0; m < 2; m++) {
+        motor(m).set_ff_table(&_oldTables[m]);
+    }
+}
+
+/**
+Moves the axis at constant speed to the target and accumulates the duty of both motors in the table points.
+
+:param target: End position of the sweep (deg)
+:param direction: Table direction, 0 positive and 1 negative
+:param start: Position of the first table point (deg)
+:param step: Distance between two table points (deg)
+:param motor2_offset: Position of motor 2 relative to motor 1 (deg)
+:return: nullptr on success, otherwise the failure description
+*/
+const char* WebFunctionAxisFeedforwardCal::sweep(float target, uint8_t direction, float start, float step, float motor2_offset, CancelToken& cancel_token) {
+    pbio_error_t err = _axis.run_target(FFCAL_SWEEP_SPEED, target, PBIO_ACTUATION_HOLD, false);
+    if (err != PBIO_SUCCESS) {
+        return "Failed to start the sweep";
+    }
+
+    float offsets[2] = { 0.0f, motor2_offset };
+    float speed_sign = direction == 0 ? 1.0f : -1.0f;
+    while (!_axis.motor1().is_completion()) {
+        IF_CANCELLED(cancel_token, {
+            return nullptr;
+        });
+
+        if (_axis.motor1().collision_detected()) {
+            return "The axis was blocked during the sweep";
+        }
+
+        // Use only the samples taken at constant speed, when the duty only depends on the position
+        if (fabsf(_axis.speed() - speed_sign * FFCAL_SWEEP_SPEED) < FFCAL_SPEED_TOLERANCE * FFCAL_SWEEP_SPEED) {
+            for (uint8_t m = 0; m < 2; m++) {
+                int32_t point = (int32_t)roundf((motor(m).angle() - offsets[m] - start) / step);
+                if (point >= 0 && point < PBIO_CONTROL_FF_TABLE_POINTS) {
+                    _dutySum[m][direction][point] += motor(m).duty();
+                    _samples[m][direction][point]++;
+                }
+            }
+        }
+
+        delay(PBIO_CONFIG_SERVO_PERIOD_MS);
+    }
+
+    return nullptr;
+}
+
+/**
+Builds the feedforward table of both motors from the sweep samples.
+
+The points not reached at constant speed, at the ends of the travel, take the value of
+the nearest calibrated point.
+
+:param start: Position of the first table point, referred to motor 1 (deg)
+:param step: Distance between two table points (deg)
+:param motor2_offset: Position of motor 2 relative to motor 1 (deg)
+:return: nullptr on success, otherwise the failure description
+*/
+const char* WebFunctionAxisFeedforwardCal::buildTables(float start, float step, float motor2_offset) {
+    float duty_scale = MOTOR_MAX_CONTROL / 100.0f;
+    float offsets[2] = { 0.0f, motor2_offset };
+
+    for (uint8_t m = 0; m < 2; m++) {
+        float counts_per_unit = motor(m).get_counts_per_unit();
+        pbio_control_ff_table_t* table = &_tables[m];
+        table->count_start = (int32_t)roundf((start + offsets[m]) * counts_per_unit);
+        table->count_step = (int32_t)roundf(step * counts_per_unit);
+
+        for (uint8_t d = 0; d < 2; d++) {
+            int16_t first = -1;
+            for (uint8_t i = 0; i < PBIO_CONTROL_FF_TABLE_POINTS; i++) {
+                if (_samples[m][d][i] > 0) {
+                    table->duty[d][i] = (int16_t)roundf(_dutySum[m][d][i] / _samples[m][d][i] * duty_scale);
+                    if (first < 0) {
+                        first = i;
+                    }
+                } else if (first >= 0) {
+                    table->duty[d][i] = table->duty[d][i - 1];
+                }
+            }
+            if (first < 0) {
+                return "The axis didn't move at constant speed. Check the mechanics or the speed limits";
+            }
+            for (uint8_t i = 0; i < first; i++) {
+                table->duty[d][i] = table->duty[d][first];
+            }
+        }
+    }
+
+    // Summarize the motor 1 table
+    uint16_t points = 0;
+    for (uint8_t i = 0; i < PBIO_CONTROL_FF_TABLE_POINTS; i++) {
+        if (_samples[0][0][i] > 0 && _samples[0][1][i] > 0) {
+            points++;
+        }
+    }
+    float hold_min = 100.0f;
+    float hold_max = -100.0f;
+    float friction = 0.0f;
+    for (uint8_t i = 0; i < PBIO_CONTROL_FF_TABLE_POINTS; i++) {
+        float hold = (_tables[0].duty[0][i] + _tables[0].duty[1][i]) / 2.0f / duty_scale;
+        hold_min = min(hold_min, hold);
+        hold_max = max(hold_max, hold);
+        friction += (_tables[0].duty[0][i] - _tables[0].duty[1][i]) / 2.0f / duty_scale;
+    }
+    _results[0] = points;
+    _results[1] = hold_min;
+    _results[2] = hold_max;
+    _results[3] = friction / PBIO_CONTROL_FF_TABLE_POINTS;
+
+    Logger::instance().logI("Feedforward calibration of " + String(_axis.name()) + "-axis: " + String(points) + " points, hold duty " +
+        String(hold_min, 1) + "% to " + String(hold_max, 1) + "%, friction " + String(_results[3], 1) + "%");
+    return nullptr;
+}
+
+WebFunctionExecutionStatus WebFunctionAxisFeedforwardCal::start() {
+    WebFunction::start(); // Call the base class start to initialize failure description and IO board
+    if (_status == WebFunctionExecutionStatus::Failed) {
+        return _status;
+    }
+
+    _status = WebFunctionExecutionStatus::InProgress;
+    if (_hasResult) {
+        restoreTables();
+    }
+    _hasResult = false;
+
+    // Run the calibration asynchronously
+    _taskRunner.runAsync([](void* context) {
+        WebFunctionAxisFeedforwardCal* self = static_cast<WebFunctionAxisFeedforwardCal*>(context);
+
+        // Create a cancel token for this operation
+        CancelToken cancel_token;
+        self->_cancelToken = &cancel_token;
+
+        float sw_limit_plus = self->_axis.getSwLimitPlus();
+        float sw_limit_minus = self->_axis.getSwLimitMinus();
+        float step = (sw_limit_plus - sw_limit_minus) / (PBIO_CONTROL_FF_TABLE_POINTS - 1);
+
+        // Measure without the current table, so the control offset is in use as before any calibration
+        pbio_control_ff_table_t empty_table = {};
+        for (uint8_t m = 0; m < 2; m++) {
+            self->motor(m).get_ff_table(&self->_oldTables[m]);
+            self->motor(m).set_ff_table(&empty_table);
+        }
+        memset(self->_dutySum, 0, sizeof(self->_dutySum));
+        memset(self->_samples, 0, sizeof(self->_samples));
+
+        // Move the axis at minus sw limit
+        pbio_error_t err = self->_axis.run_target(
+            self->_axis.get_speed_limit() / 4.0, // Use 1/4 of max speed
+            sw_limit_minus,
+            PBIO_ACTUATION_HOLD,
+            true,
+            &cancel_token);
+
+        IF_CANCELLED(cancel_token, {
+            self->restoreTables();
+            self->_status = WebFunctionExecutionStatus::Done;
+            self->_cancelToken = nullptr;
+            return;
+        });
+
+        const char* failure = nullptr;
+        if (err != PBIO_SUCCESS) {
+            Logger::instance().logE("Error during " + String(self->_axis.name()) + "-axis feedforward calibration: " + String(pbio_error_str(err)));
+            failure = "Failed to reach start position (sw limit -)";
+        }
+
+        // Sweep the travel in both directions
+        float motor2_offset = self->_axis.motor2().angle() - self->_axis.motor1().angle();
+        if (!failure) {
+            delay(FFCAL_SETTLE_TIME_MS);
+            failure = self->sweep(sw_limit_plus, 0, sw_limit_minus, step, motor2_offset, cancel_token);
+        }
+        if (!failure && !cancel_token.isCancelled()) {
+            delay(FFCAL_SETTLE_TIME_MS);
+            failure = self->sweep(sw_limit_minus, 1, sw_limit_minus, step, motor2_offset, cancel_token);
+        }
+
+        IF_CANCELLED(cancel_token, {
+            self->_axis.hold();
+            self->restoreTables();
+            self->_status = WebFunctionExecutionStatus::Done;
+            self->_cancelToken = nullptr;
+            return;
+        });
+
+        if (!failure) {
+            failure = self->buildTables(sw_limit_minus, step, motor2_offset);
+        }
+
+        if (failure) {
+            Logger::instance().logE("Feedforward calibration of " + String(self->_axis.name()) + "-axis failed: " + String(failure));
+            self->restoreTables();
+            self->_failureDescription = failure;
+            self->_status = WebFunctionExecutionStatus::Failed;
+            self->_cancelToken = nullptr;
+            return;
+        }
+
+        // Apply the new tables right away, so they can be checked before saving them
+        for (uint8_t m = 0; m < 2; m++) {
+            self->motor(m).set_ff_table(&self->_tables[m]);
+        }
+        self->_hasResult = true;
+
+        self->_status = WebFunctionExecutionStatus::Done;
+        self->_cancelToken = nullptr;
+    }, this);
+
+    return _status;
+}
+
+void WebFunctionAxisFeedforwardCal::stop() {
+    if (_cancelToken) {
+        _cancelToken->cancel();
+    }
+}
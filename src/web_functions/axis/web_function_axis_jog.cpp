@@ -61,7 +61,7 @@ WebFunctionExecutionStatus WebFunctionAxisJog::start() {
             // Jog the barrier up/down with the knob rotation
             if (knob_delta != 0) {
                 angle_setpoint += (float)knob_delta * self->barrier_config.jog_multiplier;
-                self->_motor.track_target(angle_setpoint);
+                self->_motor.track_target(angle_setpoint, true);
             }
 
             // Display current angle if changed
@@ -0,0 +1,348 @@
+#include "web_functions/axis/web_function_axis_profilecal.hpp"
+
+#define PROFILECAL_LOG_DURATION_MS (PROFILECAL_MAX_DRIVE_MS + PROFILECAL_MAX_STOP_MS)
+
+const char* WebFunctionAxisProfileCal::getName() const {
+    return "axis_profilecal";
+}
+
+const char* WebFunctionAxisProfileCal::getTitle() const {
+    return "Axis Raise/Lower Profile Calibration";
+}
+
+const char* WebFunctionAxisProfileCal::getDescription() const {
+    return "Drive the axis across the travel at the raising and lowering duty to measure its top speed and acceleration, "
+        "then make and run the fastest raise and lower profiles within these limits";
+}
+
+uint16_t WebFunctionAxisProfileCal::getPrerequisitesCount() const {
+    return 1;
+}
+
+const char* WebFunctionAxisProfileCal::getPrerequisiteDescription(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "Axis must be homed";
+    default: return nullptr;
+    }
+}
+
+void WebFunctionAxisProfileCal::arePrerequisitesMet(bool* results) const {
+    results[0] = _axis.referenced();
+}
+
+const char* WebFunctionAxisProfileCal::getResultName(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "raising_speed";
+    case 1: return "raising_accel";
+    case 2: return "lowering_speed";
+    case 3: return "lowering_accel";
+    case 4: return "raise_time_predicted";
+    case 5: return "raise_time";
+    case 6: return "lower_time_predicted";
+    case 7: return "lower_time";
+    case 8: return "raise_time_before";
+    default: return nullptr;
+    }
+}
+
+const char* WebFunctionAxisProfileCal::getResultUnit(uint16_t index) const {
+    switch (index)
+    {
+    case 0:
+    case 2: return "deg/s";
+    case 1:
+    case 3: return "deg/s^2";
+    case 4:
+    case 5:
+    case 6:
+    case 7:
+    case 8: return "s";
+    default: return "";
+    }
+}
+
+float WebFunctionAxisProfileCal::getResultValue(uint16_t index) const {
+    if (index >= PROFILECAL_RESULTS_COUNT)
+        return 0.0f;
+
+    return _results[index];
+}
+
+bool WebFunctionAxisProfileCal::saveResult() {
+    if (!_hasResult)
+        return false;
+
+    _barrierConfig.barrier_raise_speed = _results[0];
+    _barrierConfig.barrier_raise_acceleration = _results[1];
+    _barrierConfig.barrier_lower_speed = _results[2];
+    _barrierConfig.barrier_lower_acceleration = _results[3];
+
+    _hasResult = false;
+    return true;
+}
+
+void WebFunctionAxisProfileCal::discardResult() {
+    _hasResult = false;
+}
+
+/**
+Return the acceleration limit the servo applies in a direction of motion (deg/s^2)
+*/
+float WebFunctionAxisProfileCal::getAccelerationLimit(int8_t direction) {
+    if (direction < 0 && _axis.motor1().get_gain_scheduling()) {
+        uint16_t kp, ki, kd;
+        float acceleration, max_windup_factor;
+        _axis.motor1().get_gains_neg(&kp, &ki, &kd, &acceleration, &max_windup_factor);
+        return acceleration;
+    }
+    return _axis.get_acceleration_limit();
+}
+
+/**
+Drives the axis in open loop across the travel and measures its top speed and acceleration.
+
+The drive ends early enough for the servo to stop the axis at the end of the travel within the
+acceleration limit. The acceleration is the average one up to the speed used by the profiles, so
+a constant acceleration profile can follow it over the whole speed up.
+
+:param direction: Direction of motion, 1 to raise, -1 to lower
+:param duty: Open loop duty (%)
+:param measure: Return the measured capability
+:return: nullptr on success, otherwise the failure description
+*/
+const char* WebFunctionAxisProfileCal::measureDirection(int8_t direction, uint8_t duty, profilecal_measure_t* measure, CancelToken& cancel_token) {
+    float end = direction > 0 ? _axis.getSwLimitPlus() : _axis.getSwLimitMinus();
+    float acceleration_limit = getAccelerationLimit(direction);
+    float speed_tolerance, position_tolerance;
+    _axis.get_target_tolerances(&speed_tolerance, &position_tolerance);
+
+    PBIOLogger* logger = _axis.get_logger();
+    logger->start(PROFILECAL_LOG_DURATION_MS, 1);
+    _axis.dc(direction * (float)duty);
+
+    unsigned long start_time = millis();
+    while (true) {
+        IF_CANCELLED(cancel_token, {
+            _axis.hold();
+            logger->stop();
+            return nullptr;
+        });
+
+        float angle = _axis.angle();
+        float speed = _axis.speed();
+        if (direction * (angle - end) > 0) {
+            _axis.hold();
+            logger->stop();
+            return "The axis went out of the software limits. Check the acceleration limit of the axis";
+        }
+
+        // Leave the room to stop within the acceleration limit
+        float braking = speed * speed / (2.0f * acceleration_limit) * PROFILECAL_BRAKE_MARGIN;
+        if (direction * (end - angle) <= braking + PROFILECAL_END_MARGIN) {
+            break;
+        }
+
+        if ((millis() - start_time) > PROFILECAL_MAX_DRIVE_MS) {
+            _axis.hold();
+            logger->stop();
+            return "The axis didn't reach the end of the travel. Check the mechanics or increase the power";
+        }
+
+        delay(PBIO_CONFIG_SERVO_PERIOD_MS);
+    }
+
+    // The servo takes over from the current speed and stops at the end of the travel
+    _axis.track_target(end, true);
+    unsigned long stop_time = millis();
+    while (fabsf(_axis.speed()) > speed_tolerance || fabsf(_axis.angle() - end) > position_tolerance) {
+        if ((millis() - stop_time) > PROFILECAL_MAX_STOP_MS) {
+            logger->stop();
+            return "The axis didn't stop at the end of the travel";
+        }
+        delay(PBIO_CONFIG_SERVO_PERIOD_MS);
+    }
+    logger->stop();
+
+    // Row layout: time, maneuver time, count, rate, actuation type, duty
+    float counts_per_unit = _axis.get_counts_per_unit();
+    int32_t row[PBIO_MAX_LOG_VALUES + PBIO_NUM_DEFAULT_LOG_VALUES];
+    uint32_t rows = logger->rows();
+    int32_t top_rate = 0;
+    int32_t time_start = -1;
+    for (uint32_t i = 0; i < rows && logger->read(i, row) == PBIO_SUCCESS; i++) {
+        if (row[4] != PBIO_ACTUATION_DUTY) {
+            continue;
+        }
+        if (time_start < 0) {
+            time_start = row[0];
+        }
+        top_rate = PIO_MAX(top_rate, direction * row[3]);
+    }
+    if (time_start < 0 || top_rate <= 0) {
+        return "The open loop drive was not logged";
+    }
+
+    int32_t profile_rate = (int32_t)(top_rate * PROFILECAL_SPEED_MARGIN);
+    int32_t time_reach = -1;
+    for (uint32_t i = 0; i < rows && logger->read(i, row) == PBIO_SUCCESS; i++) {
+        if (row[4] == PBIO_ACTUATION_DUTY && direction * row[3] >= profile_rate) {
+            time_reach = row[0];
+            break;
+        }
+    }
+    if (time_reach <= time_start) {
+        return "The speed up was too short to measure the acceleration";
+    }
+
+    measure->top_speed = top_rate / counts_per_unit;
+    measure->acceleration = profile_rate / counts_per_unit / ((time_reach - time_start) / 1000.0f);
+    return nullptr;
+}
+
+/**
+Runs a raise or lower move with the given profile and measures its duration, until on target.
+
+:param actuation: Actuation limit during the move (%)
+:param time: Return the duration of the move (s)
+:return: nullptr on success, otherwise the failure description
+*/
+const char* WebFunctionAxisProfileCal::runProfile(float speed, float acceleration, float target, uint8_t actuation, float* time, CancelToken& cancel_token) {
+    uint8_t previous_actuation = (uint8_t)_axis.get_actuation_limit();
+    _axis.set_actuation_limit(actuation);
+    unsigned long start_time = millis();
+    pbio_error_t err = _axis.run_target_profile(speed, acceleration, target, PBIO_ACTUATION_HOLD, true, &cancel_token);
+    *time = (millis() - start_time) / 1000.0f;
+    _axis.set_actuation_limit(previous_actuation);
+
+    if (err != PBIO_SUCCESS) {
+        Logger::instance().logE("Error during " + String(_axis.name()) + "-axis profile move: " + String(pbio_error_str(err)));
+        return "The profile move failed";
+    }
+    return nullptr;
+}
+
+/**
+Return the duration of a trapezoidal move from standstill to standstill (s)
+*/
+static float profile_duration(float distance, float speed, float acceleration) {
+    if (distance >= speed * speed / acceleration) {
+        return distance / speed + speed / acceleration;
+    }
+    return 2.0f * sqrtf(distance / acceleration);
+}
+
+WebFunctionExecutionStatus WebFunctionAxisProfileCal::start() {
+    WebFunction::start(); // Call the base class start to initialize failure description and IO board
+    if (_status == WebFunctionExecutionStatus::Failed) {
+        return _status;
+    }
+
+    _status = WebFunctionExecutionStatus::InProgress;
+    _hasResult = false;
+
+    // Run the calibration asynchronously
+    _taskRunner.runAsync([](void* context) {
+        WebFunctionAxisProfileCal* self = static_cast<WebFunctionAxisProfileCal*>(context);
+
+        // Create a cancel token for this operation
+        CancelToken cancel_token;
+        self->_cancelToken = &cancel_token;
+
+        GantryMotor& axis = self->_axis;
+        const barrier_config_t& config = self->_barrierConfig;
+        float sw_limit_plus = axis.getSwLimitPlus();
+        float sw_limit_minus = axis.getSwLimitMinus();
+        uint8_t lower_actuation = (uint8_t)axis.get_actuation_limit();
+
+        // Move the axis at minus sw limit, the lowered position
+        pbio_error_t err = axis.run_target(
+            axis.get_speed_limit() / 4.0, // Use 1/4 of max speed
+            sw_limit_minus,
+            PBIO_ACTUATION_HOLD,
+            true,
+            &cancel_token);
+
+        IF_CANCELLED(cancel_token, {
+            self->_status = WebFunctionExecutionStatus::Done;
+            self->_cancelToken = nullptr;
+            return;
+        });
+
+        if (err != PBIO_SUCCESS) {
+            Logger::instance().logE("Error during " + String(axis.name()) + "-axis profile calibration: " + String(pbio_error_str(err)));
+            self->_failureDescription = "Failed to reach start position (sw limit -)";
+            self->_status = WebFunctionExecutionStatus::Failed;
+            self->_cancelToken = nullptr;
+            return;
+        }
+
+        delay(PROFILECAL_SETTLE_TIME_MS); // Let the axis settle
+
+        // Measure the capability when raising within the raising power, then when lowering
+        profilecal_measure_t raise, lower;
+        axis.set_actuation_limit(config.barrier_raise_power);
+        const char* failure = self->measureDirection(1, config.barrier_raise_power, &raise, cancel_token);
+        axis.set_actuation_limit(lower_actuation);
+        if (!failure && !cancel_token.isCancelled()) {
+            delay(PROFILECAL_SETTLE_TIME_MS);
+            failure = self->measureDirection(-1, lower_actuation, &lower, cancel_token);
+        }
+
+        // Profiles within the measured capability, with a margin, and within the limits of the axis
+        float speed_limit = axis.get_speed_limit();
+        float travel = sw_limit_plus - sw_limit_minus;
+        if (!failure && !cancel_token.isCancelled()) {
+            self->_results[0] = fminf(raise.top_speed * PROFILECAL_SPEED_MARGIN, speed_limit);
+            self->_results[1] = fminf(raise.acceleration * PROFILECAL_ACCEL_MARGIN, self->getAccelerationLimit(1));
+            self->_results[2] = fminf(lower.top_speed * PROFILECAL_SPEED_MARGIN, speed_limit);
+            self->_results[3] = fminf(lower.acceleration * PROFILECAL_ACCEL_MARGIN, self->getAccelerationLimit(-1));
+            self->_results[4] = profile_duration(travel, self->_results[0], self->_results[1]);
+            self->_results[6] = profile_duration(travel, self->_results[2], self->_results[3]);
+
+            // Raise with the current profile for reference, then lower and raise with the new ones
+            delay(PROFILECAL_SETTLE_TIME_MS);
+            failure = self->runProfile(config.barrier_raise_speed, config.barrier_raise_acceleration, sw_limit_plus, config.barrier_raise_power, &self->_results[8], cancel_token);
+        }
+        if (!failure && !cancel_token.isCancelled()) {
+            delay(PROFILECAL_SETTLE_TIME_MS);
+            failure = self->runProfile(self->_results[2], self->_results[3], sw_limit_minus, lower_actuation, &self->_results[7], cancel_token);
+        }
+        if (!failure && !cancel_token.isCancelled()) {
+            delay(PROFILECAL_SETTLE_TIME_MS);
+            failure = self->runProfile(self->_results[0], self->_results[1], sw_limit_plus, config.barrier_raise_power, &self->_results[5], cancel_token);
+        }
+
+        IF_CANCELLED(cancel_token, {
+            self->_status = WebFunctionExecutionStatus::Done;
+            self->_cancelToken = nullptr;
+            return;
+        });
+
+        if (failure) {
+            Logger::instance().logE("Profile calibration of " + String(axis.name()) + "-axis failed: " + String(failure));
+            self->_failureDescription = failure;
+            self->_status = WebFunctionExecutionStatus::Failed;
+            self->_cancelToken = nullptr;
+            return;
+        }
+
+        Logger::instance().logI("Profile calibration of " + String(axis.name()) + "-axis: raise " + String(self->_results[0], 0) + " deg/s " +
+            String(self->_results[1], 0) + " deg/s^2 in " + String(self->_results[5], 2) + "s (predicted " + String(self->_results[4], 2) +
+            "s, before " + String(self->_results[8], 2) + "s), lower " + String(self->_results[2], 0) + " deg/s " + String(self->_results[3], 0) +
+            " deg/s^2 in " + String(self->_results[7], 2) + "s (predicted " + String(self->_results[6], 2) + "s)");
+
+        self->_hasResult = true;
+        self->_status = WebFunctionExecutionStatus::Done;
+        self->_cancelToken = nullptr;
+    }, this);
+
+    return _status;
+}
+
+void WebFunctionAxisProfileCal::stop() {
+    if (_cancelToken) {
+        _cancelToken->cancel();
+    }
+}
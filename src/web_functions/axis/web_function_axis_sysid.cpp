@@ -0,0 +1,299 @@
+#include "web_functions/axis/web_function_axis_sysid.hpp"
+
+const char* WebFunctionAxisSysId::getName() const {
+    return "axis_sysid";
+}
+
+const char* WebFunctionAxisSysId::getTitle() const {
+    return "Axis System Identification";
+}
+
+const char* WebFunctionAxisSysId::getDescription() const {
+    return "Drive the axis with a pseudo random duty cycle around the middle of the travel and fit the speed model of the axis";
+}
+
+uint16_t WebFunctionAxisSysId::getPrerequisitesCount() const {
+    return 1;
+}
+
+const char* WebFunctionAxisSysId::getPrerequisiteDescription(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "Axis must be homed";
+    default: return nullptr;
+    }
+}
+
+void WebFunctionAxisSysId::arePrerequisitesMet(bool* results) const {
+    results[0] = _axis.referenced();
+}
+
+const char* WebFunctionAxisSysId::getResultName(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "gain_pos";
+    case 1: return "gain_neg";
+    case 2: return "time_constant_pos";
+    case 3: return "time_constant_neg";
+    case 4: return "coulomb";
+    case 5: return "viscous";
+    case 6: return "gravity";
+    default: return nullptr;
+    }
+}
+
+const char* WebFunctionAxisSysId::getResultUnit(uint16_t index) const {
+    switch (index)
+    {
+    case 0:
+    case 1: return "deg/s/%";
+    case 2:
+    case 3: return "s";
+    case 4: return "%";
+    case 5: return "%/(deg/s)";
+    case 6: return "%";
+    default: return "";
+    }
+}
+
+float WebFunctionAxisSysId::getResultValue(uint16_t index) const {
+    if (index >= SYSID_RESULTS_COUNT)
+        return 0.0f;
+
+    return _results[index];
+}
+
+bool WebFunctionAxisSysId::saveResult() {
+    if (!_hasResult)
+        return false;
+
+    Motor* motors[2] = { &_axis.motor1(), &_axis.motor2() };
+    for (uint8_t i = 0; i < 2; i++) {
+        motors[i]->set_model(
+            _results[0], _results[1], _results[2], _results[3],
+            _results[4], _results[5], _results[6]);
+    }
+
+    _hasResult = false;
+    return true;
+}
+
+void WebFunctionAxisSysId::discardResult() {
+    _hasResult = false;
+}
+
+/**
+Drives the axis in open loop with a pseudo random binary sequence around the holding duty cycle.
+
+The sequence comes from a 7 bit maximum length LFSR, so the excitation covers a wide band of
+frequencies. Near the ends of the travel the sign is forced to drive the axis back.
+
+:return: nullptr on success, otherwise the failure description
+*/
+const char* WebFunctionAxisSysId::runExcitation(CancelToken& cancel_token) {
+    // Measure the duty cycle needed to hold the axis in place
+    float bias = 0.0f;
+    const int32_t bias_samples = 50;
+    for (int32_t i = 0; i < bias_samples; i++) {
+        bias += _axis.motor1().duty();
+        delay(PBIO_CONFIG_SERVO_PERIOD_MS);
+    }
+    bias /= bias_samples;
+
+    float travel = _axis.getSwLimitPlus() - _axis.getSwLimitMinus();
+    float lower_bound = _axis.getSwLimitMinus() + travel * SYSID_TRAVEL_MARGIN;
+    float upper_bound = _axis.getSwLimitPlus() - travel * SYSID_TRAVEL_MARGIN;
+
+    uint8_t lfsr = 0x5A;
+    int8_t sign = 0;
+    unsigned long start_time = millis();
+    unsigned long bit_time = start_time - SYSID_PRBS_BIT_MS;
+    while ((millis() - start_time) < SYSID_EXCITATION_MS) {
+        IF_CANCELLED(cancel_token, {
+            return nullptr;
+        });
+
+        float angle = _axis.angle();
+        if (angle < _axis.getSwLimitMinus() || angle > _axis.getSwLimitPlus()) {
+            return "The axis went out of the software limits. Reduce the excitation or check the mechanics";
+        }
+
+        int8_t new_sign = sign;
+        unsigned long now = millis();
+        if ((now - bit_time) >= SYSID_PRBS_BIT_MS) {
+            // Next bit of the x^7 + x^6 + 1 sequence
+            uint8_t bit = ((lfsr >> 6) ^ (lfsr >> 5)) & 1;
+            lfsr = ((lfsr << 1) | bit) & 0x7F;
+            new_sign = bit ? 1 : -1;
+            bit_time = now;
+        }
+
+        if (angle > upper_bound) {
+            new_sign = -1;
+        } else if (angle < lower_bound) {
+            new_sign = 1;
+        }
+
+        if (new_sign != sign) {
+            sign = new_sign;
+            _axis.dc(bias + sign * SYSID_PRBS_DUTY);
+        }
+
+        delay(PBIO_CONFIG_SERVO_PERIOD_MS);
+    }
+
+    return nullptr;
+}
+
+/**
+Fits the speed model of both directions of motion from the logged excitation.
+
+Only pairs of consecutive samples driven in open loop and one servo period apart are used.
+
+:return: nullptr on success, otherwise the failure description
+*/
+const char* WebFunctionAxisSysId::fitModel() {
+    PBIOLogger* logger = _axis.get_logger();
+    float counts_per_unit = _axis.get_counts_per_unit();
+    int32_t min_rate = (int32_t)(SYSID_MIN_RATE * counts_per_unit);
+
+    pbio_identification_reset(&_idPos);
+    pbio_identification_reset(&_idNeg);
+
+    int32_t row[PBIO_MAX_LOG_VALUES + PBIO_NUM_DEFAULT_LOG_VALUES];
+    int32_t next[PBIO_MAX_LOG_VALUES + PBIO_NUM_DEFAULT_LOG_VALUES];
+    uint32_t rows = logger->rows();
+    if (rows < 2 || logger->read(0, next) != PBIO_SUCCESS) {
+        return "The excitation was not logged";
+    }
+
+    for (uint32_t i = 1; i < rows; i++) {
+        memcpy(row, next, sizeof(row));
+        if (logger->read(i, next) != PBIO_SUCCESS) {
+            break;
+        }
+
+        // Row layout: time, maneuver time, count, rate, actuation type, duty
+        if (row[4] != PBIO_ACTUATION_DUTY || next[4] != PBIO_ACTUATION_DUTY) {
+            continue;
+        }
+        if (abs(next[0] - row[0] - PBIO_CONFIG_SERVO_PERIOD_MS) > 1) {
+            continue;
+        }
+
+        if (row[3] > min_rate) {
+            pbio_identification_add_sample(&_idPos, row[3], row[5], next[3]);
+        } else if (row[3] < -min_rate) {
+            pbio_identification_add_sample(&_idNeg, row[3], row[5], next[3]);
+        }
+    }
+
+    pbio_control_model_t model;
+    pbio_error_t err = pbio_identification_make_model(&_idPos, &_idNeg, PBIO_CONFIG_SERVO_PERIOD_MS * US_PER_MS, &model);
+    if (err == PBIO_ERROR_INVALID_OP) {
+        return "Not enough samples in both directions of motion. Increase the excitation";
+    }
+    if (err != PBIO_SUCCESS) {
+        return "The model doesn't fit the logged data. Check the mechanics";
+    }
+
+    // Convert from counts and duty steps to user units and %
+    float duty_scale = MOTOR_MAX_CONTROL / 100.0f;
+    _results[0] = model.gain[0] * duty_scale / counts_per_unit;
+    _results[1] = model.gain[1] * duty_scale / counts_per_unit;
+    _results[2] = model.time_constant[0];
+    _results[3] = model.time_constant[1];
+    _results[4] = model.coulomb / duty_scale;
+    _results[5] = model.viscous * counts_per_unit / duty_scale;
+    _results[6] = model.gravity / duty_scale;
+
+    Logger::instance().logI("Identification of " + String(_axis.name()) + "-axis: K+=" + String(_results[0], 2) + " K-=" + String(_results[1], 2) +
+        " T+=" + String(_results[2], 3) + "s T-=" + String(_results[3], 3) + "s Fc=" + String(_results[4], 1) + "% G=" + String(_results[6], 1) + "%" +
+        " (" + String(_idPos.samples) + "/" + String(_idNeg.samples) + " samples)");
+    return nullptr;
+}
+
+WebFunctionExecutionStatus WebFunctionAxisSysId::start() {
+    WebFunction::start(); // Call the base class start to initialize failure description and IO board
+    if (_status == WebFunctionExecutionStatus::Failed) {
+        return _status;
+    }
+
+    _status = WebFunctionExecutionStatus::InProgress;
+    _hasResult = false;
+
+    // Run the identification asynchronously
+    _taskRunner.runAsync([](void* context) {
+        WebFunctionAxisSysId* self = static_cast<WebFunctionAxisSysId*>(context);
+
+        // Create a cancel token for this operation
+        CancelToken cancel_token;
+        self->_cancelToken = &cancel_token;
+
+        float center = (self->_axis.getSwLimitPlus() + self->_axis.getSwLimitMinus()) / 2.0f;
+
+        // Move the axis at the middle of the travel
+        pbio_error_t err = self->_axis.run_target(
+            self->_axis.get_speed_limit() / 4.0, // Use 1/4 of max speed
+            center,
+            PBIO_ACTUATION_HOLD,
+            true,
+            &cancel_token);
+
+        IF_CANCELLED(cancel_token, {
+            self->_status = WebFunctionExecutionStatus::Done;
+            self->_cancelToken = nullptr;
+            return;
+        });
+
+        if (err != PBIO_SUCCESS) {
+            Logger::instance().logE("Error during " + String(self->_axis.name()) + "-axis identification: " + String(pbio_error_str(err)));
+            self->_failureDescription = "Failed to reach the middle of the travel";
+            self->_status = WebFunctionExecutionStatus::Failed;
+            self->_cancelToken = nullptr;
+            return;
+        }
+
+        delay(SYSID_SETTLE_TIME_MS); // Let the axis settle
+
+        // The model is fitted from the log, that also allows to check the experiment afterwards
+        self->_axis.get_logger()->start(SYSID_LOG_DURATION_MS, 1);
+        const char* failure = self->runExcitation(cancel_token);
+        self->_axis.hold();
+        self->_axis.get_logger()->stop();
+
+        IF_CANCELLED(cancel_token, {
+            self->_status = WebFunctionExecutionStatus::Done;
+            self->_cancelToken = nullptr;
+            return;
+        });
+
+        if (!failure) {
+            failure = self->fitModel();
+        }
+
+        if (failure) {
+            Logger::instance().logE("Identification of " + String(self->_axis.name()) + "-axis failed: " + String(failure));
+            self->_failureDescription = failure;
+            self->_status = WebFunctionExecutionStatus::Failed;
+            self->_cancelToken = nullptr;
+            return;
+        }
+
+        self->_hasResult = true;
+
+        // Bring back the axis at the middle of the travel
+        self->_axis.run_target(self->_axis.get_speed_limit() / 4.0, center, PBIO_ACTUATION_HOLD, true, &cancel_token);
+
+        self->_status = WebFunctionExecutionStatus::Done;
+        self->_cancelToken = nullptr;
+    }, this);
+
+    return _status;
+}
+
+void WebFunctionAxisSysId::stop() {
+    if (_cancelToken) {
+        _cancelToken->cancel();
+    }
+}
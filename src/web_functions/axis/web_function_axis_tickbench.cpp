@@ -0,0 +1,188 @@
+#include "web_functions/axis/web_function_axis_tickbench.hpp"
+#include <LittleFS.h>
+#include <Preferences.h>
+
+// Load on the other core during each phase of the measure
+enum {
+    TICKBENCH_PHASE_IDLE,
+    TICKBENCH_PHASE_LITTLEFS,
+    TICKBENCH_PHASE_NVS,
+    TICKBENCH_PHASES_COUNT
+};
+
+static const char* const phase_names[TICKBENCH_PHASES_COUNT] = { "idle", "LittleFS writes", "NVS writes" };
+
+const char* WebFunctionAxisTickBench::getName() const {
+    return "axis_tickbench";
+}
+
+const char* WebFunctionAxisTickBench::getTitle() const {
+    return "Servo Update Benchmark";
+}
+
+const char* WebFunctionAxisTickBench::getDescription() const {
+    return "Measure the CPU cycles of the servo update while the axis holds its position, with no load, "
+        "while writing a file in LittleFS and while writing NVS keys. The IRAM placement saves the cache misses "
+        "caused by the other core, flash writes still park the motor task and can show in the maximum";
+}
+
+uint16_t WebFunctionAxisTickBench::getPrerequisitesCount() const {
+    return 1;
+}
+
+const char* WebFunctionAxisTickBench::getPrerequisiteDescription(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "Axis must be homed";
+    default: return nullptr;
+    }
+}
+
+void WebFunctionAxisTickBench::arePrerequisitesMet(bool* results) const {
+    results[0] = _axis.referenced();
+}
+
+const char* WebFunctionAxisTickBench::getResultName(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "idle_mean";
+    case 1: return "idle_max";
+    case 2: return "littlefs_mean";
+    case 3: return "littlefs_max";
+    case 4: return "nvs_mean";
+    case 5: return "nvs_max";
+    case 6: return "iram_in_use";
+    default: return nullptr;
+    }
+}
+
+const char* WebFunctionAxisTickBench::getResultUnit(uint16_t index) const {
+    return index < 6 ? "cycles" : "";
+}
+
+float WebFunctionAxisTickBench::getResultValue(uint16_t index) const {
+    if (index >= TICKBENCH_RESULTS_COUNT)
+        return 0.0f;
+
+    return _results[index];
+}
+
+bool WebFunctionAxisTickBench::saveResult() {
+    // The placement is selected at compile time, there is nothing to save
+    _hasResult = false;
+    return false;
+}
+
+void WebFunctionAxisTickBench::discardResult() {
+    _hasResult = false;
+}
+
+/**
+Measure the servo updates of the first motor of the axis while loading the flash from this task
+
+:param phase: Load to apply
+*/
+void WebFunctionAxisTickBench::measurePhase(uint8_t phase, CancelToken& cancel_token) {
+    Motor& motor = _axis.motor1();
+    uint32_t mean, max;
+    uint8_t* chunk = nullptr;
+    File file;
+    Preferences preferences;
+
+    if (phase == TICKBENCH_PHASE_LITTLEFS) {
+        chunk = (uint8_t*)malloc(TICKBENCH_FILE_CHUNK);
+        if (chunk) {
+            memset(chunk, 0x55, TICKBENCH_FILE_CHUNK);
+        }
+        file = LittleFS.open(TICKBENCH_FILE_PATH, "w");
+    }
+    else if (phase == TICKBENCH_PHASE_NVS) {
+        preferences.begin(TICKBENCH_NVS_NAMESPACE, false);
+    }
+
+    motor.get_update_cycles(&mean, &max, true);
+    unsigned long begin_time = millis();
+    uint32_t writes = 0;
+    size_t file_size = 0;
+    while (millis() - begin_time < TICKBENCH_PHASE_MS && !cancel_token.isCancelled()) {
+        if (phase == TICKBENCH_PHASE_LITTLEFS && chunk && file) {
+            file.write(chunk, TICKBENCH_FILE_CHUNK);
+            file.flush();
+            file_size += TICKBENCH_FILE_CHUNK;
+            if (file_size >= TICKBENCH_FILE_MAX) {
+                file.close();
+                file = LittleFS.open(TICKBENCH_FILE_PATH, "w");
+                file_size = 0;
+            }
+            writes++;
+        }
+        else if (phase == TICKBENCH_PHASE_NVS) {
+            // Each write appends an entry to the NVS page, erasing a page once in a while
+            preferences.putUInt("count", writes++);
+        }
+        delay(1); // Let the lower priority tasks of this core run
+    }
+    motor.get_update_cycles(&mean, &max, false);
+
+    if (phase == TICKBENCH_PHASE_LITTLEFS) {
+        if (file) {
+            file.close();
+        }
+        LittleFS.remove(TICKBENCH_FILE_PATH);
+        free(chunk);
+    }
+    else if (phase == TICKBENCH_PHASE_NVS) {
+        preferences.clear();
+        preferences.end();
+    }
+
+    _results[phase * 2] = mean;
+    _results[phase * 2 + 1] = max;
+    Logger::instance().logI("Servo update with " + String(phase_names[phase]) + ": " + String(mean) + " cycles mean, " +
+        String(max) + " cycles max, " + String(writes) + " writes");
+}
+
+WebFunctionExecutionStatus WebFunctionAxisTickBench::start() {
+    WebFunction::start(); // Call the base class start to initialize failure description and IO board
+    if (_status == WebFunctionExecutionStatus::Failed) {
+        return _status;
+    }
+
+    _status = WebFunctionExecutionStatus::InProgress;
+    _hasResult = false;
+
+    _taskRunner.runAsync([](void* context) {
+        WebFunctionAxisTickBench* self = static_cast<WebFunctionAxisTickBench*>(context);
+
+        // Create a cancel token for this operation
+        CancelToken cancel_token;
+        self->_cancelToken = &cancel_token;
+
+        // Hold the position, so every update runs the full control path
+        self->_axis.hold();
+        delay(TICKBENCH_SETTLE_TIME_MS);
+
+        for (uint8_t phase = 0; phase < TICKBENCH_PHASES_COUNT; phase++) {
+            self->measurePhase(phase, cancel_token);
+
+            IF_CANCELLED(cancel_token, {
+                self->_status = WebFunctionExecutionStatus::Done;
+                self->_cancelToken = nullptr;
+                return;
+            });
+        }
+        self->_results[6] = PBIO_CONFIG_SERVO_IRAM ? 1.0f : 0.0f;
+
+        self->_hasResult = true;
+        self->_status = WebFunctionExecutionStatus::Done;
+        self->_cancelToken = nullptr;
+    }, this);
+
+    return _status;
+}
+
+void WebFunctionAxisTickBench::stop() {
+    if (_cancelToken) {
+        _cancelToken->cancel();
+    }
+}
@@ -0,0 +1,105 @@
+#include "web_functions/axis/web_function_axis_trajbench.hpp"
+
+const char* WebFunctionAxisTrajectoryBench::getName() const {
+    return "axis_trajbench";
+}
+
+const char* WebFunctionAxisTrajectoryBench::getTitle() const {
+    return "Trajectory Evaluator Benchmark";
+}
+
+const char* WebFunctionAxisTrajectoryBench::getDescription() const {
+    return "Compare the float trajectory evaluator with the int64 one over the full range of a trajectory and its rebase, "
+        "and measure the CPU cycles of both. The axis doesn't move";
+}
+
+uint16_t WebFunctionAxisTrajectoryBench::getPrerequisitesCount() const {
+    return 0;
+}
+
+const char* WebFunctionAxisTrajectoryBench::getPrerequisiteDescription(uint16_t index) const {
+    return nullptr;
+}
+
+void WebFunctionAxisTrajectoryBench::arePrerequisitesMet(bool* results) const {
+}
+
+const char* WebFunctionAxisTrajectoryBench::getResultName(uint16_t index) const {
+    switch (index)
+    {
+    case 0: return "position_error";
+    case 1: return "speed_error";
+    case 2: return "rebase_error";
+    case 3: return "cycles_int64";
+    case 4: return "cycles_float";
+    case 5: return "float_in_use";
+    default: return nullptr;
+    }
+}
+
+const char* WebFunctionAxisTrajectoryBench::getResultUnit(uint16_t index) const {
+    switch (index)
+    {
+    case 0:
+    case 2: return "mcount";
+    case 1: return "count/s";
+    case 3:
+    case 4: return "cycles";
+    default: return "";
+    }
+}
+
+float WebFunctionAxisTrajectoryBench::getResultValue(uint16_t index) const {
+    if (index >= TRAJBENCH_RESULTS_COUNT)
+        return 0.0f;
+
+    return _results[index];
+}
+
+bool WebFunctionAxisTrajectoryBench::saveResult() {
+    // The evaluator is selected at compile time, there is nothing to save
+    _hasResult = false;
+    return false;
+}
+
+void WebFunctionAxisTrajectoryBench::discardResult() {
+    _hasResult = false;
+}
+
+WebFunctionExecutionStatus WebFunctionAxisTrajectoryBench::start() {
+    WebFunction::start(); // Call the base class start to initialize failure description and IO board
+    if (_status == WebFunctionExecutionStatus::Failed) {
+        return _status;
+    }
+
+    _status = WebFunctionExecutionStatus::InProgress;
+    _hasResult = false;
+
+    // Run the benchmark asynchronously, it takes a few hundred milliseconds
+    _taskRunner.runAsync([](void* context) {
+        WebFunctionAxisTrajectoryBench* self = static_cast<WebFunctionAxisTrajectoryBench*>(context);
+
+        pbio_benchmark_result_t result;
+        pbio_benchmark_trajectory(&result);
+
+        self->_results[0] = result.position_error;
+        self->_results[1] = result.rate_error;
+        self->_results[2] = result.rebase_error;
+        self->_results[3] = result.cycles_int64;
+        self->_results[4] = result.cycles_float;
+        self->_results[5] = PBIO_CONFIG_TRAJECTORY_FLOAT ? 1.0f : 0.0f;
+
+        Logger::instance().logI("Trajectory evaluators: " + String(result.cycles_int64) + " cycles with int64, " +
+            String(result.cycles_float) + " cycles with float, position difference up to " + String(result.position_error) +
+            " mcount, " + String(result.rebase_error) + " mcount across the rebase");
+
+        self->_hasResult = true;
+        self->_status = WebFunctionExecutionStatus::Done;
+    }, this);
+
+    return _status;
+}
+
+void WebFunctionAxisTrajectoryBench::stop() {
+    // The benchmark is short and not interruptible
+}